@@ -10,9 +10,14 @@
 #include <zen/file_access.h>
 #include <zen/dir_watcher.h>
 #include <zen/thread.h>
+#include <zen/crc.h>
+#include <zen/guid.h>
+#include <zen/stl_tools.h>
 //#include <zen/tick_count.h>
 #include <wx/utils.h>
 #include "../lib/resolve_path.h"
+#include "../lib/change_list.h"
+#include "../lib/ffs_paths.h"
 //#include "../library/db_file.h"     //SYNC_DB_FILE_ENDING -> complete file too much of a dependency; file ending too little to decouple into single header
 //#include "../library/lock_holder.h" //LOCK_FILE_ENDING
 //TEMP_FILE_ENDING
@@ -43,6 +48,66 @@ std::vector<Zstring> getFormattedDirs(const std::vector<Zstring>& folderPathPhra
 }
 
 
+//record *all* changes between two command executions, including those made while the command is running: see lib/change_list.h
+class ChangeRecorder
+{
+public:
+    ChangeRecorder() : changeListPath_(getConfigDir() + Zstr("RealTimeSync-") + numberTo<Zstring>(getCrc32(sessionId_.begin(), sessionId_.end())) + Zstr(".ffs_changes")) {}
+
+    ~ChangeRecorder()
+    {
+        try { removeFile(changeListPath_); /*throw FileError*/ }
+        catch (FileError&) {}
+    }
+
+    void onWatchesInstalled(const std::vector<Zstring>& folderPaths) //changes in between went unrecorded
+    {
+        monitoredFolders_ = folderPaths;
+        complete_ = false;
+    }
+
+    void addChanges(const std::vector<DirWatcher::Entry>& changes)
+    {
+        if (changes_.size() + changes.size() > MAX_RECORDED_CHANGES) //FreeFileSync will check all folders anyway
+        {
+            changes_.clear();
+            complete_ = false;
+        }
+        else
+            append(changes_, changes);
+    }
+
+    //write changes recorded so far and start recording the next change list
+    Zstring writeChangeList() //throw FileError
+    {
+        ChangeList changeList;
+        changeList.pos.sessionId  = sessionId_;
+        changeList.pos.sequenceNo = sequenceNo_++;
+        changeList.complete = complete_;
+        changeList.monitoredFolders = monitoredFolders_;
+        changeList.changes.swap(changes_);
+
+        complete_ = true; //until watches need to be (re-)installed
+
+        saveChangeList(changeListPath_, changeList); //throw FileError
+        return changeListPath_;
+    }
+
+private:
+    static const size_t MAX_RECORDED_CHANGES = 100000;
+
+    const std::string sessionId_ = generateGUID();
+    const Zstring changeListPath_;
+    std::uint64_t sequenceNo_ = 0;
+    bool complete_ = false;
+    std::vector<Zstring> monitoredFolders_;
+    std::vector<DirWatcher::Entry> changes_;
+};
+
+
+using FolderWatches = std::vector<std::pair<Zstring, std::shared_ptr<DirWatcher>>>;
+
+
 //wait until changes are detected or if a directory is not available (anymore)
 struct WaitResult
 {
@@ -61,36 +126,56 @@ struct WaitResult
 };
 
 
+bool isIgnoredChange(const DirWatcher::Entry& e)
+{
+    return
+#ifdef ZEN_MAC
+        pathEndsWith(e.filepath_, Zstr("/.DS_Store")) ||
+#endif
+        //pathEndsWith(e.filepath_, Zstr(".ffs_tmp"))  ||
+        pathEndsWith(e.filepath_, Zstr(".ffs_lock")) || //sync.ffs_lock, sync.Del.ffs_lock
+        pathEndsWith(e.filepath_, Zstr(".ffs_db"));     //sync.ffs_db, .sync.tmp.ffs_db
+    //no need to ignore temporal recycle bin directory: this must be caused by a file deletion anyway
+}
+
+
 WaitResult waitForChanges(const std::vector<Zstring>& folderPathPhrases, //throw FileError
+                          FolderWatches& watches, //in/out: kept between calls; empty: (re-)install watches
+                          ChangeRecorder& recorder,
                           const std::function<void(bool readyForSync)>& onRefreshGui)
 {
-    const std::vector<Zstring> folderPathsFmt = getFormattedDirs(folderPathPhrases); //throw FileError
-    if (folderPathsFmt.empty()) //pathological case, but we have to check else this function will wait endlessly
-        throw FileError(_("A folder input field is empty.")); //should have been checked by caller!
+    if (watches.empty())
+    {
+        const std::vector<Zstring> folderPathsFmt = getFormattedDirs(folderPathPhrases); //throw FileError
+        if (folderPathsFmt.empty()) //pathological case, but we have to check else this function will wait endlessly
+            throw FileError(_("A folder input field is empty.")); //should have been checked by caller!
 
-    //detect when volumes are removed/are not available anymore
-    std::vector<std::pair<Zstring, std::shared_ptr<DirWatcher>>> watches;
+        //detect when volumes are removed/are not available anymore
+        FolderWatches watchesNew;
 
-    for (const Zstring& folderPathFmt : folderPathsFmt)
-    {
-        try
+        for (const Zstring& folderPathFmt : folderPathsFmt)
         {
-            //a non-existent network path may block, so check existence asynchronously!
-            auto ftDirExists = runAsync([=] { return zen::dirExists(folderPathFmt); });
-            //we need to check dirExists(), not somethingExists(): it's not clear if DirWatcher detects a type clash (file instead of directory!)
-            while (ftDirExists.wait_for(std::chrono::milliseconds(rts::UI_UPDATE_INTERVAL / 2)) != std::future_status::ready)
-                onRefreshGui(false /*readyForSync*/); //may throw!
-            if (!ftDirExists.get())
-                return WaitResult(folderPathFmt);
-
-            watches.emplace_back(folderPathFmt, std::make_shared<DirWatcher>(folderPathFmt)); //throw FileError
-        }
-        catch (FileError&)
-        {
-            if (!somethingExists(folderPathFmt)) //a benign(?) race condition with FileError
-                return WaitResult(folderPathFmt);
-            throw;
+            try
+            {
+                //a non-existent network path may block, so check existence asynchronously!
+                auto ftDirExists = runAsync([=] { return zen::dirExists(folderPathFmt); });
+                //we need to check dirExists(), not somethingExists(): it's not clear if DirWatcher detects a type clash (file instead of directory!)
+                while (ftDirExists.wait_for(std::chrono::milliseconds(rts::UI_UPDATE_INTERVAL / 2)) != std::future_status::ready)
+                    onRefreshGui(false /*readyForSync*/); //may throw!
+                if (!ftDirExists.get())
+                    return WaitResult(folderPathFmt);
+
+                watchesNew.emplace_back(folderPathFmt, std::make_shared<DirWatcher>(folderPathFmt)); //throw FileError
+            }
+            catch (FileError&)
+            {
+                if (!somethingExists(folderPathFmt)) //a benign(?) race condition with FileError
+                    return WaitResult(folderPathFmt);
+                throw;
+            }
         }
+        watches.swap(watchesNew);
+        recorder.onWatchesInstalled(folderPathsFmt);
     }
 
     auto lastCheck = std::chrono::steady_clock::now();
@@ -110,35 +195,30 @@ WaitResult waitForChanges(const std::vector<Zstring>& folderPathPhrases, //throw
 
         for (auto it = watches.begin(); it != watches.end(); ++it)
         {
-            const Zstring& folderPath = it->first;
+            const Zstring folderPath = it->first;
             DirWatcher& watcher = *(it->second);
 
             //IMPORTANT CHECK: dirwatcher has problems detecting removal of top watched directories!
             if (checkDirExistNow)
                 if (!dirExists(folderPath)) //catch errors related to directory removal, e.g. ERROR_NETNAME_DELETED -> somethingExists() is NOT sufficient here!
+                {
+                    watches.clear();
                     return WaitResult(folderPath);
+                }
             try
             {
                 std::vector<DirWatcher::Entry> changedItems = watcher.getChanges([&] { onRefreshGui(false /*readyForSync*/); /*may throw!*/ }); //throw FileError
+                recorder.addChanges(changedItems); //FreeFileSync needs to know about ignored changes, too
 
                 //remove to be ignored changes
-                erase_if(changedItems, [](const DirWatcher::Entry& e)
-                {
-                    return
-#ifdef ZEN_MAC
-                        pathEndsWith(e.filepath_, Zstr("/.DS_Store")) ||
-#endif
-                        //pathEndsWith(e.filepath_, Zstr(".ffs_tmp"))  ||
-                        pathEndsWith(e.filepath_, Zstr(".ffs_lock")) || //sync.ffs_lock, sync.Del.ffs_lock
-                        pathEndsWith(e.filepath_, Zstr(".ffs_db"));     //sync.ffs_db, .sync.tmp.ffs_db
-                    //no need to ignore temporal recycle bin directory: this must be caused by a file deletion anyway
-                });
+                erase_if(changedItems, isIgnoredChange);
 
                 if (!changedItems.empty())
                     return WaitResult(changedItems[0]); //directory change detected
             }
             catch (FileError&)
             {
+                watches.clear();
                 if (!somethingExists(folderPath)) //a benign(?) race condition with FileError
                     return WaitResult(folderPath);
                 throw;
@@ -224,8 +304,13 @@ void rts::monitorDirectories(const std::vector<Zstring>& folderPathPhrases, unsi
         return;
     }
 
+    FolderWatches watches; //keep watching while the command is running
+    ChangeRecorder recorder;
+
     auto execMonitoring = [&] //throw FileError
     {
+        watches.clear(); //e.g. after error: (re-)install watches
+
         callback.setPhase(MonitorCallback::MONITOR_PHASE_WAITING);
         waitForMissingDirs(folderPathPhrases, [&](const Zstring& folderPath) { callback.requestUiRefresh(); }); //throw FileError
         callback.setPhase(MonitorCallback::MONITOR_PHASE_ACTIVE);
@@ -241,7 +326,7 @@ void rts::monitorDirectories(const std::vector<Zstring>& folderPathPhrases, unsi
                 for (;;) //loop over detected changes
                 {
                     //wait for changes (and for all directories to become available)
-                    WaitResult res = waitForChanges(folderPathPhrases, [&](bool readyForSync) //throw FileError, ExecCommandNowException
+                    WaitResult res = waitForChanges(folderPathPhrases, watches, recorder, [&](bool readyForSync) //throw FileError, ExecCommandNowException
                     {
                         if (readyForSync)
                             if (nextExecDate <= std::time(nullptr))
@@ -267,10 +352,19 @@ void rts::monitorDirectories(const std::vector<Zstring>& folderPathPhrases, unsi
 
             ::wxSetEnv(L"change_path", utfCvrtTo<wxString>(lastChangeDetected.filepath_)); //some way to output what file changed to the user
             ::wxSetEnv(L"change_action", toString(lastChangeDetected.action_)); //
+            try
+            {
+                ::wxSetEnv(CHANGE_LIST_ENV_VAR, utfCvrtTo<wxString>(recorder.writeChangeList())); //throw FileError
+            }
+            catch (FileError&) { ::wxUnsetEnv(CHANGE_LIST_ENV_VAR); } //not critical: FreeFileSync checks all folders
 
             //execute command
             callback.executeExternalCommand();
             nextExecDate = std::numeric_limits<time_t>::max();
+
+            //record changes made while the command was running (e.g. by the FreeFileSync sync itself) for the next change list without triggering a new execution
+            for (auto& item : watches)
+                recorder.addChanges(item.second->getChanges([&] { callback.requestUiRefresh(); })); //throw FileError
         }
     };
 
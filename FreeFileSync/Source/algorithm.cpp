@@ -1203,7 +1203,7 @@ void copyToAlternateFolderFrom(const std::vector<const FileSystemObject*>& rowsT
 
             auto onNotifyCopyStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
             AFS::copyFileTransactional(file.getAbstractPath<side>(), targetPath, //throw FileError, ErrorFileLocked
-                                       false /*copyFilePermissions*/, true /*transactionalCopy*/, deleteTargetItem, onNotifyCopyStatus);
+                                       false /*copyFilePermissions*/, true /*transactionalCopy*/, false /*cloneIfPossible*/, false /*deltaCopy*/, deleteTargetItem, onNotifyCopyStatus);
             statReporter.reportDelta(1, 0);
 
             statReporter.reportFinished();
@@ -1620,7 +1620,7 @@ void TempFileBuffer::createTempFiles(const std::set<FileDetails>& workLoad, Proc
 
             auto onNotifyCopyStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
             AFS::copyFileTransactional(details.path, createItemPathNative(tempFilePath), //throw FileError, ErrorFileLocked
-                                       false /*copyFilePermissions*/, true /*transactionalCopy*/, nullptr /*onDeleteTargetFile*/, onNotifyCopyStatus);
+                                       false /*copyFilePermissions*/, true /*transactionalCopy*/, false /*cloneIfPossible*/, false /*deltaCopy*/, nullptr /*onDeleteTargetFile*/, onNotifyCopyStatus);
 #ifdef ZEN_WIN
             ::SetFileAttributes(applyLongPathPrefix(tempFilePath).c_str(), FILE_ATTRIBUTE_READONLY); //try to... => user get's a warning within 3rd-party apps
 #endif
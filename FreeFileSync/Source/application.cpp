@@ -605,6 +605,7 @@ void runBatchMode(const Zstring& globalConfigFile, const XmlBatchConfig& batchCf
                                          batchCfg.logFolderPathPhrase,
                                          batchCfg.logfilesCountLimit,
                                          globalCfg.lastSyncsLogFileSizeMax,
+                                         globalCfg.logMemoryLimit,
                                          batchCfg.handleError,
                                          globalCfg.automaticRetryCount,
                                          globalCfg.automaticRetryDelay,
@@ -628,6 +629,16 @@ void runBatchMode(const Zstring& globalConfigFile, const XmlBatchConfig& batchCf
                 break;
         }
 
+        //RealTimeSync passes the changes that triggered this run: lets the scan snapshot skip checking unchanged folders
+        std::unique_ptr<ChangeList> changeList;
+        wxString changeListPath;
+        if (globalCfg.scanSnapshot && wxGetEnv(CHANGE_LIST_ENV_VAR, &changeListPath) && !changeListPath.empty())
+            try
+            {
+                changeList = std::make_unique<ChangeList>(loadChangeList(toZ(changeListPath))); //throw FileError
+            }
+            catch (const FileError& e) { statusHandler.reportInfo(e.toString()); } //not critical: check all folders
+
         //batch mode: place directory locks on directories during both comparison AND synchronization
         std::unique_ptr<LockHolder> dirLocks;
 
@@ -637,6 +648,11 @@ void runBatchMode(const Zstring& globalConfigFile, const XmlBatchConfig& batchCf
                                              allowPwPrompt, //allowUserInteraction
                                              globalCfg.runWithBackgroundPriority,
                                              globalCfg.folderAccessTimeout,
+                                             globalCfg.scanThreadsPerDevice,
+                                             globalCfg.scanSnapshot,
+                                             changeList.get(),
+                                             globalCfg.compareThreadsPerDevice,
+                                             globalCfg.reuseContentComparison,
                                              globalCfg.createLockFile,
                                              dirLocks,
                                              cmpConfig,
@@ -653,6 +669,13 @@ void runBatchMode(const Zstring& globalConfigFile, const XmlBatchConfig& batchCf
                     globalCfg.copyLockedFiles,
                     globalCfg.copyFilePermissions,
                     globalCfg.failSafeFileCopy,
+                    globalCfg.cloneFiles,
+                    globalCfg.deltaCopy,
+                    globalCfg.scanSnapshot,
+                    globalCfg.syncThreadsPerFolderPair,
+                    globalCfg.syncThreadsTotal,
+                    globalCfg.versionCountLimit,
+                    globalCfg.versionMaxAgeDays,
                     globalCfg.runWithBackgroundPriority,
                     globalCfg.folderAccessTimeout,
                     syncProcessCfg,
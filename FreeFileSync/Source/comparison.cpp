@@ -5,12 +5,14 @@
 // *****************************************************************************
 
 #include "comparison.h"
+#include <unordered_map>
 #include <zen/process_priority.h>
 #include <zen/perf.h>
 #include "algorithm.h"
 #include "lib/parallel_scan.h"
+#include "lib/parallel_compare.h"
+#include "lib/db_file.h"
 #include "lib/dir_exist_async.h"
-#include "lib/binary.h"
 #include "lib/cmp_filetime.h"
 #include "lib/status_handler_impl.h"
 #include "fs/concrete.h"
@@ -163,7 +165,8 @@ void checkFolderDependency(const std::vector<ResolvedFolderPair>& folderPairs, b
 class ComparisonBuffer
 {
 public:
-    ComparisonBuffer(const std::set<DirectoryKey>& keysToRead, int fileTimeTolerance, ProcessCallback& callback);
+    ComparisonBuffer(const std::set<DirectoryKey>& keysToRead, size_t scanThreadsPerDevice, bool useScanSnapshot, const ChangeList* changeList, size_t compareThreadsPerDevice,
+                     bool reuseContentComparison, int fileTimeTolerance, ProcessCallback& callback);
 
     //create comparison result table and fill category except for files existing on both sides: undefinedFiles and undefinedSymlinks are appended!
     std::shared_ptr<BaseFolderPair> compareByTimeSize(const ResolvedFolderPair& fp, const FolderPairCfg& fpConfig) const;
@@ -180,13 +183,16 @@ private:
                                                       std::vector<SymlinkPair*>& undefinedSymlinks) const;
 
     std::map<DirectoryKey, DirectoryValue> directoryBuffer; //contains only *existing* directories
+    const size_t compareThreadsPerDevice_;
+    const bool reuseContentComparison_;
     const int fileTimeTolerance_;
     ProcessCallback& callback_;
 };
 
 
-ComparisonBuffer::ComparisonBuffer(const std::set<DirectoryKey>& keysToRead, int fileTimeTolerance, ProcessCallback& callback) :
-    fileTimeTolerance_(fileTimeTolerance), callback_(callback)
+ComparisonBuffer::ComparisonBuffer(const std::set<DirectoryKey>& keysToRead, size_t scanThreadsPerDevice, bool useScanSnapshot, const ChangeList* changeList, size_t compareThreadsPerDevice,
+                                   bool reuseContentComparison, int fileTimeTolerance, ProcessCallback& callback) :
+    compareThreadsPerDevice_(compareThreadsPerDevice), reuseContentComparison_(reuseContentComparison), fileTimeTolerance_(fileTimeTolerance), callback_(callback)
 {
     class CbImpl : public FillBufferCallback
     {
@@ -224,6 +230,9 @@ ComparisonBuffer::ComparisonBuffer(const std::set<DirectoryKey>& keysToRead, int
 
     fillBuffer(keysToRead, //in
                directoryBuffer, //out
+               scanThreadsPerDevice,
+               useScanSnapshot,
+               changeList,
                cb,
                UI_UPDATE_INTERVAL / 2); //every ~50 ms
 }
@@ -414,6 +423,64 @@ void categorizeSymlinkByContent(SymlinkPair& symlink, ProcessCallback& callback)
 }
 
 
+//files found equal by content during last sync and unchanged since (same size, modification time and file id on both sides) need not be read again
+class LastContentComparison
+{
+public:
+    LastContentComparison(const BaseFolderPair& baseFolder, const InSyncFolder& dbRoot) { dbFolders.emplace(&baseFolder, &dbRoot); }
+
+    bool stillEqual(const FilePair& file)
+    {
+        const InSyncFolder* dbFolder = getDbFolder(file.parent());
+        if (!dbFolder)
+            return false;
+
+        auto it = dbFolder->files.find(file.getPairItemName());
+        if (it == dbFolder->files.end())
+            return false;
+        const InSyncFile& dbFile = it->second;
+
+        return dbFile.cmpVar == CompareVariant::CONTENT && //a "compare by time and size" result says nothing about content!
+               //FILE_EQUAL may only be set if short names match in case: see db_file.cpp
+               it->first == file.getItemName< LEFT_SIDE>() &&
+               it->first == file.getItemName<RIGHT_SIDE>() &&
+               dbFile.fileSize == file.getFileSize<LEFT_SIDE>() && //caller ensures identical file sizes on both sides
+               unchanged(dbFile.left,  file.getLastWriteTime< LEFT_SIDE>(), file.getFileId< LEFT_SIDE>()) &&
+               unchanged(dbFile.right, file.getLastWriteTime<RIGHT_SIDE>(), file.getFileId<RIGHT_SIDE>());
+    }
+
+private:
+    //no file time tolerance: any deviation means the file was touched since
+    static bool unchanged(const InSyncDescrFile& descr, std::int64_t lastWriteTime, const AFS::FileId& fileId)
+    {
+        return descr.lastWriteTimeRaw == lastWriteTime &&
+               !fileId.empty() && descr.fileId == fileId; //no file id => no proof the file wasn't replaced
+    }
+
+    const InSyncFolder* getDbFolder(const HierarchyObject& hierObj)
+    {
+        auto it = dbFolders.find(&hierObj);
+        if (it != dbFolders.end())
+            return it->second;
+
+        //base folder is always cached => hierObj must be a FolderPair
+        const FolderPair& folder = static_cast<const FolderPair&>(hierObj);
+
+        const InSyncFolder* dbFolder = nullptr;
+        if (const InSyncFolder* dbParent = getDbFolder(folder.parent()))
+        {
+            auto itSub = dbParent->folders.find(folder.getPairItemName());
+            if (itSub != dbParent->folders.end())
+                dbFolder = &itSub->second;
+        }
+        dbFolders.emplace(&hierObj, dbFolder);
+        return dbFolder;
+    }
+
+    std::unordered_map<const HierarchyObject*, const InSyncFolder*> dbFolders; //nullptr if not in database
+};
+
+
 std::shared_ptr<BaseFolderPair> ComparisonBuffer::compareBySize(const ResolvedFolderPair& fp, const FolderPairCfg& fpConfig) const
 {
     //do basis scan and retrieve files existing on both sides as "compareCandidates"
@@ -455,16 +522,39 @@ std::list<std::shared_ptr<BaseFolderPair>> ComparisonBuffer::compareByContent(co
 
     //PERF_START;
     std::vector<FilePair*> filesToCompareBytewise;
+    std::vector<BinaryCompareTask> compareTasks;
+    DeviceCatalog devCatalog;
 
     //process folder pairs one after another
     for (const auto& w : workLoad)
     {
+        const size_t deviceL = devCatalog.getDeviceIndex(w.first.folderPathLeft);
+        const size_t deviceR = devCatalog.getDeviceIndex(w.first.folderPathRight);
+
         std::vector<FilePair*> undefinedFiles;
         std::vector<SymlinkPair*> uncategorizedLinks;
         //do basis scan and retrieve candidates for binary comparison (files existing on both sides)
 
         output.push_back(performComparison(w.first, w.second, undefinedFiles, uncategorizedLinks));
 
+        //consult sync.ffs_db only if there is something to gain: it is loaded again later in redetermineSyncDirection()
+        const bool haveContentCandidates = std::any_of(undefinedFiles.begin(), undefinedFiles.end(), [](const FilePair* file)
+        {
+            return file->isActive() && file->getFileSize<LEFT_SIDE>() == file->getFileSize<RIGHT_SIDE>();
+        });
+
+        std::shared_ptr<InSyncFolder> lastSyncState;
+        if (reuseContentComparison_ && haveContentCandidates)
+            try
+            {
+                lastSyncState = loadLastSynchronousState(*output.back(), nullptr); //throw FileError, FileErrorDatabaseNotExisting
+            }
+            catch (FileError&) {} //no database or an incompatible one: just compare content; errors are reported when setting sync directions
+
+        std::unique_ptr<LastContentComparison> lastCmp;
+        if (lastSyncState)
+            lastCmp = std::make_unique<LastContentComparison>(*output.back(), *lastSyncState);
+
         //content comparison of file content happens AFTER finding corresponding files and AFTER filtering
         //in order to separate into two processes (scanning and comparing)
         for (FilePair* file : undefinedFiles)
@@ -477,8 +567,14 @@ std::list<std::shared_ptr<BaseFolderPair>> ComparisonBuffer::compareByContent(co
                 //both soft and hard filter were already applied in ComparisonBuffer::performComparison()!
                 if (!file->isActive())
                     file->setCategoryConflict(getConflictSkippedBinaryComparison(*file));
+                else if (lastCmp && lastCmp->stillEqual(*file))
+                    file->setCategory<FILE_EQUAL>();
                 else
+                {
                     filesToCompareBytewise.push_back(file);
+                    compareTasks.push_back({ file->getAbstractPath<LEFT_SIDE>(), file->getAbstractPath<RIGHT_SIDE>(), file->getFileSize<LEFT_SIDE>(),
+                                             fmtPath(file->getPairRelativePath()), deviceL, deviceR });
+                }
             }
 
         //finish symlink categorization
@@ -497,36 +593,24 @@ std::list<std::shared_ptr<BaseFolderPair>> ComparisonBuffer::compareByContent(co
                            bytesTotal,
                            ProcessCallback::PHASE_COMPARING_CONTENT);
 
-    const std::wstring txtComparingContentOfFiles = _("Comparing content of files %x");
-
     //PERF_START;
 
-    //compare files (that have same size) bytewise...
-    for (FilePair* file : filesToCompareBytewise)
+    //compare files (that have same size) bytewise: run multiple comparisons in parallel, limited per device
+    const std::vector<BinaryCompareResult> compareResults = compareFilesBinary(compareTasks, compareThreadsPerDevice_, callback_); //throw X?
+    assert(compareResults.size() == filesToCompareBytewise.size());
+
+    //FileSystemObject hierarchy may only be modified by the main thread:
+    for (size_t i = 0; i < filesToCompareBytewise.size(); ++i)
     {
-        callback_.reportStatus(replaceCpy(txtComparingContentOfFiles, L"%x", fmtPath(file->getPairRelativePath())));
+        FilePair* file = filesToCompareBytewise[i];
+        const BinaryCompareResult& result = compareResults[i];
 
         //check files that exist in left and right model but have different content
-
-        bool haveSameContent = false;
-        Opt<std::wstring> errMsg = tryReportingError([&]
-        {
-            StatisticsReporter statReporter(1, file->getFileSize<LEFT_SIDE>(), callback_);
-
-            auto onUpdateStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
-
-            haveSameContent = filesHaveSameContent(file->getAbstractPath<LEFT_SIDE>(),
-                                                   file->getAbstractPath<RIGHT_SIDE>(), onUpdateStatus); //throw FileError
-            statReporter.reportDelta(1, 0);
-
-            statReporter.reportFinished();
-        }, callback_); //throw X?
-
-        if (errMsg)
-            file->setCategoryConflict(*errMsg);
+        if (result.errMsg)
+            file->setCategoryConflict(*result.errMsg);
         else
         {
-            if (haveSameContent)
+            if (result.haveSameContent)
             {
                 //Caveat:
                 //1. FILE_EQUAL may only be set if short names match in case: InSyncFolder's mapping tables use short name as a key! see db_file.cpp
@@ -630,8 +714,8 @@ void MergeSides::fillOneSide(const FolderContainer& folderCont, const std::wstri
 //perf: 70% faster than traversing over left and right containers + more natural default sequence
 //- 2 x lessKey vs 1 x cmpFilePath() => no significant difference
 //- simplify loop by placing the eob check at the beginning => slightly slower
-template <class MapType, class ProcessLeftOnly, class ProcessRightOnly, class ProcessBoth> inline
-void linearMerge(const MapType& mapLeft, const MapType& mapRight, ProcessLeftOnly lo, ProcessRightOnly ro, ProcessBoth bo)
+template <class ItemList, class ProcessLeftOnly, class ProcessRightOnly, class ProcessBoth> inline
+void linearMerge(const ItemList& mapLeft, const ItemList& mapRight, ProcessLeftOnly lo, ProcessRightOnly ro, ProcessBoth bo) //item lists sorted by LessFilePath, see FolderContainer::sortItems()
 {
     auto itL = mapLeft .begin();
     auto itR = mapRight.begin();
@@ -642,7 +726,7 @@ void linearMerge(const MapType& mapLeft, const MapType& mapRight, ProcessLeftOnl
     if (itL == mapLeft .end()) return finishRight();
     if (itR == mapRight.end()) return finishLeft ();
 
-    const auto lessKey = typename MapType::key_compare();
+    const LessFilePath lessKey;
 
     for (;;)
         if (lessKey(itL->first, itR->first))
@@ -685,7 +769,7 @@ void MergeSides::mergeTwoSides(const FolderContainer& lhs, const FolderContainer
                                               fileRight.second);
         if (!checkFailedRead(newItem, errorMsg))
             undefinedFiles.push_back(&newItem);
-        static_assert(IsSameType<HierarchyObject::FileList, FixedList<FilePair>>::value, ""); //HierarchyObject::addSubFile() must NOT invalidate references used in "undefinedFiles"!
+        static_assert(IsSameType<HierarchyObject::FileList, HierarchyList<FilePair>>::value, ""); //HierarchyObject::addSubFile() must NOT invalidate references used in "undefinedFiles"!
     });
 
     //-----------------------------------------------------------------------------------------------
@@ -747,7 +831,7 @@ void stripExcludedDirectories(HierarchyObject& hierObj, const HardFilter& filter
     //remove superfluous directories:
     //   this does not invalidate "std::vector<FilePair*>& undefinedFiles", since we delete folders only
     //   and there is no side-effect for memory positions of FilePair and SymlinkPair thanks to zen::FixedList!
-    static_assert(IsSameType<FixedList<FolderPair>, HierarchyObject::FolderList>::value, "");
+    static_assert(IsSameType<HierarchyList<FolderPair>, HierarchyObject::FolderList>::value, "");
 
     hierObj.refSubFolders().remove_if([&](FolderPair& folder)
     {
@@ -852,6 +936,36 @@ void zen::logNonDefaultSettings(const xmlAccess::XmlGlobalSettings& activeSettin
     if (activeSettings.folderAccessTimeout != defaultSettings.folderAccessTimeout)
         changedSettingsMsg += L"\n    " + _("Folder access timeout") + L" - " + numberTo<std::wstring>(activeSettings.folderAccessTimeout);
 
+    if (activeSettings.scanThreadsPerDevice != defaultSettings.scanThreadsPerDevice)
+        changedSettingsMsg += L"\n    " + _("Parallel folder scan") + L" - " + replaceCpy(_P("1 thread", "%x threads", static_cast<int>(activeSettings.scanThreadsPerDevice)), L"%x", numberTo<std::wstring>(activeSettings.scanThreadsPerDevice));
+
+    if (activeSettings.scanSnapshot != defaultSettings.scanSnapshot)
+        changedSettingsMsg += L"\n    " + _("Skip reading unchanged folders") + L" - " + (activeSettings.scanSnapshot ? _("Enabled") : _("Disabled"));
+
+    if (activeSettings.compareThreadsPerDevice != defaultSettings.compareThreadsPerDevice)
+        changedSettingsMsg += L"\n    " + _("Parallel file comparison") + L" - " + replaceCpy(_P("1 thread", "%x threads", static_cast<int>(activeSettings.compareThreadsPerDevice)), L"%x", numberTo<std::wstring>(activeSettings.compareThreadsPerDevice));
+
+    if (activeSettings.reuseContentComparison != defaultSettings.reuseContentComparison)
+        changedSettingsMsg += L"\n    " + _("Reuse last content comparison") + L" - " + (activeSettings.reuseContentComparison ? _("Enabled") : _("Disabled"));
+
+    if (activeSettings.cloneFiles != defaultSettings.cloneFiles)
+        changedSettingsMsg += L"\n    " + _("Clone files") + L" - " + (activeSettings.cloneFiles ? _("Enabled") : _("Disabled"));
+
+    if (activeSettings.deltaCopy != defaultSettings.deltaCopy)
+        changedSettingsMsg += L"\n    " + _("Delta copy") + L" - " + (activeSettings.deltaCopy ? _("Enabled") : _("Disabled"));
+
+    if (activeSettings.syncThreadsPerFolderPair != defaultSettings.syncThreadsPerFolderPair)
+        changedSettingsMsg += L"\n    " + _("Parallel synchronization") + L" - " + replaceCpy(_P("1 thread", "%x threads", static_cast<int>(activeSettings.syncThreadsPerFolderPair)), L"%x", numberTo<std::wstring>(activeSettings.syncThreadsPerFolderPair));
+
+    if (activeSettings.syncThreadsTotal != defaultSettings.syncThreadsTotal)
+        changedSettingsMsg += L"\n    " + _("Parallel folder pairs") + L" - " + replaceCpy(_P("1 thread", "%x threads", static_cast<int>(activeSettings.syncThreadsTotal)), L"%x", numberTo<std::wstring>(activeSettings.syncThreadsTotal));
+
+    if (activeSettings.versionCountLimit != defaultSettings.versionCountLimit)
+        changedSettingsMsg += L"\n    " + _("Limit number of versions") + L" - " + numberTo<std::wstring>(activeSettings.versionCountLimit);
+
+    if (activeSettings.versionMaxAgeDays != defaultSettings.versionMaxAgeDays)
+        changedSettingsMsg += L"\n    " + _("Remove versions older than") + L" - " + replaceCpy(_P("1 day", "%x days", activeSettings.versionMaxAgeDays), L"%x", numberTo<std::wstring>(activeSettings.versionMaxAgeDays));
+
     if (activeSettings.runWithBackgroundPriority != defaultSettings.runWithBackgroundPriority)
         changedSettingsMsg += L"\n    " + _("Run with background priority") + L" - " + (activeSettings.runWithBackgroundPriority ? _("Enabled") : _("Disabled"));
 
@@ -871,6 +985,11 @@ FolderComparison zen::compare(xmlAccess::OptionalDialogs& warnings,
                               bool allowUserInteraction,
                               bool runWithBackgroundPriority,
                               int folderAccessTimeout,
+                              size_t scanThreadsPerDevice,
+                              bool useScanSnapshot,
+                              const ChangeList* changeList,
+                              size_t compareThreadsPerDevice,
+                              bool reuseContentComparison,
                               bool createDirLocks,
                               std::unique_ptr<LockHolder>& dirLocks,
                               const std::vector<FolderPairCfg>& cfgList,
@@ -959,7 +1078,7 @@ FolderComparison zen::compare(xmlAccess::OptionalDialogs& warnings,
         {
             //------------ traverse/read folders -----------------------------------------------------
             //PERF_START;
-            ComparisonBuffer cmpBuff(dirsToRead, fileTimeTolerance, callback);
+            ComparisonBuffer cmpBuff(dirsToRead, scanThreadsPerDevice, useScanSnapshot, changeList, compareThreadsPerDevice, reuseContentComparison, fileTimeTolerance, callback);
             //PERF_STOP;
 
             //process binary comparison as one junk
@@ -12,6 +12,7 @@
 #include "process_callback.h"
 #include "lib/norm_filter.h"
 #include "lib/lock_holder.h"
+#include "lib/change_list.h"
 
 
 namespace zen
@@ -56,6 +57,11 @@ FolderComparison compare(xmlAccess::OptionalDialogs& warnings,
                          bool allowUserInteraction,
                          bool runWithBackgroundPriority,
                          int folderAccessTimeout,
+                         size_t scanThreadsPerDevice,
+                         bool useScanSnapshot,
+                         const ChangeList* changeList, //optional: changes reported by RealTimeSync since its last command execution
+                         size_t compareThreadsPerDevice,
+                         bool reuseContentComparison,
                          bool createDirLocks,
                          std::unique_ptr<LockHolder>& dirLocks, //out
                          const std::vector<FolderPairCfg>& cfgList,
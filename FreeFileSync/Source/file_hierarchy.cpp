@@ -5,16 +5,71 @@
 // *****************************************************************************
 
 #include "file_hierarchy.h"
+#include <atomic>
+#include <unordered_map>
 #include <zen/i18n.h>
 #include <zen/utf.h>
 #include <zen/file_error.h>
+#include <zen/thread.h>
+#include <zen/scope_guard.h>
 
 using namespace zen;
 
 
-#ifndef NDEBUG
-    const std::thread::id ObjectMgr<FileSystemObject>::mainThreadId = std::this_thread::get_id();
-#endif
+namespace
+{
+using DescriptionTable = std::unordered_map<const FileSystemObject*, std::wstring>;
+
+std::mutex lockDescriptions; //like ObjectMgr: used only during parallel hierarchy access
+
+DescriptionTable& getDescriptionTable(bool syncDirConflict) //call while holding "lockDescriptions"
+{
+    static DescriptionTable cmpResultDescr;
+    static DescriptionTable syncDirectionConflict;
+    return syncDirConflict ? syncDirectionConflict : cmpResultDescr;
+}
+}
+
+
+void FileSystemObject::setDescription(bool syncDirConflict, const std::wstring& description)
+{
+    HierarchyLock dummy(lockDescriptions);
+    getDescriptionTable(syncDirConflict)[this] = description;
+    (syncDirConflict ? haveSyncDirConflict : haveCmpResultDescr) = true;
+}
+
+
+std::wstring FileSystemObject::getDescription(bool syncDirConflict) const
+{
+    HierarchyLock dummy(lockDescriptions);
+    const DescriptionTable& table = getDescriptionTable(syncDirConflict);
+    auto it = table.find(this);
+    if (it != table.end()) //avoid ternary-WTF! (implicit copy-constructor call!!!!!!)
+        return it->second;
+    assert(false);
+    return std::wstring();
+}
+
+
+void FileSystemObject::clearSyncDirConflict()
+{
+    HierarchyLock dummy(lockDescriptions);
+    getDescriptionTable(true /*syncDirConflict*/).erase(this);
+    haveSyncDirConflict = false;
+}
+
+
+void FileSystemObject::eraseDescriptions()
+{
+    if (!haveCmpResultDescr && !haveSyncDirConflict)
+        return;
+
+    HierarchyLock dummy(lockDescriptions);
+    if (haveCmpResultDescr)
+        getDescriptionTable(false /*syncDirConflict*/).erase(this);
+    if (haveSyncDirConflict)
+        getDescriptionTable(true /*syncDirConflict*/).erase(this);
+}
 
 
 void HierarchyObject::removeEmptyRec()
@@ -154,7 +209,7 @@ SyncOperation FileSystemObject::testSyncOperation(SyncDirection testSyncDir) con
 
 SyncOperation FileSystemObject::getSyncOperation() const
 {
-    return getIsolatedSyncOperation(!isEmpty<LEFT_SIDE>(), !isEmpty<RIGHT_SIDE>(), getCategory(), selectedForSync, getSyncDir(), syncDirectionConflict.get() != nullptr);
+    return getIsolatedSyncOperation(!isEmpty<LEFT_SIDE>(), !isEmpty<RIGHT_SIDE>(), getCategory(), selectedForSync, getSyncDir(), haveSyncDirConflict);
     //do *not* make a virtual call to testSyncOperation()! See FilePair::testSyncOperation()! <- better not implement one in terms of the other!!!
 }
 
@@ -286,6 +341,270 @@ SyncOperation FilePair::getSyncOperation() const
     return applyMoveOptimization(FileSystemObject::getSyncOperation());
 }
 
+//-----------------------------------------------------------------------------------------------------------
+
+namespace
+{
+//this counts *logical* operations, (create, update, delete + bytes), *not* disk accesses!
+void addItemStats(SubTreeStats& stats, const FilePair& file)
+{
+    switch (file.getSyncOperation()) //evaluate comparison result and sync direction
+    {
+        case SO_CREATE_NEW_LEFT:
+            ++stats.createLeft;
+            stats.dataToProcess   += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+            stats.spaceNeededLeft += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+            break;
+
+        case SO_CREATE_NEW_RIGHT:
+            ++stats.createRight;
+            stats.dataToProcess    += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
+            stats.spaceNeededRight += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
+            break;
+
+        case SO_DELETE_LEFT:
+            ++stats.deleteLeft;
+            stats.spaceNeededLeft -= static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>()); //generally assume deletion frees space, see getMinimumDiskSpaceNeeded()
+            break;
+
+        case SO_DELETE_RIGHT:
+            ++stats.deleteRight;
+            stats.spaceNeededRight -= static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+            break;
+
+        case SO_MOVE_LEFT_TARGET:
+            ++stats.updateLeft;
+            break;
+
+        case SO_MOVE_RIGHT_TARGET:
+            ++stats.updateRight;
+            break;
+
+        case SO_MOVE_LEFT_SOURCE:  //ignore; already counted
+        case SO_MOVE_RIGHT_SOURCE: //
+            break;
+
+        case SO_OVERWRITE_LEFT:
+            ++stats.updateLeft;
+            stats.dataToProcess   += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+            stats.spaceNeededLeft -= static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
+            stats.spaceNeededLeft += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+            break;
+
+        case SO_OVERWRITE_RIGHT:
+            ++stats.updateRight;
+            stats.dataToProcess    += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
+            stats.spaceNeededRight -= static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+            stats.spaceNeededRight += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
+            break;
+
+        case SO_UNRESOLVED_CONFLICT:
+            ++stats.conflictCount;
+            break;
+
+        case SO_COPY_METADATA_TO_LEFT:
+            ++stats.updateLeft;
+            break;
+
+        case SO_COPY_METADATA_TO_RIGHT:
+            ++stats.updateRight;
+            break;
+
+        case SO_DO_NOTHING:
+        case SO_EQUAL:
+            break;
+    }
+}
+
+
+void addItemStats(SubTreeStats& stats, const SymlinkPair& link) //symbolic links: disk space is not considered
+{
+    switch (link.getSyncOperation()) //evaluate comparison result and sync direction
+    {
+        case SO_CREATE_NEW_LEFT:
+            ++stats.createLeft;
+            break;
+
+        case SO_CREATE_NEW_RIGHT:
+            ++stats.createRight;
+            break;
+
+        case SO_DELETE_LEFT:
+            ++stats.deleteLeft;
+            break;
+
+        case SO_DELETE_RIGHT:
+            ++stats.deleteRight;
+            break;
+
+        case SO_OVERWRITE_LEFT:
+        case SO_COPY_METADATA_TO_LEFT:
+            ++stats.updateLeft;
+            break;
+
+        case SO_OVERWRITE_RIGHT:
+        case SO_COPY_METADATA_TO_RIGHT:
+            ++stats.updateRight;
+            break;
+
+        case SO_UNRESOLVED_CONFLICT:
+            ++stats.conflictCount;
+            break;
+
+        case SO_MOVE_LEFT_SOURCE:
+        case SO_MOVE_RIGHT_SOURCE:
+        case SO_MOVE_LEFT_TARGET:
+        case SO_MOVE_RIGHT_TARGET:
+            assert(false);
+        case SO_DO_NOTHING:
+        case SO_EQUAL:
+            break;
+    }
+}
+
+
+void addItemStats(SubTreeStats& stats, const FolderPair& folder) //folder only: child items are counted separately; disk space is not considered
+{
+    switch (folder.getSyncOperation()) //evaluate comparison result and sync direction
+    {
+        case SO_CREATE_NEW_LEFT:
+            ++stats.createLeft;
+            break;
+
+        case SO_CREATE_NEW_RIGHT:
+            ++stats.createRight;
+            break;
+
+        case SO_DELETE_LEFT: //if deletion variant == user-defined directory existing on other volume, this results in a full copy + delete operation!
+            ++stats.deleteLeft;    //however we cannot (reliably) anticipate this situation, fortunately statistics can be adapted during sync!
+            break;
+
+        case SO_DELETE_RIGHT:
+            ++stats.deleteRight;
+            break;
+
+        case SO_UNRESOLVED_CONFLICT:
+            ++stats.conflictCount;
+            break;
+
+        case SO_OVERWRITE_LEFT:
+        case SO_COPY_METADATA_TO_LEFT:
+            ++stats.updateLeft;
+            break;
+
+        case SO_OVERWRITE_RIGHT:
+        case SO_COPY_METADATA_TO_RIGHT:
+            ++stats.updateRight;
+            break;
+
+        case SO_MOVE_LEFT_SOURCE:
+        case SO_MOVE_RIGHT_SOURCE:
+        case SO_MOVE_LEFT_TARGET:
+        case SO_MOVE_RIGHT_TARGET:
+            assert(false);
+        case SO_DO_NOTHING:
+        case SO_EQUAL:
+            break;
+    }
+}
+}
+
+
+SubTreeStats zen::getItemStats(const FileSystemObject& fsObj)
+{
+    SubTreeStats stats;
+    visitFSObject(fsObj, [&](const FolderPair&  folder) { addItemStats(stats, folder); },
+    /**/                 [&](const FilePair&    file  ) { addItemStats(stats, file  ); },
+    /**/                 [&](const SymlinkPair& link  ) { addItemStats(stats, link  ); });
+    return stats;
+}
+
+
+void HierarchyObject::updateSubTreeStats() const
+{
+    SubTreeStats stats;
+
+    for (const FilePair& file : refSubFiles())
+        addItemStats(stats, file);
+    for (const SymlinkPair& link : refSubLinks())
+        addItemStats(stats, link);
+    for (const FolderPair& folder : refSubFolders())
+    {
+        addItemStats(stats, folder);
+
+        //since we model logical stats, we recurse, even if deletion variant is "recycler" or "versioning + same volume", which is a single physical operation!
+        const HierarchyObject& subFolder = folder;
+        if (!subFolder.haveBufferedStats)
+            subFolder.updateSubTreeStats(); //recurse
+        stats.add(subFolder.statsBuffer);
+    }
+
+    stats.rowCount += refSubFolders().size();
+    stats.rowCount += refSubFiles  ().size();
+    stats.rowCount += refSubLinks  ().size();
+
+    statsBuffer = stats;
+    haveBufferedStats = true;
+}
+
+
+const SubTreeStats& HierarchyObject::getSubTreeStats() const
+{
+    if (!haveBufferedStats)
+    {
+        //find independent work items: split up changed sub trees breadth-first until there are enough to keep all threads busy
+        const size_t threadCount = std::thread::hardware_concurrency();
+
+        std::vector<const HierarchyObject*> workItems;
+        for (const FolderPair& folder : refSubFolders())
+            if (!static_cast<const HierarchyObject&>(folder).haveBufferedStats)
+                workItems.push_back(&folder);
+
+        for (int level = 0; level < 10 && workItems.size() < 4 * threadCount; ++level)
+        {
+            std::vector<const HierarchyObject*> workItemsNext;
+            bool splitUp = false;
+            for (const HierarchyObject* hierObj : workItems)
+            {
+                const size_t sizeBefore = workItemsNext.size();
+                for (const FolderPair& folder : hierObj->refSubFolders())
+                    if (!static_cast<const HierarchyObject&>(folder).haveBufferedStats)
+                        workItemsNext.push_back(&folder);
+
+                if (workItemsNext.size() == sizeBefore) //no changed sub folders: remains a work item
+                    workItemsNext.push_back(hierObj);
+                else
+                    splitUp = true; //items of "hierObj" itself are evaluated by the main thread below
+            }
+            if (!splitUp)
+                break;
+            workItems.swap(workItemsNext);
+        }
+
+        if (threadCount > 1 && workItems.size() > 1)
+        {
+            std::atomic<size_t> nextItem(0);
+            std::vector<std::future<void>> jobs;
+            ZEN_ON_SCOPE_FAIL(for (std::future<void>& job : jobs) if (job.valid()) job.wait();); //don't leave threads running on the hierarchy
+
+            for (size_t i = 0; i < std::min(threadCount, workItems.size()); ++i)
+                jobs.push_back(runAsync([&workItems, &nextItem]
+            {
+                for (size_t pos = nextItem++; pos < workItems.size(); pos = nextItem++)
+                    workItems[pos]->updateSubTreeStats(); //work items are disjoint sub trees => no shared state
+            }));
+
+            for (std::future<void>& job : jobs)
+                job.wait();
+            for (std::future<void>& job : jobs)
+                job.get(); //throw std::bad_alloc
+        }
+
+        updateSubTreeStats(); //evaluate remaining changed items; up-to-date sub trees are skipped
+    }
+    return statsBuffer;
+}
+
 
 std::wstring zen::getCategoryDescription(CompareFilesResult cmpRes)
 {
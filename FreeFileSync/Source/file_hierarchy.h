@@ -8,18 +8,21 @@
 #define FILE_HIERARCHY_H_257235289645296
 
 #include <map>
+#include <algorithm>
 #include <cstddef> //required by GCC 4.8.1 to find ptrdiff_t
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <memory>
 #include <functional>
+#include <type_traits>
 #include <unordered_set>
+#include <mutex>
+#include <atomic>
 #include <zen/zstring.h>
 #include <zen/fixed_list.h>
 #include <zen/stl_tools.h>
 #include <zen/file_id_def.h>
-#ifndef NDEBUG
-    #include <zen/thread.h>
-#endif
 #include "structures.h"
 #include "lib/hard_filter.h"
 #include "fs/abstract.h"
@@ -92,15 +95,18 @@ struct SelectParam<RIGHT_SIDE>
 
 //------------------------------------------------------------------
 
+//written once during folder traversal, then read in sorted order by linearMerge() => flat vectors instead of std::map: no node allocation per item
 struct FolderContainer
 {
     //------------------------------------------------------------------
-    using FolderList  = std::map<Zstring, FolderContainer, LessFilePath>; //
-    using FileList    = std::map<Zstring, FileDescriptor,  LessFilePath>; //key: file name
-    using SymlinkList = std::map<Zstring, LinkDescriptor,  LessFilePath>; //
+    using FolderList  = std::vector<std::pair<Zstring, FolderContainer>>; //
+    using FileList    = std::vector<std::pair<Zstring, FileDescriptor>>;  //key: item name; sorted by LessFilePath after sortItems()
+    using SymlinkList = std::vector<std::pair<Zstring, LinkDescriptor>>;  //
     //------------------------------------------------------------------
 
     FolderContainer() = default;
+    FolderContainer           (FolderContainer&&) = default;
+    FolderContainer& operator=(FolderContainer&&) = default;
     FolderContainer           (const FolderContainer&) = delete; //catch accidental (and unnecessary) copying
     FolderContainer& operator=(const FolderContainer&) = delete; //
 
@@ -108,25 +114,38 @@ struct FolderContainer
     FileList    files;
     SymlinkList symlinks; //non-followed symlinks
 
-    //convenience
-    FolderContainer& addSubFolder(const Zstring& itemName)
-    {
-        return folders[itemName]; //value default-construction is okay here
-        //return dirs.emplace(itemName, FolderContainer()).first->second;
-    }
+    //convenience: append only, references to sub folders are invalidated!
+    void addSubFolder(const Zstring& itemName)                                  { folders .emplace_back(itemName, FolderContainer()); }
+    void addSubFile  (const Zstring& itemName, const FileDescriptor& fileData) { files   .emplace_back(itemName, fileData); }
+    void addSubLink  (const Zstring& itemName, const LinkDescriptor& linkData) { symlinks.emplace_back(itemName, linkData); }
 
-    void addSubFile(const Zstring& itemName, const FileDescriptor& fileData)
+    //call once after all items of this folder were added (sub folder content is not touched):
+    //sort by name and remove duplicate items, e.g. reported during folder traverser "retry" => last one wins; does not handle different item name case (irrelvant!..)
+    void sortItems()
     {
-        auto rv = files.emplace(itemName, fileData);
-        if (!rv.second) //update entry if already existing (e.g. during folder traverser "retry") => does not handle different item name case (irrelvant!..)
-            rv.first->second = fileData;
+        sortByName(folders);
+        sortByName(files);
+        sortByName(symlinks);
     }
 
-    void addSubLink(const Zstring& itemName, const LinkDescriptor& linkData)
+private:
+    template <class ItemList>
+    static void sortByName(ItemList& items)
     {
-        auto rv = symlinks.emplace(itemName, linkData);
-        if (!rv.second)
-            rv.first->second = linkData;
+        using ItemType = typename ItemList::value_type;
+        const LessFilePath lessKey;
+
+        std::stable_sort(items.begin(), items.end(), [&](const ItemType& lhs, const ItemType& rhs) { return lessKey(lhs.first, rhs.first); });
+
+        auto itOut = items.begin();
+        for (auto it = items.begin(); it != items.end(); ++it)
+            if (it + 1 == items.end() || lessKey(it->first, (it + 1)->first)) //last of a range of equal names
+            {
+                if (itOut != it)
+                    *itOut = std::move(*it);
+                ++itOut;
+            }
+        items.erase(itOut, items.end());
     }
 };
 
@@ -136,6 +155,124 @@ class FilePair;
 class SymlinkPair;
 class FileSystemObject;
 
+//------------------------------------------------------------------
+
+//the hierarchy is accessed by a single thread, except while folder pairs are synchronized in parallel (see synchronize())
+//=> lock node pools, ObjectMgr and description tables only then: no overhead for comparison, grid and sorting
+namespace impl
+{
+inline
+std::atomic<bool>& refParallelHierarchyAccess()
+{
+    static std::atomic<bool> inst{ false }; //std:atomic is uninitialized by default!
+    return inst; //external linkage (even in header file!)
+}
+}
+
+//CONTRACT: switch only while no other thread is accessing the hierarchy, e.g. before starting and after joining worker threads
+inline void setParallelHierarchyAccess(bool enabled) { impl::refParallelHierarchyAccess() = enabled; }
+
+
+class HierarchyLock
+{
+public:
+    explicit HierarchyLock(std::mutex& mutex) : mutex_(impl::refParallelHierarchyAccess() ? &mutex : nullptr) { if (mutex_) mutex_->lock(); }
+    ~HierarchyLock() { if (mutex_) mutex_->unlock(); }
+
+private:
+    HierarchyLock           (const HierarchyLock&) = delete;
+    HierarchyLock& operator=(const HierarchyLock&) = delete;
+
+    std::mutex* const mutex_; //nullptr if not locked
+};
+
+//------------------------------------------------------------------
+
+//hand out memory for the (millions of) hierarchy nodes in large chunks: avoid per-allocation overhead of the general-purpose heap
+//not thread-safe except for parallel hierarchy access, just like ObjectMgr; all chunks are released as soon as the last block is freed
+template <size_t blockSize>
+class FixedSizePool
+{
+public:
+    static void* allocate() //throw std::bad_alloc
+    {
+        FixedSizePool& pool = instance();
+        HierarchyLock dummy(pool.lockPool);
+
+        Block* block = pool.freeList;
+        if (block)
+            pool.freeList = block->next;
+        else
+        {
+            if (pool.chunkPos == BLOCKS_PER_CHUNK)
+            {
+                pool.chunks.push_back(std::make_unique<Block[]>(BLOCKS_PER_CHUNK)); //throw std::bad_alloc
+                pool.chunkPos = 0;
+            }
+            block = &pool.chunks.back()[pool.chunkPos++];
+        }
+        ++pool.blocksInUse;
+        return block;
+    }
+
+    static void deallocate(void* p)
+    {
+        FixedSizePool& pool = instance();
+        HierarchyLock dummy(pool.lockPool);
+
+        Block* block = static_cast<Block*>(p);
+        block->next = pool.freeList;
+        pool.freeList = block;
+
+        assert(pool.blocksInUse > 0);
+        if (--pool.blocksInUse == 0) //comparison result was discarded: give memory back
+        {
+            pool.chunks.clear();
+            pool.chunkPos = BLOCKS_PER_CHUNK;
+            pool.freeList = nullptr;
+        }
+    }
+
+private:
+    union Block
+    {
+        Block* next; //free list
+        typename std::aligned_storage<blockSize>::type data; //default alignment is suitable for any type of size "blockSize"
+    };
+    static const size_t BLOCKS_PER_CHUNK = std::max<size_t>(256 * 1024 / sizeof(Block), 1);
+
+    static FixedSizePool& instance()
+    {
+        static FixedSizePool inst;
+        return inst; //external linkage (even in header file!)
+    }
+
+    std::vector<std::unique_ptr<Block[]>> chunks;
+    size_t chunkPos = BLOCKS_PER_CHUNK; //next unused block of chunks.back()
+    Block* freeList = nullptr;
+    size_t blocksInUse = 0;
+    std::mutex lockPool; //used only during parallel hierarchy access
+};
+
+
+template <class T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    PoolAllocator() {}
+    template <class U> PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n) { assert(n == 1); return static_cast<T*>(FixedSizePool<sizeof(T)>::allocate()); } //throw std::bad_alloc
+    void deallocate(T* p, size_t n) { assert(n == 1); FixedSizePool<sizeof(T)>::deallocate(p); }
+
+    template <class U> inline friend bool operator==(const PoolAllocator&, const PoolAllocator<U>&) { return true; }
+    template <class U> inline friend bool operator!=(const PoolAllocator&, const PoolAllocator<U>&) { return false; }
+};
+
+template <class T>
+using HierarchyList = FixedList<T, PoolAllocator<T>>;
+
 /*------------------------------------------------------------------
     inheritance diagram:
 
@@ -150,15 +287,47 @@ class FileSystemObject;
 
 ------------------------------------------------------------------*/
 
+//statistics of all items contained in a HierarchyObject (recursively), see SyncStatistics
+struct SubTreeStats
+{
+    int createLeft  = 0;
+    int createRight = 0;
+    int updateLeft  = 0;
+    int updateRight = 0;
+    int deleteLeft  = 0;
+    int deleteRight = 0;
+    int conflictCount = 0;
+    std::int64_t dataToProcess = 0;
+    std::int64_t spaceNeededLeft  = 0; //minimum disk space needed by sync; negative if space is freed
+    std::int64_t spaceNeededRight = 0; //
+    size_t rowCount = 0;
+
+    void add(const SubTreeStats& other)
+    {
+        createLeft       += other.createLeft;
+        createRight      += other.createRight;
+        updateLeft       += other.updateLeft;
+        updateRight      += other.updateRight;
+        deleteLeft       += other.deleteLeft;
+        deleteRight      += other.deleteRight;
+        conflictCount    += other.conflictCount;
+        dataToProcess    += other.dataToProcess;
+        spaceNeededLeft  += other.spaceNeededLeft;
+        spaceNeededRight += other.spaceNeededRight;
+        rowCount         += other.rowCount;
+    }
+};
+
+
 class HierarchyObject
 {
     friend class FolderPair;
     friend class FileSystemObject;
 
 public:
-    using FileList    = FixedList<FilePair>;    //MergeSides::execute() requires a structure that doesn't invalidate pointers after push_back()
-    using SymlinkList = FixedList<SymlinkPair>; //Note: deque<> has circular dependency in VCPP!
-    using FolderList  = FixedList<FolderPair>;
+    using FileList    = HierarchyList<FilePair>;    //MergeSides::execute() requires a structure that doesn't invalidate pointers after push_back()
+    using SymlinkList = HierarchyList<SymlinkPair>; //Note: deque<> has circular dependency in VCPP!
+    using FolderList  = HierarchyList<FolderPair>;
 
     FolderPair& addSubFolder(const Zstring& itemNameLeft,
                              const Zstring& itemNameRight,
@@ -201,6 +370,10 @@ public:
 
     const Zstring& getPairRelativePathPf() const { return pairRelPathPf; } //postfixed or empty!
 
+    //buffered: only sub trees changed since the last call are re-evaluated (in parallel); main thread only!
+    //CAVEAT: changing the category of an item (comparison only) is not tracked, unlike changes to sync direction or active status
+    const SubTreeStats& getSubTreeStats() const;
+
 protected:
     HierarchyObject(const Zstring& relPathPf,
                     BaseFolderPair& baseFolder) :
@@ -214,15 +387,20 @@ protected:
     void removeEmptyRec();
 
 private:
-    virtual void notifySyncCfgChanged() {}
+    virtual void notifySyncCfgChanged() { haveBufferedStats = false; }
 
     HierarchyObject           (const HierarchyObject&) = delete; //this class is referenced by it's child elements => make it non-copyable/movable!
     HierarchyObject& operator=(const HierarchyObject&) = delete;
 
+    void updateSubTreeStats() const; //recurse into changed sub trees only
+
     FileList    subFiles;   //contained file maps
     SymlinkList subLinks;   //contained symbolic link maps
     FolderList  subFolders; //contained directory maps
 
+    mutable SubTreeStats statsBuffer;       //invalidated by notifySyncCfgChanged() of any child item
+    mutable bool haveBufferedStats = false; //=> invariant: if buffer is invalid, so are the buffers of all parent folders
+
     Zstring pairRelPathPf; //postfixed or empty
     BaseFolderPair& base_;
 };
@@ -323,45 +501,124 @@ struct FSObjectVisitor
 };
 
 
+template <class T>
+class ObjectMgr;
+
+//weak reference to an ObjectMgr-derived object: "index + generation" of its slot => stale if object was destroyed, even if slot is reused
+template <class T, bool isConst>
+class ObjectIdT
+{
+public:
+    ObjectIdT() {}
+    ObjectIdT(std::nullptr_t) {}
+
+    template <bool isConstOther, class = typename std::enable_if<isConst || !isConstOther>::type> //non-const => const only
+    ObjectIdT(const ObjectIdT<T, isConstOther>& other) : index_(other.index_), generation_(other.generation_) {}
+
+    explicit operator bool() const { return index_ != 0; }
+
+    inline friend bool operator==(const ObjectIdT& lhs, const ObjectIdT& rhs) { return lhs.index_ == rhs.index_ && lhs.generation_ == rhs.generation_; }
+    inline friend bool operator!=(const ObjectIdT& lhs, const ObjectIdT& rhs) { return !(lhs == rhs); }
+
+    size_t hash() const { return index_; } //unique among all objects alive
+
+private:
+    friend class ObjectMgr<T>;
+    template <class U, bool isConstOther> friend class ObjectIdT;
+
+    ObjectIdT(std::uint32_t index, std::uint32_t generation) : index_(index), generation_(generation) {}
+
+    std::uint32_t index_      = 0; //0 <=> nullptr
+    std::uint32_t generation_ = 0;
+};
+
+
 //inherit from this class to allow safe random access by id instead of unsafe raw pointer
 //allow for similar semantics like std::weak_ptr without having to use std::shared_ptr
+//=> generation-indexed slot table: O(1) lookup without hashing and 16 byte per object (instead of a hash set node + bucket)
 template <class T>
 class ObjectMgr
 {
 public:
-    using ObjectId      = ObjectMgr* ;
-    using ObjectIdConst = const ObjectMgr*;
+    using ObjectId      = ObjectIdT<T, false>;
+    using ObjectIdConst = ObjectIdT<T, true>;
 
-    ObjectIdConst  getId() const { return this; }
-    /**/  ObjectId getId()       { return this; }
+    ObjectIdConst  getId() const { return ObjectIdConst(slotIndex_, generation_); }
+    /**/  ObjectId getId()       { return ObjectId     (slotIndex_, generation_); }
 
-    static const T* retrieve(ObjectIdConst id) //returns nullptr if object is not valid anymore
+    //returns nullptr if object is not valid anymore
+    static const T* retrieve(ObjectIdConst id)
     {
-        auto it = activeObjects().find(id);
-        return static_cast<const T*>(it == activeObjects().end() ? nullptr : *it);
+        SlotTable& st = slotTable();
+        HierarchyLock dummy(st.lockSlots);
+        if (id.index_ < st.slots.size())
+        {
+            const Slot& slot = st.slots[id.index_];
+            if (slot.obj && slot.generation == id.generation_)
+                return static_cast<const T*>(slot.obj);
+        }
+        return nullptr;
     }
     static T* retrieve(ObjectId id) { return const_cast<T*>(retrieve(static_cast<ObjectIdConst>(id))); }
 
 protected:
-    ObjectMgr () { activeObjects().insert(this); }
-    ~ObjectMgr() { activeObjects().erase (this); }
+    ObjectMgr()
+    {
+        SlotTable& st = slotTable();
+        HierarchyLock dummy(st.lockSlots);
+        if (st.firstFree != 0)
+        {
+            slotIndex_ = st.firstFree;
+            st.firstFree = st.slots[slotIndex_].nextFree;
+        }
+        else
+        {
+            slotIndex_ = static_cast<std::uint32_t>(st.slots.size());
+            st.slots.emplace_back(); //throw std::bad_alloc
+        }
+        Slot& slot = st.slots[slotIndex_];
+        slot.obj = this;
+        generation_ = slot.generation;
+    }
+
+    ~ObjectMgr()
+    {
+        SlotTable& st = slotTable();
+        HierarchyLock dummy(st.lockSlots);
+        Slot& slot = st.slots[slotIndex_];
+        slot.obj = nullptr;
+        ++slot.generation; //invalidate all outstanding ids
+        slot.nextFree = st.firstFree;
+        st.firstFree = slotIndex_;
+    }
 
 private:
     ObjectMgr           (const ObjectMgr& rhs) = delete;
     ObjectMgr& operator=(const ObjectMgr& rhs) = delete; //it's not well-defined what copying an objects means regarding object-identity in this context
 
-    static std::unordered_set<const ObjectMgr*>& activeObjects()
+    struct Slot
     {
-#ifndef NDEBUG
-        assert(std::this_thread::get_id() == mainThreadId); //our global ObjectMgr is not thread-safe (and currently does not need to be!)
-#endif
-        static std::unordered_set<const ObjectMgr*> inst;
+        const ObjectMgr* obj = nullptr; //nullptr if unused
+        std::uint32_t generation = 0;
+        std::uint32_t nextFree   = 0; //free list of unused slots; 0 <=> end of list
+    };
+
+    struct SlotTable
+    {
+        std::vector<Slot> slots = std::vector<Slot>(1); //slot 0 is never used => ObjectIdT() means nullptr
+        std::uint32_t firstFree = 0;
+        std::mutex lockSlots; //used only during parallel hierarchy access
+        //don't shrink "slots" even if all objects are gone: outstanding ids must not match the generation of future objects!
+    };
+
+    static SlotTable& slotTable()
+    {
+        static SlotTable inst;
         return inst; //external linkage (even in header file!)
     }
 
-#ifndef NDEBUG
-    static const std::thread::id mainThreadId;
-#endif
+    std::uint32_t slotIndex_  = 0;
+    std::uint32_t generation_ = 0; //buffer: no slot table access needed by getId()
 };
 
 //------------------------------------------------------------------
@@ -418,15 +675,18 @@ protected:
                      CompareFilesResult defaultCmpResult) :
         cmpResult(defaultCmpResult),
         itemNameLeft_(itemNameLeft),
-        itemNameRight_(itemNameRight),
-        //itemNameRight_(itemNameRight == itemNameLeft ? itemNameLeft : itemNameRight), -> strangely doesn't seem to shrink peak memory consumption at all!
+        itemNameRight_(itemNameRight == itemNameLeft ? itemNameLeft : itemNameRight), //share ref-counted buffer: doesn't shrink peak memory during comparison, but the lasting comparison result
         parent_(parentObj)
     {
         parent_.notifySyncCfgChanged();
     }
 
-    virtual ~FileSystemObject() {} //don't need polymorphic deletion, but we have a vtable anyway
-    //mustn't call parent here, it is already partially destroyed and nothing more than a pure HierarchyObject!
+    virtual ~FileSystemObject() //don't need polymorphic deletion, but we have a vtable anyway
+    {
+        //mustn't call parent here, it is already partially destroyed and nothing more than a pure HierarchyObject!
+        if (haveCmpResultDescr || haveSyncDirConflict)
+            eraseDescriptions();
+    }
 
     virtual void flip();
     virtual void notifySyncCfgChanged() { parent().notifySyncCfgChanged(); /*propagate!*/ }
@@ -440,16 +700,22 @@ private:
     virtual void removeObjectL() = 0;
     virtual void removeObjectR() = 0;
 
+    //conflict texts are rare: keep them in a side table instead of two pointers per object
+    void setDescription(bool syncDirConflict, const std::wstring& description);
+    std::wstring getDescription(bool syncDirConflict) const;
+    void clearSyncDirConflict();
+    void eraseDescriptions();
+
     //categorization
-    std::unique_ptr<std::wstring> cmpResultDescr; //only filled if getCategory() == FILE_CONFLICT or FILE_DIFFERENT_METADATA
     CompareFilesResult cmpResult; //although this uses 4 bytes there is currently *no* space wasted in class layout!
 
     bool selectedForSync = true;
 
     //Note: we model *four* states with following two variables => "syncDirectionConflict is empty or syncDir == NONE" is a class invariant!!!
     SyncDirection syncDir_ = SyncDirection::NONE; //1 byte: optimize memory layout!
-    std::unique_ptr<std::wstring> syncDirectionConflict; //non-empty if we have a conflict setting sync-direction
-    //get rid of std::wstring small string optimization (consumes 32/48 byte on VS2010 x86/x64!)
+
+    bool haveCmpResultDescr  = false; //side table entry only exists if getCategory() == FILE_CONFLICT or FILE_DIFFERENT_METADATA
+    bool haveSyncDirConflict = false; //side table entry exists if we have a conflict setting sync-direction
 
     Zstring itemNameLeft_;  //slightly redundant under linux, but on windows the "same" filepaths can differ in case
     Zstring itemNameRight_; //use as indicator: an empty name means: not existing!
@@ -506,14 +772,16 @@ public:
              HierarchyObject& parentObj) :
         FileSystemObject(itemNameLeft, itemNameRight, parentObj, defaultCmpResult),
         dataLeft(left),
-        dataRight(right) {}
+        dataRight(right),
+        followedSymlinkLeft (left .isFollowedSymlink),
+        followedSymlinkRight(right.isFollowedSymlink) {}
 
     template <SelectedSide side> std::int64_t getLastWriteTime() const;
     template <SelectedSide side> std::uint64_t     getFileSize() const;
     template <SelectedSide side> AFS::FileId       getFileId  () const;
     template <SelectedSide side> bool        isFollowedSymlink() const;
 
-    void setMoveRef(ObjectId refId) { moveFileRef = refId; } //reference to corresponding renamed file
+    void setMoveRef(ObjectId refId) { moveFileRef = refId; notifySyncCfgChanged(); } //reference to corresponding renamed file
     ObjectId getMoveRef() const { return moveFileRef; } //may be nullptr
 
     CompareFilesResult getFileCategory() const;
@@ -535,13 +803,27 @@ private:
     SyncOperation applyMoveOptimization(SyncOperation op) const;
 
     void flip         () override;
-    void removeObjectL() override { dataLeft  = FileDescriptor(); }
-    void removeObjectR() override { dataRight = FileDescriptor(); }
+    void removeObjectL() override { dataLeft  = FileAttributes(); followedSymlinkLeft  = false; }
+    void removeObjectR() override { dataRight = FileAttributes(); followedSymlinkRight = false; }
+    void notifySyncCfgChanged() override;
+
+    struct FileAttributes //= FileDescriptor without "isFollowedSymlink": save 8 byte padding per side
+    {
+        FileAttributes() {}
+        FileAttributes(const FileDescriptor& descr) : lastWriteTimeRaw(descr.lastWriteTimeRaw), fileSize(descr.fileSize), fileId(descr.fileId) {}
 
-    FileDescriptor dataLeft;
-    FileDescriptor dataRight;
+        std::int64_t lastWriteTimeRaw = 0;
+        std::uint64_t fileSize = 0;
+        AFS::FileId fileId;
+    };
+
+    FileAttributes dataLeft;
+    FileAttributes dataRight;
 
     ObjectId moveFileRef = nullptr; //optional, filled by redetermineSyncDirection()
+
+    bool followedSymlinkLeft;
+    bool followedSymlinkRight;
 };
 
 //------------------------------------------------------------------
@@ -591,6 +873,9 @@ std::wstring getSyncOpDescription  (SyncOperation op);
 std::wstring getCategoryDescription(const FileSystemObject& fsObj);
 std::wstring getSyncOpDescription  (const FileSystemObject& fsObj);
 
+//statistics of a single item: child items of a folder are not included
+SubTreeStats getItemStats(const FileSystemObject& fsObj);
+
 //------------------------------------------------------------------
 
 template <class Function1, class Function2, class Function3>
@@ -661,17 +946,30 @@ inline
 std::wstring FileSystemObject::getCatExtraDescription() const
 {
     assert(getCategory() == FILE_CONFLICT || getCategory() == FILE_DIFFERENT_METADATA);
-    if (cmpResultDescr) //avoid ternary-WTF! (implicit copy-constructor call!!!!!!)
-        return *cmpResultDescr;
+    if (haveCmpResultDescr) //avoid ternary-WTF! (implicit copy-constructor call!!!!!!)
+        return getDescription(false /*syncDirConflict*/);
     return std::wstring();
 }
 
 
+inline
+void FilePair::notifySyncCfgChanged()
+{
+    FileSystemObject::notifySyncCfgChanged();
+
+    //sync operation of the move counterpart depends on this file, see applyMoveOptimization() => may be in a different sub tree
+    if (moveFileRef)
+        if (auto refFile = dynamic_cast<FilePair*>(FileSystemObject::retrieve(moveFileRef)))
+            refFile->FileSystemObject::notifySyncCfgChanged(); //do *not* make a virtual call: endless recursion!
+}
+
+
 inline
 void FileSystemObject::setSyncDir(SyncDirection newDir)
 {
     syncDir_ = newDir;
-    syncDirectionConflict.reset();
+    if (haveSyncDirConflict)
+        clearSyncDirConflict();
 
     notifySyncCfgChanged();
 }
@@ -681,7 +979,7 @@ inline
 void FileSystemObject::setSyncDirConflict(const std::wstring& description)
 {
     syncDir_ = SyncDirection::NONE;
-    syncDirectionConflict = std::make_unique<std::wstring>(description);
+    setDescription(true /*syncDirConflict*/, description);
 
     notifySyncCfgChanged();
 }
@@ -691,8 +989,8 @@ inline
 std::wstring FileSystemObject::getSyncOpConflict() const
 {
     assert(getSyncOperation() == SO_UNRESOLVED_CONFLICT);
-    if (syncDirectionConflict) //avoid ternary-WTF! (implicit copy-constructor call!!!!!!)
-        return *syncDirectionConflict;
+    if (haveSyncDirConflict) //avoid ternary-WTF! (implicit copy-constructor call!!!!!!)
+        return getDescription(true /*syncDirConflict*/);
     return std::wstring();
 }
 
@@ -805,14 +1103,14 @@ inline
 void FileSystemObject::setCategoryConflict(const std::wstring& description)
 {
     cmpResult = FILE_CONFLICT;
-    cmpResultDescr = std::make_unique<std::wstring>(description);
+    setDescription(false /*syncDirConflict*/, description);
 }
 
 inline
 void FileSystemObject::setCategoryDiffMetadata(const std::wstring& description)
 {
     cmpResult = FILE_DIFFERENT_METADATA;
-    cmpResultDescr = std::make_unique<std::wstring>(description);
+    setDescription(false /*syncDirConflict*/, description);
 }
 
 inline
@@ -999,6 +1297,7 @@ void FilePair::flip()
 {
     FileSystemObject::flip(); //call base class version
     std::swap(dataLeft, dataRight);
+    std::swap(followedSymlinkLeft, followedSymlinkRight);
 }
 
 
@@ -1026,7 +1325,7 @@ AFS::FileId FilePair::getFileId() const
 template <SelectedSide side> inline
 bool FilePair::isFollowedSymlink() const
 {
-    return SelectParam<side>::ref(dataLeft, dataRight).isFollowedSymlink;
+    return SelectParam<side>::ref(followedSymlinkLeft, followedSymlinkRight);
 }
 
 
@@ -1045,6 +1344,8 @@ void FilePair::setSyncedTo(const Zstring& itemName,
 
     SelectParam<sideTrg>::ref(dataLeft, dataRight) = FileDescriptor(lastWriteTimeTrg, fileSize, fileIdTrg, isSymlinkTrg);
     SelectParam<sideSrc>::ref(dataLeft, dataRight) = FileDescriptor(lastWriteTimeSrc, fileSize, fileIdSrc, isSymlinkSrc);
+    SelectParam<sideTrg>::ref(followedSymlinkLeft, followedSymlinkRight) = isSymlinkTrg;
+    SelectParam<sideSrc>::ref(followedSymlinkLeft, followedSymlinkRight) = isSymlinkSrc;
 
     moveFileRef = nullptr;
     FileSystemObject::setSynced(itemName); //set FileSystemObject specific part
@@ -1094,4 +1395,14 @@ void SymlinkPair::flip()
 }
 }
 
+
+namespace std
+{
+template <class T, bool isConst>
+struct hash<zen::ObjectIdT<T, isConst>>
+{
+    size_t operator()(const zen::ObjectIdT<T, isConst>& id) const { return id.hash(); }
+};
+}
+
 #endif //FILE_HIERARCHY_H_257235289645296
@@ -44,14 +44,23 @@ AFS::FileAttribAfterCopy AFS::copyFileAsStream(const Zstring& itemPathImplSource
 AFS::FileAttribAfterCopy AFS::copyFileTransactional(const AbstractPath& apSource, const AbstractPath& apTarget, //throw FileError, ErrorFileLocked
                                                     bool copyFilePermissions,
                                                     bool transactionalCopy,
+                                                    bool cloneIfPossible,
+                                                    bool deltaCopy,
                                                     const std::function<void()>& onDeleteTargetFile,
                                                     const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
 {
+    //caveat: typeid returns static type for pointers, dynamic type for references!!!
+    deltaCopy = deltaCopy && typeid(*apSource.afs) == typeid(*apTarget.afs);
+
     auto copyFileBestEffort = [&](const AbstractPath& apTargetTmp)
     {
+        if (deltaCopy) //reuse unchanged blocks of the existing target
+            if (Opt<FileAttribAfterCopy> attr = apSource.afs->copyFileDeltaForSameAfsType(apSource.itemPathImpl, apTarget, apTargetTmp, copyFilePermissions, notifyProgress)) //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                return *attr;
+
         //caveat: typeid returns static type for pointers, dynamic type for references!!!
         if (typeid(*apSource.afs) == typeid(*apTarget.afs))
-            return apSource.afs->copyFileForSameAfsType(apSource.itemPathImpl, apTargetTmp, copyFilePermissions, notifyProgress); //throw FileError, ErrorTargetExisting, ErrorFileLocked
+            return apSource.afs->copyFileForSameAfsType(apSource.itemPathImpl, apTargetTmp, copyFilePermissions, cloneIfPossible, notifyProgress); //throw FileError, ErrorTargetExisting, ErrorFileLocked
 
         //fall back to stream-based file copy:
         if (copyFilePermissions)
@@ -107,6 +116,10 @@ AFS::FileAttribAfterCopy AFS::copyFileTransactional(const AbstractPath& apSource
                 -> allow for true delete before copy to handle low disk space problems
                 -> higher performance on non-buffered drives (e.g. usb sticks)
         */
+        if (deltaCopy) //no deletion: the target is updated in place
+            if (Opt<FileAttribAfterCopy> attr = apSource.afs->copyFileDeltaForSameAfsType(apSource.itemPathImpl, apTarget, apTarget, copyFilePermissions, notifyProgress)) //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                return *attr;
+
         if (onDeleteTargetFile)
             onDeleteTargetFile();
 
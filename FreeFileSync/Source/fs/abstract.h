@@ -226,6 +226,9 @@ struct AbstractFileSystem //THREAD-SAFETY: "const" member functions must model t
     static FileAttribAfterCopy copyFileTransactional(const AbstractPath& apSource, const AbstractPath& apTarget, //throw FileError, ErrorFileLocked
                                                      bool copyFilePermissions,
                                                      bool transactionalCopy,
+                                                     bool cloneIfPossible, //share data blocks copy-on-write if supported (native: btrfs, XFS)
+                                                     bool deltaCopy, //existing target: write only changed blocks if supported (native: Linux)
+                                                     //=> transactionalCopy == false: target is updated in place and onDeleteTargetFile is NOT called!
                                                      //if target is existing user needs to implement deletion: copyFile() NEVER overwrites target if already existing!
                                                      //if transactionalCopy == true, full read access on source had been proven at this point, so it's safe to delete it.
                                                      const std::function<void()>& onDeleteTargetFile,
@@ -320,10 +323,15 @@ private:
     //----------------------------------------------------------------------------------------------------------------
 
     //symlink handling: follow link!
-    virtual FileAttribAfterCopy copyFileForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+    virtual FileAttribAfterCopy copyFileForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions, bool cloneIfPossible, //throw FileError, ErrorTargetExisting, ErrorFileLocked
                                                        //accummulated delta != file size! consider ADS, sparse, compressed files
                                                        const std::function<void(std::int64_t bytesDelta)>& notifyProgress) const = 0; //may be nullptr; throw X!
 
+    //symlink handling: follow link!
+    //apBase == apTarget: update in place, else: create apTarget based on apBase; returns NoValue() if not supported
+    virtual Opt<FileAttribAfterCopy> copyFileDeltaForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apBase, const AbstractPath& apTarget, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                                                                 const std::function<void(std::int64_t bytesDelta)>& notifyProgress) const = 0; //may be nullptr; throw X!
+
     //symlink handling: follow link!
     virtual void copyNewFolderForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions) const = 0; //throw FileError
     virtual void copySymlinkForSameAfsType  (const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions) const = 0; //throw FileError
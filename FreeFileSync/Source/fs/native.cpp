@@ -384,13 +384,13 @@ private:
     //----------------------------------------------------------------------------------------------------------------
 
     //symlink handling: follow link!
-    FileAttribAfterCopy copyFileForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+    FileAttribAfterCopy copyFileForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions, bool cloneIfPossible, //throw FileError, ErrorTargetExisting, ErrorFileLocked
                                                const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus) const override //may be nullptr; throw X!
     {
         initComForThread(); //throw FileError
 
         const InSyncAttributes attrNew = copyNewFile(itemPathImplSource, getItemPathImpl(apTarget), //throw FileError, ErrorTargetExisting, ErrorFileLocked
-                                                     copyFilePermissions, onNotifyCopyStatus); //may be nullptr; throw X!
+                                                     copyFilePermissions, cloneIfPossible, onNotifyCopyStatus); //may be nullptr; throw X!
         FileAttribAfterCopy attrOut;
         attrOut.fileSize         = attrNew.fileSize;
         attrOut.modificationTime = attrNew.modificationTime;
@@ -399,6 +399,25 @@ private:
         return attrOut;
     }
 
+    //symlink handling: follow link!
+    Opt<FileAttribAfterCopy> copyFileDeltaForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apBase, const AbstractPath& apTarget, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                                                         const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus) const override //may be nullptr; throw X!
+    {
+        initComForThread(); //throw FileError
+
+        const Opt<InSyncAttributes> attrNew = copyFileDelta(itemPathImplSource, getItemPathImpl(apBase), getItemPathImpl(apTarget), //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                                                            copyFilePermissions, onNotifyCopyStatus); //may be nullptr; throw X!
+        if (!attrNew)
+            return NoValue();
+
+        FileAttribAfterCopy attrOut;
+        attrOut.fileSize         = attrNew->fileSize;
+        attrOut.modificationTime = attrNew->modificationTime;
+        attrOut.sourceFileId     = convertToAbstractFileId(attrNew->sourceFileId);
+        attrOut.targetFileId     = convertToAbstractFileId(attrNew->targetFileId);
+        return attrOut;
+    }
+
     //symlink handling: follow link!
     void copyNewFolderForSameAfsType(const Zstring& itemPathImplSource, const AbstractPath& apTarget, bool copyFilePermissions) const override //throw FileError
     {
@@ -7,9 +7,26 @@
 #include <zen/sys_error.h>
 #include <zen/symlink_target.h>
 
-#include <cstddef> //offsetof
+#include <atomic>
 #include <sys/stat.h>
-#include <dirent.h>
+#include <sys/syscall.h> //SYS_getdents64
+#include <sys/sysmacros.h> //makedev
+#include <dirent.h> //DT_DIR
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/vfs.h> //fstatfs
+#include <linux/magic.h> //NFS_SUPER_MAGIC
+
+#if defined __has_include
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>
+    #endif
+#endif
+
+#if defined IORING_FEAT_RW_CUR_POS && defined STATX_BASIC_STATS && defined __NR_io_uring_setup //kernel headers 5.6+: IORING_OP_STATX
+    #define HAVE_IO_URING
+#endif
 
 //implementation header for native.cpp, not for reuse!!!
 
@@ -31,6 +48,297 @@ AFS::FileId convertToAbstractFileId(const zen::FileId& fid)
 }
 
 
+//batched directory reading: avoid per-item path resolution and user-space copies of readdir()
+struct LinuxDirent64 //not provided by glibc headers (before glibc 2.30)
+{
+    ino64_t        d_ino;
+    off64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[1]; //variable length, null-terminated
+};
+
+
+struct ItemStat
+{
+    mode_t         mode = 0;
+    std::uint64_t  size = 0;
+    std::int64_t   lastWriteTime = 0; //number of seconds since Jan. 1st 1970 UTC
+    zen::FileId    id;
+};
+
+
+#ifdef STATX_BASIC_STATS //glibc 2.28+
+const unsigned int STATX_MASK_NEEDED = STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME | STATX_INO;
+
+inline
+ItemStat toItemStat(const struct ::statx& statData)
+{
+    ItemStat st;
+    st.mode          = statData.stx_mode;
+    st.size          = statData.stx_size;
+    st.lastWriteTime = statData.stx_mtime.tv_sec;
+    st.id            = extractFileId(makedev(statData.stx_dev_major, statData.stx_dev_minor), statData.stx_ino);
+    return st;
+}
+#endif
+
+
+//stat relative to open directory: no path resolution; statx() requests only the needed attributes
+template <class Function> //getErrorMsg: build error message (and item path) lazily
+ItemStat getItemStatAt(int dirFd, const char* itemName, bool followSymlink, Function getErrorMsg) //throw FileError
+{
+#ifdef STATX_BASIC_STATS
+    static std::atomic<bool> statxUnsupported(false); //kernel < 4.11 => ENOSYS
+    if (!statxUnsupported)
+    {
+        struct ::statx statData = {};
+        if (::statx(dirFd, itemName, followSymlink ? 0 : AT_SYMLINK_NOFOLLOW, STATX_MASK_NEEDED, &statData) == 0)
+            return toItemStat(statData);
+        if (errno != ENOSYS)
+            THROW_LAST_FILE_ERROR(getErrorMsg(), L"statx");
+        statxUnsupported = true;
+    }
+#endif
+    struct ::stat statData = {};
+    if (::fstatat(dirFd, itemName, &statData, followSymlink ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+        THROW_LAST_FILE_ERROR(getErrorMsg(), L"fstatat");
+
+    ItemStat st;
+    st.mode          = statData.st_mode;
+    st.size          = makeUnsigned(statData.st_size);
+    st.lastWriteTime = statData.st_mtime;
+    st.id            = extractFileId(statData);
+    return st;
+}
+
+
+#ifdef HAVE_IO_URING
+/*
+asynchronous stat pipeline: on network file systems a blocking stat per item costs one round trip each
+=> submit IORING_OP_STATX for all items of a directory at once and let the server process them concurrently
+
+- no liburing dependency: the three ring buffers are mapped manually
+- io_uring may be unavailable (kernel < 5.6, seccomp in containers, sysctl kernel.io_uring_disabled) => caller falls back to synchronous statx
+*/
+class StatRing
+{
+public:
+    static StatRing* getForCurrentThread() //returns nullptr if io_uring is not available
+    {
+        static std::atomic<bool> ringUnsupported(false);
+        thread_local std::unique_ptr<StatRing> ring; //worker threads traverse one directory after another: set up ring only once
+
+        if (ring && ring->ringBroken_)
+        {
+            if (ring->requestsPending_) //kernel may still write into statBuf_ => abandon the ring rather than unmapping memory in use
+            {
+                ring.release(); //intentional leak
+                ringUnsupported = true; //io_uring_enter() failed persistently: don't risk leaking again
+            }
+            else
+                ring.reset();
+        }
+
+        if (!ring && !ringUnsupported)
+        {
+            ring = create();
+            if (!ring)
+                ringUnsupported = true;
+        }
+        return ring.get();
+    }
+
+    ~StatRing()
+    {
+        if (sqes_)
+            ::munmap(sqes_, sqesSize_);
+        if (cqRing_ && cqRing_ != sqRing_)
+            ::munmap(cqRing_, cqRingSize_);
+        if (sqRing_)
+            ::munmap(sqRing_, sqRingSize_);
+        ::close(ringFd_);
+    }
+
+    //statx() (not following symlinks) for all items relative to dirFd; item order is preserved
+    //returns false if the ring failed as a whole: results are incomplete => caller should fall back to synchronous stat
+    bool statBatch(int dirFd, const std::vector<const char*>& itemNames, std::vector<struct ::statx>& statOut, std::vector<int>& errorOut) //errorOut: 0 or errno per item
+    {
+        statOut .resize(itemNames.size());
+        errorOut.assign(itemNames.size(), EINVAL);
+
+        for (size_t pos = 0; pos < itemNames.size(); pos += sqEntries_) //CQ ring holds at least sqEntries_ completions => no overflow
+            if (!statBlock(dirFd, &itemNames[pos], &statOut[pos], &errorOut[pos], std::min<size_t>(sqEntries_, itemNames.size() - pos)))
+                return false;
+        return true;
+    }
+
+private:
+    explicit StatRing(int ringFd) : ringFd_(ringFd) {}
+    StatRing           (const StatRing&) = delete;
+    StatRing& operator=(const StatRing&) = delete;
+
+    static std::unique_ptr<StatRing> create()
+    {
+        struct ::io_uring_params params = {};
+        const int ringFd = ::syscall(__NR_io_uring_setup, 256 /*entries*/, &params);
+        if (ringFd == -1)
+            return nullptr; //ENOSYS, EPERM, ENOMEM (RLIMIT_MEMLOCK on kernel < 5.12)
+
+        std::unique_ptr<StatRing> ring(new StatRing(ringFd));
+
+        if (!supportsStatx(ringFd))
+            return nullptr;
+
+        ring->sqEntries_  = params.sq_entries;
+        ring->sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqRingSize_ = params.cq_off.cqes  + params.cq_entries * sizeof(struct ::io_uring_cqe);
+        ring->sqesSize_   = params.sq_entries * sizeof(struct ::io_uring_sqe);
+        ring->statBuf_.resize(params.sq_entries);
+
+        const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap)
+            ring->sqRingSize_ = ring->cqRingSize_ = std::max(ring->sqRingSize_, ring->cqRingSize_);
+
+        auto mapRegion = [&](size_t size, off_t offset) -> char*
+        {
+            void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+            return addr == MAP_FAILED ? nullptr : static_cast<char*>(addr);
+        };
+
+        if (!(ring->sqRing_ = mapRegion(ring->sqRingSize_, IORING_OFF_SQ_RING)))
+            return nullptr;
+        if (!(ring->cqRing_ = singleMmap ? ring->sqRing_ : mapRegion(ring->cqRingSize_, IORING_OFF_CQ_RING)))
+            return nullptr;
+        if (!(ring->sqes_ = reinterpret_cast<struct ::io_uring_sqe*>(mapRegion(ring->sqesSize_, IORING_OFF_SQES))))
+            return nullptr;
+
+        ring->sqTail_  = reinterpret_cast<unsigned*>(ring->sqRing_ + params.sq_off.tail);
+        ring->sqMask_  = *reinterpret_cast<unsigned*>(ring->sqRing_ + params.sq_off.ring_mask);
+        ring->sqArray_ = reinterpret_cast<unsigned*>(ring->sqRing_ + params.sq_off.array);
+        ring->cqHead_  = reinterpret_cast<unsigned*>(ring->cqRing_ + params.cq_off.head);
+        ring->cqTail_  = reinterpret_cast<unsigned*>(ring->cqRing_ + params.cq_off.tail);
+        ring->cqMask_  = *reinterpret_cast<unsigned*>(ring->cqRing_ + params.cq_off.ring_mask);
+        ring->cqes_    = reinterpret_cast<struct ::io_uring_cqe*>(ring->cqRing_ + params.cq_off.cqes);
+        return ring;
+    }
+
+    static bool supportsStatx(int ringFd) //io_uring exists since kernel 5.1, IORING_OP_STATX since 5.6
+    {
+        std::vector<char> buf(sizeof(struct ::io_uring_probe) + IORING_OP_LAST * sizeof(struct ::io_uring_probe_op));
+        auto& probe = reinterpret_cast<struct ::io_uring_probe&>(buf[0]);
+
+        if (::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, &probe, IORING_OP_LAST) != 0)
+            return false; //EINVAL: kernel < 5.6
+
+        return IORING_OP_STATX <= probe.last_op &&
+               (probe.ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    bool statBlock(int dirFd, const char* const* itemNames, struct ::statx* statOut, int* errorOut, size_t itemCount)
+    {
+        unsigned sqTail = *sqTail_; //only written by us
+        for (size_t i = 0; i < itemCount; ++i)
+        {
+            const unsigned idx = sqTail & sqMask_;
+            struct ::io_uring_sqe& sqe = sqes_[idx];
+            sqe = {};
+            sqe.opcode      = IORING_OP_STATX;
+            sqe.fd          = dirFd;
+            sqe.addr        = reinterpret_cast<std::uintptr_t>(itemNames[i]);
+            sqe.len         = STATX_MASK_NEEDED;
+            sqe.off         = reinterpret_cast<std::uintptr_t>(&statBuf_[i]); //not statOut: must stay valid if the ring is abandoned
+            sqe.statx_flags = AT_SYMLINK_NOFOLLOW;
+            sqe.user_data   = i;
+            sqArray_[idx] = idx;
+            ++sqTail;
+        }
+        __atomic_store_n(sqTail_, sqTail, __ATOMIC_RELEASE);
+
+        size_t toSubmit  = itemCount;
+        size_t completed = 0;
+        size_t failCount = 0; //consecutive failed io_uring_enter() calls
+        while (completed < itemCount)
+        {
+            const int rv = ::syscall(__NR_io_uring_enter, ringFd_, toSubmit, 1 /*min_complete*/, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (rv < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                if (++failCount >= ENTER_RETRY_MAX || //e.g. persistent EAGAIN, EBADFD
+                    toSubmit + completed == itemCount) //nothing in flight: no need to wait
+                {
+                    ringBroken_ = true; //unsubmitted entries are still queued => discard ring
+                    requestsPending_ = toSubmit + completed != itemCount;
+                    return false;
+                }
+                toSubmit = 0; //keep waiting for what was submitted already
+                continue;
+            }
+            failCount = 0;
+            toSubmit -= std::min<size_t>(rv, toSubmit);
+
+            unsigned cqHead = *cqHead_; //only written by us
+            const unsigned cqTail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+            for (; cqHead != cqTail; ++cqHead, ++completed)
+            {
+                const struct ::io_uring_cqe& cqe = cqes_[cqHead & cqMask_];
+                errorOut[cqe.user_data] = cqe.res < 0 ? -cqe.res : 0;
+            }
+            __atomic_store_n(cqHead_, cqHead, __ATOMIC_RELEASE);
+        }
+        std::copy(statBuf_.begin(), statBuf_.begin() + itemCount, statOut);
+        return true;
+    }
+
+    static const size_t ENTER_RETRY_MAX = 10;
+
+    const int ringFd_;
+    bool ringBroken_ = false;
+    bool requestsPending_ = false; //ring broken while submitted statx requests were not yet completed
+    unsigned sqEntries_ = 0;
+    std::vector<struct ::statx> statBuf_; //one per SQ entry
+
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_   = 0;
+    char* sqRing_ = nullptr;
+    char* cqRing_ = nullptr;
+    struct ::io_uring_sqe* sqes_ = nullptr;
+
+    unsigned* sqTail_  = nullptr;
+    unsigned  sqMask_  = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_  = nullptr;
+    unsigned* cqTail_  = nullptr;
+    unsigned  cqMask_  = 0;
+    struct ::io_uring_cqe* cqes_ = nullptr;
+};
+
+
+//latency-bound file systems: one round trip per stat
+inline
+bool isNetworkFileSystem(int dirFd)
+{
+    struct ::statfs fsInfo = {};
+    if (::fstatfs(dirFd, &fsInfo) != 0)
+        return false;
+
+    switch (static_cast<unsigned long>(fsInfo.f_type))
+    {
+        case NFS_SUPER_MAGIC:
+        case 0xFF534D42: //CIFS_MAGIC_NUMBER
+        case 0xFE534D42: //SMB2_MAGIC_NUMBER
+        case 0x517B:     //SMB_SUPER_MAGIC
+        case 0x65735546: //FUSE_SUPER_MAGIC, e.g. sshfs
+            return true;
+    }
+    return false;
+}
+#endif
+
+
 class DirTraverser
 {
 public:
@@ -40,125 +348,182 @@ public:
     }
 
 private:
-    DirTraverser(const Zstring& baseDirectory, AFS::TraverserCallback& sink)
+    DirTraverser(const Zstring& baseDirectory, AFS::TraverserCallback& sink) : buffer(64 * 1024) //getdents64(): fill buffer with as many items as fit
     {
-        /* quote: "Since POSIX.1 does not specify the size of the d_name field, and other nonstandard fields may precede
-                   that field within the dirent structure, portable applications that use readdir_r() should allocate
-                   the buffer whose address is passed in entry as follows:
-                       len = offsetof(struct dirent, d_name) + pathconf(dirPath, _PC_NAME_MAX) + 1
-                       entryp = malloc(len); */
-        const size_t nameMax = std::max<long>(::pathconf(baseDirectory.c_str(), _PC_NAME_MAX), 10000); //::pathconf may return long(-1)
-        buffer.resize(offsetof(struct ::dirent, d_name) + nameMax + 1);
-
         traverse(baseDirectory, sink);
     }
 
     DirTraverser           (const DirTraverser&) = delete;
     DirTraverser& operator=(const DirTraverser&) = delete;
 
+    using SubDirList = std::vector<std::pair<Zstring, std::unique_ptr<AFS::TraverserCallback>>>; //item name, callback
+
     void traverse(const Zstring& dirPath, AFS::TraverserCallback& sink)
     {
+        SubDirList subDirs;
         tryReportingDirError([&]
         {
-            traverseWithException(dirPath, sink); //throw FileError
+            traverseWithException(dirPath, sink, subDirs); //throw FileError
         }, sink);
+
+        //recurse *after* directory handle was closed: shared buffer, no open handle per directory level
+        for (auto& subDir : subDirs)
+            traverse(appendSeparator(dirPath) + subDir.first, *subDir.second);
     }
 
-    void traverseWithException(const Zstring& dirPath, AFS::TraverserCallback& sink) //throw FileError
+    void traverseWithException(const Zstring& dirPath, AFS::TraverserCallback& sink, SubDirList& subDirs) //throw FileError
     {
         //no need to check for endless recursion: Linux has a fixed limit on the number of symbolic links in a path
+        subDirs.clear(); //restart dir traversal on retry
 
-        DIR* dirObj = ::opendir(dirPath.c_str()); //directory must NOT end with path separator, except "/"
-        if (!dirObj)
-            THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot open directory %x."), L"%x", fmtPath(dirPath)), L"opendir");
-        ZEN_ON_SCOPE_EXIT(::closedir(dirObj)); //never close nullptr handles! -> crash
+        const int dirFd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC); //directory must NOT end with path separator, except "/"
+        if (dirFd == -1)
+            THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot open directory %x."), L"%x", fmtPath(dirPath)), L"open");
+        ZEN_ON_SCOPE_EXIT(::close(dirFd));
+
+#ifdef HAVE_IO_URING
+        StatRing* statRing = isNetworkFileSystem(dirFd) ? StatRing::getForCurrentThread() : nullptr;
+        //local file systems: a synchronous statx() on a cached inode is cheaper than the hand-off to an io_uring worker thread
+#endif
+        itemNames.clear();
 
         for (;;)
         {
-            struct ::dirent* dirEntry = nullptr;
-            if (::readdir_r(dirObj, reinterpret_cast< ::dirent*>(&buffer[0]), &dirEntry) != 0)
-                THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot enumerate directory %x."), L"%x", fmtPath(dirPath)), L"readdir_r");
+            const long bytesRead = ::syscall(SYS_getdents64, dirFd, &buffer[0], buffer.size());
+            if (bytesRead < 0)
+                THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot enumerate directory %x."), L"%x", fmtPath(dirPath)), L"getdents64");
             //don't retry but restart dir traversal on error! http://blogs.msdn.com/b/oldnewthing/archive/2014/06/12/10533529.aspx
 
-            if (!dirEntry) //no more items
-                return;
+            if (bytesRead == 0) //no more items
+                break;
+
+            for (long bytePos = 0; bytePos < bytesRead;)
+            {
+                const auto& dirEntry = reinterpret_cast<const LinuxDirent64&>(buffer[bytePos]);
+                bytePos += dirEntry.d_reclen;
 
-            //don't return "." and ".."
-            const char* itemName = dirEntry->d_name; //evaluate dirEntry *before* going into recursion => we use a single "buffer"!
+                //don't return "." and ".."
+                const char* itemName = dirEntry.d_name;
 
-            if (itemName[0] == 0) throw FileError(replaceCpy(_("Cannot enumerate directory %x."), L"%x", fmtPath(dirPath)), L"readdir_r: Data corruption; item is missing a name.");
-            if (itemName[0] == '.' &&
-                (itemName[1] == 0 || (itemName[1] == '.' && itemName[2] == 0)))
-                continue;
+                if (itemName[0] == 0) throw FileError(replaceCpy(_("Cannot enumerate directory %x."), L"%x", fmtPath(dirPath)), L"getdents64: Data corruption; item is missing a name.");
+                if (itemName[0] == '.' &&
+                    (itemName[1] == 0 || (itemName[1] == '.' && itemName[2] == 0)))
+                    continue;
 
-			const Zstring& itemPath = appendSeparator(dirPath) + itemName;
+                if (dirEntry.d_type == DT_DIR) //no metadata needed for directories: skip stat
+                {
+                    if (std::unique_ptr<AFS::TraverserCallback> trav = sink.onDir({ itemName }))
+                        subDirs.emplace_back(itemName, std::move(trav));
+                    continue;
+                }
+#ifdef HAVE_IO_URING
+                if (statRing) //defer until all names are known: "buffer" is overwritten by next getdents64()
+                {
+                    itemNames.emplace_back(itemName);
+                    continue;
+                }
+#endif
+                processItem(dirFd, dirPath, itemName, nullptr /*prefetchedStat*/, sink, subDirs); //throw X
+            }
+        }
 
-            struct ::stat statData = {};
-            if (!tryReportingItemError([&]
+#ifdef HAVE_IO_URING
+        if (!itemNames.empty())
         {
-            if (::lstat(itemPath.c_str(), &statData) != 0) //lstat() does not resolve symlinks
-                    THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot read file attributes of %x."), L"%x", fmtPath(itemPath)), L"lstat");
-            }, sink, itemName))
-            continue; //ignore error: skip file
+            std::vector<const char*> itemNamesRaw;
+            for (const Zstring& itemName : itemNames)
+                itemNamesRaw.push_back(itemName.c_str());
+
+            std::vector<struct ::statx> statBuf;
+            std::vector<int> statErrors;
+            const bool ringOk = statRing->statBatch(dirFd, itemNamesRaw, statBuf, statErrors);
 
-            if (S_ISLNK(statData.st_mode)) //on Linux there is no distinction between file and directory symlinks!
+            for (size_t i = 0; i < itemNames.size(); ++i)
+                if (ringOk && statErrors[i] == 0)
+                {
+                    const ItemStat prefetchedStat = toItemStat(statBuf[i]);
+                    processItem(dirFd, dirPath, itemNamesRaw[i], &prefetchedStat, sink, subDirs); //throw X
+                }
+                else //retry synchronously: report error with the regular error message
+                    processItem(dirFd, dirPath, itemNamesRaw[i], nullptr, sink, subDirs); //throw X
+        }
+#endif
+    }
+
+    void processItem(int dirFd, const Zstring& dirPath, const char* itemName, const ItemStat* prefetchedStat, AFS::TraverserCallback& sink, SubDirList& subDirs)
+    {
+        ItemStat statData;
+        if (prefetchedStat)
+            statData = *prefetchedStat;
+        else if (!tryReportingItemError([&]
+    {
+        statData = getItemStatAt(dirFd, itemName, false /*followSymlink*/, [&] //throw FileError; does not resolve symlinks
             {
-                const AFS::TraverserCallback::SymlinkInfo linkInfo = { itemName, statData.st_mtime };
+                return replaceCpy(_("Cannot read file attributes of %x."), L"%x", fmtPath(appendSeparator(dirPath) + itemName));
+            });
+        }, sink, itemName))
+        return; //ignore error: skip file
+
+        if (S_ISLNK(statData.mode)) //on Linux there is no distinction between file and directory symlinks!
+        {
+            const AFS::TraverserCallback::SymlinkInfo linkInfo = { itemName, statData.lastWriteTime };
 
-                switch (sink.onSymlink(linkInfo))
+            switch (sink.onSymlink(linkInfo))
+            {
+                case AFS::TraverserCallback::LINK_FOLLOW:
                 {
-                    case AFS::TraverserCallback::LINK_FOLLOW:
-                    {
-                        //try to resolve symlink (and report error on failure!!!)
-                        struct ::stat statDataTrg = {};
+                    //try to resolve symlink (and report error on failure!!!)
+                    ItemStat statDataTrg;
 
-                        bool validLink = tryReportingItemError([&]
+                    bool validLink = tryReportingItemError([&]
+                    {
+                        statDataTrg = getItemStatAt(dirFd, itemName, true /*followSymlink*/, [&] //throw FileError
                         {
-                            if (::stat(itemPath.c_str(), &statDataTrg) != 0)
-                                THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot resolve symbolic link %x."), L"%x", fmtPath(itemPath)), L"stat");
-                        }, sink, itemName);
+                            return replaceCpy(_("Cannot resolve symbolic link %x."), L"%x", fmtPath(appendSeparator(dirPath) + itemName));
+                        });
+                    }, sink, itemName);
 
-                        if (validLink)
+                    if (validLink)
+                    {
+                        if (S_ISDIR(statDataTrg.mode)) //a directory
+                        {
+                            if (std::unique_ptr<AFS::TraverserCallback> trav = sink.onDir({ itemName }))
+                                subDirs.emplace_back(itemName, std::move(trav));
+                        }
+                        else //a file or named pipe, ect.
                         {
-                            if (S_ISDIR(statDataTrg.st_mode)) //a directory
-                            {
-                                if (std::unique_ptr<AFS::TraverserCallback> trav = sink.onDir({ itemName }))
-                                    traverse(itemPath, *trav);
-                            }
-                            else //a file or named pipe, ect.
-                            {
-                                AFS::TraverserCallback::FileInfo fi = { itemName, makeUnsigned(statDataTrg.st_size), statDataTrg.st_mtime, convertToAbstractFileId(extractFileId(statDataTrg)), &linkInfo };
-                                sink.onFile(fi);
-                            }
+                            AFS::TraverserCallback::FileInfo fi = { itemName, statDataTrg.size, statDataTrg.lastWriteTime, convertToAbstractFileId(statDataTrg.id), &linkInfo };
+                            sink.onFile(fi);
                         }
-                        // else //broken symlink -> ignore: it's client's responsibility to handle error!
                     }
-                    break;
-
-                    case AFS::TraverserCallback::LINK_SKIP:
-                        break;
+                    // else //broken symlink -> ignore: it's client's responsibility to handle error!
                 }
-            }
-            else if (S_ISDIR(statData.st_mode)) //a directory
-            {
-                if (std::unique_ptr<AFS::TraverserCallback> trav = sink.onDir({ itemName }))
-                    traverse(itemPath, *trav);
-            }
-            else //a file or named pipe, ect.
-            {
-                AFS::TraverserCallback::FileInfo fi = { itemName, makeUnsigned(statData.st_size), statData.st_mtime, convertToAbstractFileId(extractFileId(statData)), nullptr /*symlinkInfo*/ };
-                sink.onFile(fi);
-            }
-            /*
-            It may be a good idea to not check "S_ISREG(statData.st_mode)" explicitly and to not issue an error message on other types to support these scenarios:
-            - RTS setup watch (essentially wants to read directories only)
-            - removeDirectory (wants to delete everything; pipes can be deleted just like files via "unlink")
+                break;
 
-            However an "open" on a pipe will block (https://sourceforge.net/p/freefilesync/bugs/221/), so the copy routines need to be smarter!!
-            */
+                case AFS::TraverserCallback::LINK_SKIP:
+                    break;
+            }
+        }
+        else if (S_ISDIR(statData.mode)) //a directory (d_type == DT_UNKNOWN: not supported by all file systems)
+        {
+            if (std::unique_ptr<AFS::TraverserCallback> trav = sink.onDir({ itemName }))
+                subDirs.emplace_back(itemName, std::move(trav));
+        }
+        else //a file or named pipe, ect.
+        {
+            AFS::TraverserCallback::FileInfo fi = { itemName, statData.size, statData.lastWriteTime, convertToAbstractFileId(statData.id), nullptr /*symlinkInfo*/ };
+            sink.onFile(fi);
         }
+        /*
+        It may be a good idea to not check "S_ISREG(statData.st_mode)" explicitly and to not issue an error message on other types to support these scenarios:
+        - RTS setup watch (essentially wants to read directories only)
+        - removeDirectory (wants to delete everything; pipes can be deleted just like files via "unlink")
+
+        However an "open" on a pipe will block (https://sourceforge.net/p/freefilesync/bugs/221/), so the copy routines need to be smarter!!
+        */
     }
 
     std::vector<char> buffer;
+    std::vector<Zstring> itemNames; //io_uring: all non-directory items of the current directory
 };
 }
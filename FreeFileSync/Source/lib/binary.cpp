@@ -6,7 +6,9 @@
 
 #include "binary.h"
 #include <vector>
+#include <deque>
 #include <chrono>
+#include <zen/thread.h>
 //#include <zen/tick_count.h>
 
 using namespace zen;
@@ -31,46 +33,95 @@ buffer  MB/s
 2048    56
 4096    56
 8192    56
+
+3. Each file is read by a thread of its own with a double-buffered read-ahead: both devices are streaming at the same time
+   while the calling thread is comparing. std::equal() on char ranges resolves to the (vectorized) memcmp() of the C runtime.
 */
 
 const size_t BLOCK_SIZE_MAX =  16 * 1024 * 1024;
 
 
-struct StreamReader
+//read blocks of a single file on a separate thread: allows both files to be read in parallel instead of alternating between the two devices
+class ReadAheadBuffer
 {
-    StreamReader(const AbstractPath& filePath, const std::function<void(std::int64_t bytesDelta)>& notifyProgress, size_t& unevenBytes) :
-        stream(AFS::getInputStream(filePath)), //throw FileError, (ErrorFileLocked)
-        defaultBlockSize(stream->getBlockSize()),
-        dynamicBlockSize(defaultBlockSize),
-        notifyProgress_(notifyProgress),
-        unevenBytes_(unevenBytes) {}
+public:
+    //context of reader thread: returns when a slot is available
+    void putBlock(std::vector<char>&& block) //throw ThreadInterruption
+    {
+        {
+            std::unique_lock<std::mutex> dummy(lockBlocks);
+            interruptibleWait(conditionSlotFree, dummy, [this] { return blocks.size() < SLOT_COUNT; }); //throw ThreadInterruption
+            blocks.push_back(std::move(block));
+        }
+        conditionBlockReady.notify_all(); //instead of notify_one(); workaround bug: https://svn.boost.org/trac/boost/ticket/7796
+    }
 
-    void appendChunk(std::vector<char>& buffer) //throw FileError
+    void putError(const FileError& e) //context of reader thread
     {
-        assert(!eof);
-        if (eof) return;
+        {
+            std::lock_guard<std::mutex> dummy(lockBlocks);
+            readError = std::make_unique<FileError>(e);
+        }
+        conditionBlockReady.notify_all();
+    }
 
-        const auto startTime = std::chrono::steady_clock::now();
+    //context of comparing thread: blocks until the next chunk of data is available; empty block means EOF
+    std::vector<char> takeBlock() //throw FileError
+    {
+        std::vector<char> block;
+        {
+            std::unique_lock<std::mutex> dummy(lockBlocks);
+            //not interruptible: called by main thread, too => reader thread guarantees progress
+            conditionBlockReady.wait(dummy, [this] { return !blocks.empty() || readError; });
+
+            if (blocks.empty())
+                throw *readError; //report error after all blocks read successfully
+            block = std::move(blocks.front());
+            blocks.pop_front();
+        }
+        conditionSlotFree.notify_all();
+        return block;
+    }
 
-        buffer.resize(buffer.size() + dynamicBlockSize);
-        const size_t bytesRead = stream->tryRead(&*(buffer.end() - dynamicBlockSize), dynamicBlockSize); //throw FileError; may return short, only 0 means EOF! => CONTRACT: bytesToRead > 0
-        buffer.resize(buffer.size() - dynamicBlockSize + bytesRead); //caveat: unsigned arithmetics
+private:
+    static const size_t SLOT_COUNT = 2; //double buffering: keep reading while the current block is compared
 
-        const auto stopTime = std::chrono::steady_clock::now();
+    std::mutex lockBlocks;
+    std::condition_variable conditionBlockReady;
+    std::condition_variable conditionSlotFree;
+    std::deque<std::vector<char>> blocks;
+    std::unique_ptr<FileError> readError;
+};
 
-        //report bytes processed
-        if (notifyProgress_)
+
+//context of reader thread
+void readAhead(AFS::InputStream& stream, ReadAheadBuffer& readBuf) //throw ThreadInterruption
+{
+    const size_t defaultBlockSize = stream.getBlockSize();
+    size_t dynamicBlockSize = defaultBlockSize;
+    auto lastDelayViolation = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+        std::vector<char> block(dynamicBlockSize);
+
+        const auto startTime = std::chrono::steady_clock::now();
+        try
         {
-            const size_t bytesToReport = (unevenBytes_ + bytesRead) / 2;
-            notifyProgress_(bytesToReport); //throw X!
-            unevenBytes_ = (unevenBytes_ + bytesRead) - bytesToReport * 2; //unsigned arithmetics!
+            const size_t bytesRead = stream.tryRead(&block[0], block.size()); //throw FileError; may return short, only 0 means EOF! => CONTRACT: bytesToRead > 0
+            block.resize(bytesRead);
         }
-
-        if (bytesRead == 0)
+        catch (const FileError& e)
         {
-            eof = true;
+            readBuf.putError(e);
             return;
         }
+        const auto stopTime = std::chrono::steady_clock::now();
+
+        const bool eof = block.empty();
+        readBuf.putBlock(std::move(block)); //throw ThreadInterruption
+        if (eof)
+            return;
 
         size_t proposedBlockSize = 0;
         const auto loopTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(stopTime - startTime).count();
@@ -90,17 +141,64 @@ struct StreamReader
         if (defaultBlockSize <= proposedBlockSize && proposedBlockSize <= BLOCK_SIZE_MAX)
             dynamicBlockSize = proposedBlockSize;
     }
+}
+
+
+struct StreamReader
+{
+    StreamReader(const AbstractPath& filePath, const std::function<void(std::int64_t bytesDelta)>& notifyProgress, size_t& unevenBytes) :
+        notifyProgress_(notifyProgress),
+        unevenBytes_(unevenBytes)
+    {
+        std::shared_ptr<AFS::InputStream> stream = AFS::getInputStream(filePath); //throw FileError, (ErrorFileLocked)
+        std::shared_ptr<ReadAheadBuffer> readBuf = readBuf_;
+
+        readerThread = InterruptibleThread([stream, readBuf]
+        {
+#ifdef ZEN_WIN
+            setCurrentThreadName("Binary Read Ahead");
+#endif
+            readAhead(*stream, *readBuf); //throw ThreadInterruption
+        });
+    }
+
+    ~StreamReader()
+    {
+        readerThread.interrupt(); //comparison may end early: don't read the rest of the file
+        readerThread.join();
+    }
+
+    void appendChunk(std::vector<char>& buffer) //throw FileError
+    {
+        assert(!eof);
+        if (eof) return;
+
+        const std::vector<char> block = readBuf_->takeBlock(); //throw FileError
+        buffer.insert(buffer.end(), block.begin(), block.end());
+
+        //report bytes processed: context of calling thread!
+        if (notifyProgress_)
+        {
+            const size_t bytesToReport = (unevenBytes_ + block.size()) / 2;
+            notifyProgress_(bytesToReport); //throw X!
+            unevenBytes_ = (unevenBytes_ + block.size()) - bytesToReport * 2; //unsigned arithmetics!
+        }
+
+        if (block.empty())
+            eof = true;
+    }
 
     bool isEof() const { return eof; }
 
 private:
-    const std::unique_ptr<AFS::InputStream> stream;
-    const size_t defaultBlockSize;
-    size_t dynamicBlockSize;
+    StreamReader           (const StreamReader&) = delete;
+    StreamReader& operator=(const StreamReader&) = delete;
+
     const std::function<void(std::int64_t bytesDelta)> notifyProgress_;
     size_t& unevenBytes_;
-    std::chrono::steady_clock::time_point lastDelayViolation = std::chrono::steady_clock::now();
     bool eof = false;
+    const std::shared_ptr<ReadAheadBuffer> readBuf_ = std::make_shared<ReadAheadBuffer>(); //shared with reader thread
+    InterruptibleThread readerThread;
 };
 }
 
@@ -0,0 +1,125 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#include "change_list.h"
+#include <zen/file_io.h>
+#include <zen/serialize.h>
+
+using namespace zen;
+
+
+namespace
+{
+//-------------------------------------------------------------------------------------------------------------------------------
+const char FILE_FORMAT_DESCR[] = "FreeFileSync";
+const int CHANGE_LIST_FORMAT_VER = 1;
+//-------------------------------------------------------------------------------------------------------------------------------
+
+using MemStreamOut = MemoryStreamOut<ByteArray>;
+using MemStreamIn  = MemoryStreamIn <ByteArray>;
+
+void writeUtf8(MemStreamOut& output, const Zstring& str) { writeContainer(output, utfCvrtTo<Zbase<char>>(str)); }
+Zstring readUtf8(MemStreamIn& input) { return utfCvrtTo<Zstring>(readContainer<Zbase<char>>(input)); } //throw UnexpectedEndOfStreamError
+}
+
+
+void zen::saveChangeList(const Zstring& filePath, const ChangeList& changeList) //throw FileError
+{
+    MemStreamOut streamOut;
+    writeArray(streamOut, FILE_FORMAT_DESCR, sizeof(FILE_FORMAT_DESCR));
+    writeNumber<std::int32_t>(streamOut, CHANGE_LIST_FORMAT_VER);
+
+    writeContainer           (streamOut, changeList.pos.sessionId);
+    writeNumber<std::uint64_t>(streamOut, changeList.pos.sequenceNo);
+    writeNumber<std::int8_t  >(streamOut, changeList.complete);
+
+    writeNumber<std::uint32_t>(streamOut, static_cast<std::uint32_t>(changeList.monitoredFolders.size()));
+    for (const Zstring& folderPath : changeList.monitoredFolders)
+        writeUtf8(streamOut, folderPath);
+
+    writeNumber<std::uint32_t>(streamOut, static_cast<std::uint32_t>(changeList.changes.size()));
+    for (const DirWatcher::Entry& change : changeList.changes)
+    {
+        writeNumber<std::int32_t>(streamOut, change.action_);
+        writeUtf8(streamOut, change.filepath_);
+    }
+
+    saveBinContainer(filePath, streamOut.ref(), nullptr); //throw FileError
+}
+
+
+ChangeList zen::loadChangeList(const Zstring& filePath) //throw FileError
+{
+    const ByteArray buffer = loadBinContainer<ByteArray>(filePath, nullptr); //throw FileError
+    try
+    {
+        MemStreamIn streamIn(buffer);
+
+        char formatDescr[sizeof(FILE_FORMAT_DESCR)] = {};
+        readArray(streamIn, formatDescr, sizeof(formatDescr)); //throw UnexpectedEndOfStreamError
+
+        if (!std::equal(FILE_FORMAT_DESCR, FILE_FORMAT_DESCR + sizeof(FILE_FORMAT_DESCR), formatDescr) ||
+            readNumber<std::int32_t>(streamIn) != CHANGE_LIST_FORMAT_VER)
+            throw FileError(replaceCpy(_("Cannot read file %x."), L"%x", fmtPath(filePath)), L"Unknown file format.");
+
+        ChangeList changeList;
+        changeList.pos.sessionId  = readContainer<std::string>(streamIn);
+        changeList.pos.sequenceNo = readNumber<std::uint64_t>(streamIn);
+        changeList.complete = readNumber<std::int8_t>(streamIn) != 0;
+
+        size_t folderCount = readNumber<std::uint32_t>(streamIn);
+        while (folderCount-- != 0)
+            changeList.monitoredFolders.push_back(readUtf8(streamIn));
+
+        size_t changeCount = readNumber<std::uint32_t>(streamIn);
+        while (changeCount-- != 0)
+        {
+            const auto action = static_cast<DirWatcher::ActionType>(readNumber<std::int32_t>(streamIn));
+            changeList.changes.emplace_back(action, readUtf8(streamIn));
+        }
+        return changeList;
+    }
+    catch (UnexpectedEndOfStreamError&)
+    {
+        throw FileError(replaceCpy(_("Cannot read file %x."), L"%x", fmtPath(filePath)), L"Unexpected end of stream.");
+    }
+}
+
+
+FolderChanges zen::getFolderChanges(const ChangeList& changeList, const Zstring& baseFolderPath)
+{
+    auto isSubPath = [](const Zstring& path, const Zstring& parentPath)
+    {
+        return path.size() > parentPath.size() && pathStartsWith(path, parentPath) &&
+               (endsWith(parentPath, FILE_NAME_SEPARATOR) || path[parentPath.size()] == FILE_NAME_SEPARATOR);
+    };
+    auto isMonitored = [&](const Zstring& path)
+    {
+        for (const Zstring& folderPath : changeList.monitoredFolders)
+            if (equalFilePath(path, folderPath) || isSubPath(path, folderPath))
+                return true;
+        return false;
+    };
+
+    FolderChanges output;
+    output.complete = changeList.complete && isMonitored(baseFolderPath); //changes are only known for monitored folders
+
+    const Zstring baseFolderPathPf = appendSeparator(baseFolderPath);
+
+    for (const DirWatcher::Entry& change : changeList.changes)
+        if (isSubPath(change.filepath_, baseFolderPath))
+        {
+            const Zstring itemRelPath = afterFirst(change.filepath_, baseFolderPathPf, IF_MISSING_RETURN_NONE);
+            output.changedFolders.insert(beforeLast(itemRelPath, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE)); //parent folder content changed
+            output.changedFolders.insert(itemRelPath); //item itself might be a folder
+        }
+        else if (equalFilePath(change.filepath_, baseFolderPath) || isSubPath(baseFolderPath, change.filepath_))
+            output.complete = false; //base folder or one of its parents changed, e.g. event overflow is reported for the monitored folder
+        else if (!isMonitored(change.filepath_))
+            output.complete = false; //unspecific change, e.g. buffer overflow on Windows
+
+    return output;
+}
@@ -0,0 +1,57 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#ifndef CHANGE_LIST_H_2380947502374502345
+#define CHANGE_LIST_H_2380947502374502345
+
+#include <set>
+#include <string>
+#include <vector>
+#include <zen/dir_watcher.h>
+#include <zen/file_error.h>
+
+
+namespace zen
+{
+/*
+changes detected by RealTimeSync since it last executed its command: the file path is passed via environment variable "change_list"
+
+=> FreeFileSync can reuse the scan snapshot (see scan_snapshot.h) of the previous run of the same RealTimeSync session without checking
+   folders that did not change at all, provided no change went unrecorded in between: see ChangeList::complete
+*/
+const wchar_t CHANGE_LIST_ENV_VAR[] = L"change_list";
+
+struct ChangeListPos
+{
+    std::string sessionId; //GUID; empty: not associated with a RealTimeSync session
+    std::uint64_t sequenceNo = 0; //number of change lists written by the same session before
+};
+
+inline
+bool operator==(const ChangeListPos& lhs, const ChangeListPos& rhs) { return lhs.sessionId == rhs.sessionId && lhs.sequenceNo == rhs.sequenceNo; }
+
+
+struct ChangeList
+{
+    ChangeListPos pos;
+    bool complete = false; //all changes since the previous change list of the same session were recorded: no (re-)installed folder watches, no event overflow
+    std::vector<Zstring> monitoredFolders;
+    std::vector<DirWatcher::Entry> changes;
+};
+
+void       saveChangeList(const Zstring& filePath, const ChangeList& changeList); //throw FileError
+ChangeList loadChangeList(const Zstring& filePath); //throw FileError
+
+
+struct FolderChanges
+{
+    bool complete = false; //all changes within the base folder were recorded
+    std::set<Zstring, LessFilePath> changedFolders; //relative paths (empty for base folder) of folders with changed content
+};
+FolderChanges getFolderChanges(const ChangeList& changeList, const Zstring& baseFolderPath);
+}
+
+#endif //CHANGE_LIST_H_2380947502374502345
@@ -22,8 +22,12 @@ namespace
 const char FILE_FORMAT_DESCR[] = "FreeFileSync";
 const int DB_FORMAT_CONTAINER = 9;
 const int DB_FORMAT_STREAM    = 2; //since 2015-05-02
+const int DB_FORMAT_JOURNAL   = 1; //journal entry: list of incremental updates for a session stored in the main database file
 //-------------------------------------------------------------------------------------------------------------------------------
 
+//rewrite the main database files only if the journal grows larger than 1/JOURNAL_COMPACTION_RATIO of the main session streams
+const size_t JOURNAL_COMPACTION_RATIO = 4;
+
 using UniqueId  = std::string;
 using DbStreams = std::map<UniqueId, ByteArray>; //list of streams ordered by session UUID
 
@@ -35,7 +39,7 @@ using MemStreamIn  = MemoryStreamIn <ByteArray>;
 //-----------------------------------------------------------------------------------
 
 template <SelectedSide side> inline
-AbstractPath getDatabaseFilePath(const BaseFolderPair& baseFolder, bool tempfile = false)
+AbstractPath getDatabaseFilePath(const BaseFolderPair& baseFolder, bool tempfile = false, bool journal = false)
 {
     //Linux and Windows builds are binary incompatible: different file id?, problem with case sensitivity?
     //precomposed/decomposed UTF? are UTC file times really compatible? what about endianess!?
@@ -47,7 +51,7 @@ AbstractPath getDatabaseFilePath(const BaseFolderPair& baseFolder, bool tempfile
 #elif defined ZEN_LINUX || defined ZEN_MAC
     const Zstring dbName = Zstr(".sync"); //files beginning with dots are hidden e.g. in Nautilus
 #endif
-    const Zstring dbFileName = dbName + (tempfile ? Zstr(".tmp") : Zstr("")) + SYNC_DB_FILE_ENDING;
+    const Zstring dbFileName = dbName + (journal ? Zstr(".journal") : Zstr("")) + (tempfile ? Zstr(".tmp") : Zstr("")) + SYNC_DB_FILE_ENDING;
 
     return AFS::appendRelPath(baseFolder.getAbstractPath<side>(), dbFileName);
 }
@@ -164,9 +168,37 @@ public:
         StreamGenerator generator;
 
         //PERF_START
-        generator.recurse(dbFolder);
+        generator.writeFolder(dbFolder, true /*recursive*/);
         //PERF_STOP
 
+        generator.distributeStreams(displayFilePathL, displayFilePathR, streamL, streamR); //throw FileError
+    }
+
+    //incremental update: write direct content of changed folders only
+    static void executeJournal(const std::vector<std::pair<Zstring, const InSyncFolder*>>& changedFolders, //throw FileError
+                               const std::wstring& displayFilePathL, //used for diagnostics only
+                               const std::wstring& displayFilePathR,
+                               ByteArray& streamL,
+                               ByteArray& streamR)
+    {
+        StreamGenerator generator;
+
+        writeNumber<std::uint32_t>(generator.outputBoth, static_cast<std::uint32_t>(changedFolders.size()));
+        for (const auto& item : changedFolders)
+        {
+            writeUtf8(generator.outputBoth, item.first); //folder path relative to base folder; parents are always listed before their children
+            generator.writeFolder(*item.second, false /*recursive*/);
+        }
+
+        generator.distributeStreams(displayFilePathL, displayFilePathR, streamL, streamR); //throw FileError
+    }
+
+private:
+    void distributeStreams(const std::wstring& displayFilePathL, //throw FileError
+                           const std::wstring& displayFilePathR,
+                           ByteArray& streamL,
+                           ByteArray& streamR)
+    {
         auto compStream = [](const ByteArray& stream, const std::wstring& displayFilePath) -> ByteArray //throw FileError
         {
             try
@@ -191,9 +223,9 @@ public:
             }
         };
 
-        const ByteArray tmpL = compStream(generator.outputLeft .ref(), displayFilePathL);
-        const ByteArray tmpR = compStream(generator.outputRight.ref(), displayFilePathR);
-        const ByteArray tmpB = compStream(generator.outputBoth .ref(), displayFilePathL + L"/" + displayFilePathR);
+        const ByteArray tmpL = compStream(outputLeft .ref(), displayFilePathL);
+        const ByteArray tmpR = compStream(outputRight.ref(), displayFilePathR);
+        const ByteArray tmpB = compStream(outputBoth .ref(), displayFilePathL + L"/" + displayFilePathR);
 
         MemStreamOut outL;
         MemStreamOut outR;
@@ -222,8 +254,7 @@ public:
         streamR = outR.ref();
     }
 
-private:
-    void recurse(const InSyncFolder& container)
+    void writeFolder(const InSyncFolder& container, bool recursive)
     {
         writeNumber<std::uint32_t>(outputBoth, static_cast<std::uint32_t>(container.files.size()));
         for (const auto& dbFile : container.files)
@@ -252,7 +283,8 @@ private:
             writeUtf8(outputBoth, dbFolder.first);
             writeNumber<std::int32_t>(outputBoth, dbFolder.second.status);
 
-            recurse(dbFolder.second);
+            if (recursive)
+                writeFolder(dbFolder.second, true);
         }
     }
 
@@ -283,6 +315,47 @@ public:
                                                  const ByteArray& streamR,
                                                  const std::wstring& displayFilePathL, //used for diagnostics only
                                                  const std::wstring& displayFilePathR)
+    {
+        auto output = std::make_shared<InSyncFolder>(InSyncFolder::DIR_STATUS_IN_SYNC);
+
+        parseStreams(streamL, streamR, displayFilePathL, displayFilePathR, [&](StreamParser& parser) //throw FileError
+        {
+            parser.readFolder(*output, true /*recursive*/); //throw UnexpectedEndOfStreamError
+        });
+        return output;
+    }
+
+    //apply incremental update created by StreamGenerator::executeJournal()
+    static void applyJournal(const ByteArray& streamL, //throw FileError
+                             const ByteArray& streamR,
+                             const std::wstring& displayFilePathL, //used for diagnostics only
+                             const std::wstring& displayFilePathR,
+                             InSyncFolder& dbFolder)
+    {
+        parseStreams(streamL, streamR, displayFilePathL, displayFilePathR, [&](StreamParser& parser) //throw FileError
+        {
+            size_t folderCount = readNumber<std::uint32_t>(parser.inputBoth); //throw UnexpectedEndOfStreamError
+            while (folderCount-- != 0)
+            {
+                const Zstring folderRelPath = readUtf8(parser.inputBoth);
+
+                InSyncFolder* container = &dbFolder;
+                for (const Zstring& itemName : split(folderRelPath, FILE_NAME_SEPARATOR))
+                    if (!itemName.empty())
+                        container = &container->addFolder(itemName, InSyncFolder::DIR_STATUS_STRAW_MAN); //get or create: status is set by parent's update
+
+                parser.readFolder(*container, false /*recursive*/); //throw UnexpectedEndOfStreamError
+            }
+        });
+    }
+
+private:
+    template <class Function>
+    static void parseStreams(const ByteArray& streamL, //throw FileError
+                             const ByteArray& streamR,
+                             const std::wstring& displayFilePathL,
+                             const std::wstring& displayFilePathR,
+                             Function parse)
     {
         auto decompStream = [](const ByteArray& stream, const std::wstring& displayFilePath) -> ByteArray //throw FileError
         {
@@ -332,13 +405,11 @@ public:
             const ByteArray tmpL = readContainer<ByteArray>(inL);
             const ByteArray tmpR = readContainer<ByteArray>(inR);
 
-            auto output = std::make_shared<InSyncFolder>(InSyncFolder::DIR_STATUS_IN_SYNC);
             StreamParser parser(streamVersionL,
                                 decompStream(tmpL, displayFilePathL),
                                 decompStream(tmpR, displayFilePathR),
                                 decompStream(tmpB, displayFilePathL + L"/" + displayFilePathR));
-            parser.recurse(*output); //throw UnexpectedEndOfStreamError
-            return output;
+            parse(parser); //throw UnexpectedEndOfStreamError
         }
         catch (const UnexpectedEndOfStreamError&)
         {
@@ -351,7 +422,6 @@ public:
         }
     }
 
-private:
     StreamParser(int streamVersion,
                  const ByteArray& bufferL,
                  const ByteArray& bufferR,
@@ -361,8 +431,14 @@ private:
         inputRight(bufferR),
         inputBoth (bufferB) {}
 
-    void recurse(InSyncFolder& container)
+    void readFolder(InSyncFolder& container, bool recursive) //throw UnexpectedEndOfStreamError
     {
+        if (!recursive) //incremental update: replace direct content
+        {
+            container.files   .clear();
+            container.symlinks.clear();
+        }
+
         size_t fileCount = readNumber<std::uint32_t>(inputBoth);
         while (fileCount-- != 0)
         {
@@ -384,14 +460,32 @@ private:
             container.addSymlink(itemName, dataL, dataR, cmpVar);
         }
 
+        InSyncFolder::FolderList foldersOld;
+        if (!recursive)
+            foldersOld.swap(container.folders); //keep child elements of folders still existing; drop the rest
+
         size_t dirCount = readNumber<std::uint32_t>(inputBoth);
         while (dirCount-- != 0)
         {
             const Zstring itemName = readUtf8(inputBoth);
             const auto status = static_cast<InSyncFolder::InSyncStatus>(readNumber<std::int32_t>(inputBoth));
 
-            InSyncFolder& dbFolder = container.addFolder(itemName, status);
-            recurse(dbFolder);
+            if (recursive)
+            {
+                InSyncFolder& dbFolder = container.addFolder(itemName, status);
+                readFolder(dbFolder, true);
+            }
+            else
+            {
+                auto it = foldersOld.find(itemName);
+                if (it != foldersOld.end()) //update key: item name case might have changed!
+                {
+                    InSyncFolder& dbFolder = container.folders.emplace(itemName, std::move(it->second)).first->second;
+                    dbFolder.status = status;
+                }
+                else
+                    container.addFolder(itemName, status);
+            }
         }
     }
 
@@ -435,6 +529,22 @@ private:
 
 //#######################################################################################################################################
 
+inline bool isEqualDbItem(const InSyncDescrFile& lhs, const InSyncDescrFile& rhs) { return lhs.lastWriteTimeRaw == rhs.lastWriteTimeRaw && lhs.fileId == rhs.fileId; }
+inline bool isEqualDbItem(const InSyncDescrLink& lhs, const InSyncDescrLink& rhs) { return lhs.lastWriteTimeRaw == rhs.lastWriteTimeRaw; }
+
+inline
+bool isEqualDbItem(const InSyncFile& lhs, const InSyncFile& rhs)
+{
+    return isEqualDbItem(lhs.left, rhs.left) && isEqualDbItem(lhs.right, rhs.right) && lhs.cmpVar == rhs.cmpVar && lhs.fileSize == rhs.fileSize;
+}
+
+inline
+bool isEqualDbItem(const InSyncSymlink& lhs, const InSyncSymlink& rhs)
+{
+    return isEqualDbItem(lhs.left, rhs.left) && isEqualDbItem(lhs.right, rhs.right) && lhs.cmpVar == rhs.cmpVar;
+}
+
+
 class UpdateLastSynchronousState
 {
     /*
@@ -444,10 +554,13 @@ class UpdateLastSynchronousState
         => update all database entries!
     */
 public:
-    static void execute(const BaseFolderPair& baseFolder, InSyncFolder& dbFolder)
+    using ChangedFolders = std::unordered_set<const InSyncFolder*>; //folders with modified direct content (files, symlinks, sub folder names and status)
+
+    static ChangedFolders execute(const BaseFolderPair& baseFolder, InSyncFolder& dbFolder)
     {
         UpdateLastSynchronousState updater(baseFolder.getCompVariant(), baseFolder.getFilter());
         updater.recurse(baseFolder, dbFolder);
+        return std::move(updater.changedFolders_);
     }
 
 private:
@@ -457,13 +570,13 @@ private:
 
     void recurse(const HierarchyObject& hierObj, InSyncFolder& dbFolder)
     {
-        process(hierObj.refSubFiles  (), hierObj.getPairRelativePathPf(), dbFolder.files);
-        process(hierObj.refSubLinks  (), hierObj.getPairRelativePathPf(), dbFolder.symlinks);
-        process(hierObj.refSubFolders(), hierObj.getPairRelativePathPf(), dbFolder.folders);
+        processFiles  (hierObj.refSubFiles  (), hierObj.getPairRelativePathPf(), dbFolder);
+        processLinks  (hierObj.refSubLinks  (), hierObj.getPairRelativePathPf(), dbFolder);
+        processFolders(hierObj.refSubFolders(), hierObj.getPairRelativePathPf(), dbFolder);
     }
 
     template <class M, class V>
-    static V& updateItem(M& map, const Zstring& key, const V& value)
+    static V& updateItem(M& map, const Zstring& key, const V& value, bool& changed)
     {
         auto rv = map.emplace(key, value);
         if (!rv.second)
@@ -472,11 +585,18 @@ private:
             if (rv.first->first != key) //=> conceptually case-sensitivity should be part of "value", not "key"
             {
                 map.erase(rv.first);
+                changed = true;
                 return map.emplace(key, value).first->second;
             }
 #endif
-            rv.first->second = value;
+            if (!isEqualDbItem(rv.first->second, value))
+            {
+                rv.first->second = value;
+                changed = true;
+            }
         }
+        else
+            changed = true;
         return rv.first->second;
 
         //www.cplusplus.com claims that hint position for map<>::insert(iterator position, const value_type& val) changed with C++11 -> standard is unclear in [map.modifiers]
@@ -503,8 +623,10 @@ private:
         */
     }
 
-    void process(const HierarchyObject::FileList& currentFiles, const Zstring& parentRelPathPf, InSyncFolder::FileList& dbFiles)
+    void processFiles(const HierarchyObject::FileList& currentFiles, const Zstring& parentRelPathPf, InSyncFolder& dbFolder)
     {
+        InSyncFolder::FileList& dbFiles = dbFolder.files;
+        bool changed = false;
         std::unordered_set<const InSyncFile*> toPreserve; //referencing fixed-in-memory std::map elements
 
         for (const FilePair& file : currentFiles)
@@ -525,7 +647,7 @@ private:
                                                                InSyncDescrFile(file.getLastWriteTime<RIGHT_SIDE>(),
                                                                                file.getFileId       <RIGHT_SIDE>()),
                                                                activeCmpVar_,
-                                                               file.getFileSize<LEFT_SIDE>()));
+                                                               file.getFileSize<LEFT_SIDE>()), changed);
                     toPreserve.insert(&dbFile);
                 }
                 else //not in sync: preserve last synchronous state
@@ -537,6 +659,7 @@ private:
             }
 
         //delete removed items (= "in-sync") from database
+        const size_t itemCountOld = dbFiles.size();
         erase_if(dbFiles, [&](const InSyncFolder::FileList::value_type& v) -> bool
         {
             if (toPreserve.find(&v.second) != toPreserve.end())
@@ -546,10 +669,15 @@ private:
             return filter_.passFileFilter(itemRelPath);
             //note: items subject to traveral errors are also excluded by this file filter here! see comparison.cpp, modified file filter for read errors
         });
+
+        if (changed || dbFiles.size() != itemCountOld)
+            changedFolders_.insert(&dbFolder);
     }
 
-    void process(const HierarchyObject::SymlinkList& currentSymlinks, const Zstring& parentRelPathPf, InSyncFolder::SymlinkList& dbSymlinks)
+    void processLinks(const HierarchyObject::SymlinkList& currentSymlinks, const Zstring& parentRelPathPf, InSyncFolder& dbFolder)
     {
+        InSyncFolder::SymlinkList& dbSymlinks = dbFolder.symlinks;
+        bool changed = false;
         std::unordered_set<const InSyncSymlink*> toPreserve;
 
         for (const SymlinkPair& symlink : currentSymlinks)
@@ -563,7 +691,7 @@ private:
                     InSyncSymlink& dbSymlink = updateItem(dbSymlinks, symlink.getPairItemName(),
                                                           InSyncSymlink(InSyncDescrLink(symlink.getLastWriteTime<LEFT_SIDE>()),
                                                                         InSyncDescrLink(symlink.getLastWriteTime<RIGHT_SIDE>()),
-                                                                        activeCmpVar_));
+                                                                        activeCmpVar_), changed);
                     toPreserve.insert(&dbSymlink);
                 }
                 else //not in sync: preserve last synchronous state
@@ -575,6 +703,7 @@ private:
             }
 
         //delete removed items (= "in-sync") from database
+        const size_t itemCountOld = dbSymlinks.size();
         erase_if(dbSymlinks, [&](const InSyncFolder::SymlinkList::value_type& v) -> bool
         {
             if (toPreserve.find(&v.second) != toPreserve.end())
@@ -583,10 +712,15 @@ private:
             const Zstring& itemRelPath = parentRelPathPf + v.first;
             return filter_.passFileFilter(itemRelPath);
         });
+
+        if (changed || dbSymlinks.size() != itemCountOld)
+            changedFolders_.insert(&dbFolder);
     }
 
-    void process(const HierarchyObject::FolderList& currentFolders, const Zstring& parentRelPathPf, InSyncFolder::FolderList& dbFolders)
+    void processFolders(const HierarchyObject::FolderList& currentFolders, const Zstring& parentRelPathPf, InSyncFolder& dbFolderParent)
     {
+        InSyncFolder::FolderList& dbFolders = dbFolderParent.folders;
+        bool changed = false; //sub folder names or status
         std::unordered_set<const InSyncFolder*> toPreserve;
 
         for (const FolderPair& folder : currentFolders)
@@ -601,6 +735,8 @@ private:
                         const Zstring& key = folder.getPairItemName();
                         auto insertResult = dbFolders.emplace(key, InSyncFolder(InSyncFolder::DIR_STATUS_IN_SYNC)); //get or create
                         auto it = insertResult.first;
+                        if (insertResult.second)
+                            changed = true;
 
 #if defined ZEN_WIN || defined ZEN_MAC //caveat: key might need to be updated, too, if there is a change in short name case!!!
                         const bool alreadyExisting = !insertResult.second;
@@ -609,9 +745,12 @@ private:
                             auto oldValue = std::move(it->second);
                             dbFolders.erase(it); //don't fiddle with decrementing "it"! - you might lose while optimizing pointlessly
                             it = dbFolders.emplace(key, std::move(oldValue)).first;
+                            changed = true;
                         }
 #endif
                         InSyncFolder& dbFolder = it->second;
+                        if (dbFolder.status != InSyncFolder::DIR_STATUS_IN_SYNC)
+                            changed = true;
                         dbFolder.status = InSyncFolder::DIR_STATUS_IN_SYNC; //update immediate directory entry
                         toPreserve.insert(&dbFolder);
                         recurse(folder, dbFolder);
@@ -625,7 +764,10 @@ private:
                         //Example: directories on left and right differ in case while sub-files are equal
                     {
                         //reuse last "in-sync" if available or insert strawman entry (do not try to update and thereby remove child elements!!!)
-                        InSyncFolder& dbFolder = dbFolders.emplace(folder.getPairItemName(), InSyncFolder(InSyncFolder::DIR_STATUS_STRAW_MAN)).first->second;
+                        auto insertResult = dbFolders.emplace(folder.getPairItemName(), InSyncFolder(InSyncFolder::DIR_STATUS_STRAW_MAN));
+                        if (insertResult.second)
+                            changed = true;
+                        InSyncFolder& dbFolder = insertResult.first->second;
                         toPreserve.insert(&dbFolder);
                         recurse(folder, dbFolder); //unconditional recursion without filter check! => no problem since "childItemMightMatch" is optional!!!
                     }
@@ -646,6 +788,7 @@ private:
                 }
 
         //delete removed items (= "in-sync") from database
+        const size_t itemCountOld = dbFolders.size();
         erase_if(dbFolders, [&](InSyncFolder::FolderList::value_type& v) -> bool
         {
             if (toPreserve.find(&v.second) != toPreserve.end())
@@ -661,11 +804,16 @@ private:
                 dbSetEmptyState(v.second, appendSeparator(itemRelPath)); //child items might match, e.g. *.txt include filter!
             return passFilter;
         });
+
+        if (changed || dbFolders.size() != itemCountOld)
+            changedFolders_.insert(&dbFolderParent);
     }
 
     //delete all entries for removed folder (= "in-sync") from database
     void dbSetEmptyState(InSyncFolder& dbFolder, const Zstring& parentRelPathPf)
     {
+        const size_t itemCountOld = dbFolder.files.size() + dbFolder.symlinks.size() + dbFolder.folders.size();
+
         erase_if(dbFolder.files,    [&](const InSyncFolder::FileList   ::value_type& v) { return filter_.passFileFilter(parentRelPathPf + v.first); });
         erase_if(dbFolder.symlinks, [&](const InSyncFolder::SymlinkList::value_type& v) { return filter_.passFileFilter(parentRelPathPf + v.first); });
 
@@ -679,11 +827,135 @@ private:
                 dbSetEmptyState(v.second, appendSeparator(itemRelPath));
             return passFilter;
         });
+
+        if (dbFolder.files.size() + dbFolder.symlinks.size() + dbFolder.folders.size() != itemCountOld)
+            changedFolders_.insert(&dbFolder);
     }
 
     const HardFilter& filter_; //filter used while scanning directory: generates view on actual files!
     const CompareVariant activeCmpVar_;
+    ChangedFolders changedFolders_;
 };
+
+
+//#######################################################################################################################################
+
+//find changed folders in hierarchical order: parent before child
+void getChangedFolders(const InSyncFolder& dbFolder, const Zstring& folderRelPath,
+                       const UpdateLastSynchronousState::ChangedFolders& changedFolders,
+                       std::vector<std::pair<Zstring, const InSyncFolder*>>& output)
+{
+    if (changedFolders.find(&dbFolder) != changedFolders.end())
+        output.emplace_back(folderRelPath, &dbFolder);
+
+    for (const auto& item : dbFolder.folders)
+        getChangedFolders(item.second, folderRelPath.empty() ? item.first : appendSeparator(folderRelPath) + item.first, changedFolders, output);
+}
+
+
+//journal files: incremental updates since last rewrite of the main database files, stored as DbStreams: session UUID of main database file -> JournalEntry
+struct JournalEntry
+{
+    std::string journalId; //new UUID for each update: detect left and right journal files being out of sync
+    std::vector<ByteArray> updates; //in order of creation: see StreamGenerator::executeJournal()
+};
+
+
+ByteArray serializeJournalEntry(const JournalEntry& entry)
+{
+    MemStreamOut streamOut;
+    writeNumber<std::int32_t>(streamOut, DB_FORMAT_JOURNAL);
+    writeContainer<std::string>(streamOut, entry.journalId);
+
+    writeNumber<std::uint32_t>(streamOut, static_cast<std::uint32_t>(entry.updates.size()));
+    for (const ByteArray& stream : entry.updates)
+        writeContainer<ByteArray>(streamOut, stream);
+
+    return streamOut.ref();
+}
+
+
+JournalEntry parseJournalEntry(const ByteArray& stream, const std::wstring& displayFilePath) //throw FileError
+{
+    try
+    {
+        MemStreamIn streamIn(stream);
+
+        if (readNumber<std::int32_t>(streamIn) != DB_FORMAT_JOURNAL) //throw UnexpectedEndOfStreamError
+            throw FileError(replaceCpy(_("Database file %x is incompatible."), L"%x", fmtPath(displayFilePath)), L"unknown journal format");
+
+        JournalEntry entry;
+        entry.journalId = readContainer<std::string>(streamIn); //throw UnexpectedEndOfStreamError
+
+        size_t updateCount = readNumber<std::uint32_t>(streamIn); //
+        while (updateCount-- != 0)
+            entry.updates.push_back(readContainer<ByteArray>(streamIn)); //
+        return entry;
+    }
+    catch (UnexpectedEndOfStreamError&)
+    {
+        throw FileError(_("Database file is corrupt:") + L"\n" + fmtPath(displayFilePath), L"Unexpected end of stream.");
+    }
+}
+
+
+size_t getJournalSize(const JournalEntry& entry)
+{
+    size_t bytes = 0;
+    for (const ByteArray& stream : entry.updates)
+        bytes += stream.size();
+    return bytes;
+}
+
+
+DbStreams loadJournalStreams(const AbstractPath& journalPath, const std::function<void(std::int64_t bytesDelta)>& notifyProgress) //throw FileError
+{
+    try
+    {
+        return loadStreams(journalPath, notifyProgress); //throw FileError, FileErrorDatabaseNotExisting
+    }
+    catch (FileErrorDatabaseNotExisting&) { return DbStreams(); } //no updates since last rewrite of main database files
+}
+
+
+//both sides must agree on the journal state of a session!
+bool getJournalEntries(const UniqueId& sessionID, //throw FileError, FileErrorDatabaseNotExisting
+                       const DbStreams& journalStreamsL,
+                       const DbStreams& journalStreamsR,
+                       const std::wstring& displayFilePathL, //used for diagnostics only
+                       const std::wstring& displayFilePathR,
+                       JournalEntry& entryL,
+                       JournalEntry& entryR)
+{
+    auto itL = journalStreamsL.find(sessionID);
+    auto itR = journalStreamsR.find(sessionID);
+
+    if (itL == journalStreamsL.end() && itR == journalStreamsR.end())
+        return false;
+
+    if (itL != journalStreamsL.end() && itR != journalStreamsR.end())
+    {
+        entryL = parseJournalEntry(itL->second, displayFilePathL); //throw FileError
+        entryR = parseJournalEntry(itR->second, displayFilePathR); //
+
+        if (entryL.journalId == entryR.journalId &&
+            entryL.updates.size() == entryR.updates.size())
+            return true;
+    }
+    //e.g. interrupted journal update:
+    throw FileErrorDatabaseNotExisting(_("Initial synchronization:") + L" \n" +
+                                       _("Database files do not share a common session."));
+}
+
+
+void replaceDatabaseFile(const DbStreams& streamList, const AbstractPath& dbPath, const AbstractPath& dbPathTmp, //throw FileError
+                         const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
+{
+    saveStreams(streamList, dbPathTmp, notifyProgress); //throw FileError
+
+    AFS::removeFile(dbPath);              //throw FileError
+    AFS::renameItem(dbPathTmp, dbPath);   //throw FileError, (ErrorTargetExisting, ErrorDifferentVolume)
+}
 }
 
 //#######################################################################################################################################
@@ -714,10 +986,31 @@ std::shared_ptr<InSyncFolder> zen::loadLastSynchronousState(const BaseFolderPair
         auto itRight = streamsRight.find(streamLeft.first);
         if (itRight != streamsRight.end())
         {
-            return StreamParser::execute(streamLeft.second, //throw FileError
-                                         itRight->second,
-                                         AFS::getDisplayPath(dbPathLeft),
-                                         AFS::getDisplayPath(dbPathRight));
+            std::shared_ptr<InSyncFolder> lastSyncState = StreamParser::execute(streamLeft.second, //throw FileError
+                                                                                itRight->second,
+                                                                                AFS::getDisplayPath(dbPathLeft),
+                                                                                AFS::getDisplayPath(dbPathRight));
+
+            //apply incremental updates written since last rewrite of the main database files
+            const AbstractPath journalPathLeft  = getDatabaseFilePath< LEFT_SIDE>(baseFolder, false, true /*journal*/);
+            const AbstractPath journalPathRight = getDatabaseFilePath<RIGHT_SIDE>(baseFolder, false, true /*journal*/);
+
+            const DbStreams journalLeft  = loadJournalStreams(journalPathLeft,  notifyProgress); //throw FileError
+            const DbStreams journalRight = loadJournalStreams(journalPathRight, notifyProgress); //
+
+            JournalEntry journalEntryL;
+            JournalEntry journalEntryR;
+            if (getJournalEntries(streamLeft.first, journalLeft, journalRight, //throw FileError, FileErrorDatabaseNotExisting
+                                  AFS::getDisplayPath(journalPathLeft),
+                                  AFS::getDisplayPath(journalPathRight),
+                                  journalEntryL, journalEntryR))
+                for (size_t i = 0; i < journalEntryL.updates.size(); ++i)
+                    StreamParser::applyJournal(journalEntryL.updates[i], //throw FileError
+                                               journalEntryR.updates[i],
+                                               AFS::getDisplayPath(journalPathLeft),
+                                               AFS::getDisplayPath(journalPathRight),
+                                               *lastSyncState);
+            return lastSyncState;
         }
     }
     throw FileErrorDatabaseNotExisting(_("Initial synchronization:") + L" \n" +
@@ -734,9 +1027,17 @@ void zen::saveLastSynchronousState(const BaseFolderPair& baseFolder, const std::
     const AbstractPath dbPathLeftTmp  = getDatabaseFilePath< LEFT_SIDE>(baseFolder, true);
     const AbstractPath dbPathRightTmp = getDatabaseFilePath<RIGHT_SIDE>(baseFolder, true);
 
+    const AbstractPath journalPathLeft  = getDatabaseFilePath< LEFT_SIDE>(baseFolder, false, true /*journal*/);
+    const AbstractPath journalPathRight = getDatabaseFilePath<RIGHT_SIDE>(baseFolder, false, true /*journal*/);
+
+    const AbstractPath journalPathLeftTmp  = getDatabaseFilePath< LEFT_SIDE>(baseFolder, true, true /*journal*/);
+    const AbstractPath journalPathRightTmp = getDatabaseFilePath<RIGHT_SIDE>(baseFolder, true, true /*journal*/);
+
     //delete old tmp file, if necessary -> throws if deletion fails!
-    AFS::removeFile(dbPathLeftTmp);  //
-    AFS::removeFile(dbPathRightTmp); //throw FileError
+    AFS::removeFile(dbPathLeftTmp);       //
+    AFS::removeFile(dbPathRightTmp);      //throw FileError
+    AFS::removeFile(journalPathLeftTmp);  //
+    AFS::removeFile(journalPathRightTmp); //
 
     //(try to) load old database files...
     DbStreams streamsLeft; //list of session ID + DirInfo-stream
@@ -752,6 +1053,17 @@ void zen::saveLastSynchronousState(const BaseFolderPair& baseFolder, const std::
     catch (FileError&) {}
     //if error occurs: just overwrite old file! User is already informed about issues right after comparing!
 
+    //journal files are shared by all sessions of the main database files => don't just overwrite if unreadable!
+    DbStreams journalLeft;
+    DbStreams journalRight;
+    bool journalCorruptLeft  = false;
+    bool journalCorruptRight = false;
+
+    try { journalLeft  = loadJournalStreams(journalPathLeft, notifyProgress); }
+    catch (FileError&) { journalCorruptLeft = true; }
+    try { journalRight = loadJournalStreams(journalPathRight, notifyProgress); }
+    catch (FileError&) { journalCorruptRight = true; }
+
     //find associated session: there can be at most one session within intersection of left and right ids
     auto itStreamLeftOld  = streamsLeft .cend();
     auto itStreamRightOld = streamsRight.cend();
@@ -768,19 +1080,85 @@ void zen::saveLastSynchronousState(const BaseFolderPair& baseFolder, const std::
 
     //load last synchrounous state
     std::shared_ptr<InSyncFolder> lastSyncState = std::make_shared<InSyncFolder>(InSyncFolder::DIR_STATUS_IN_SYNC);
+    bool haveLastSyncState = false;
+    JournalEntry journalEntryL;
+    JournalEntry journalEntryR;
+
     if (itStreamLeftOld  != streamsLeft .end() &&
-        itStreamRightOld != streamsRight.end())
+        itStreamRightOld != streamsRight.end() &&
+        !journalCorruptLeft && !journalCorruptRight)
         try
         {
             lastSyncState = StreamParser::execute(itStreamLeftOld ->second, //throw FileError
                                                   itStreamRightOld->second,
                                                   AFS::getDisplayPath(dbPathLeft),
                                                   AFS::getDisplayPath(dbPathRight));
+
+            if (getJournalEntries(itStreamLeftOld->first, journalLeft, journalRight, //throw FileError, FileErrorDatabaseNotExisting
+                                  AFS::getDisplayPath(journalPathLeft),
+                                  AFS::getDisplayPath(journalPathRight),
+                                  journalEntryL, journalEntryR))
+                for (size_t i = 0; i < journalEntryL.updates.size(); ++i)
+                    StreamParser::applyJournal(journalEntryL.updates[i], //throw FileError
+                                               journalEntryR.updates[i],
+                                               AFS::getDisplayPath(journalPathLeft),
+                                               AFS::getDisplayPath(journalPathRight),
+                                               *lastSyncState);
+            haveLastSyncState = true;
+        }
+        catch (FileError&) //if error occurs: just overwrite old file! User is already informed about issues right after comparing!
+        {
+            lastSyncState = std::make_shared<InSyncFolder>(InSyncFolder::DIR_STATUS_IN_SYNC);
+            journalEntryL = journalEntryR = JournalEntry();
         }
-        catch (FileError&) {} //if error occurs: just overwrite old file! User is already informed about issues right after comparing!
 
     //update last synchrounous state
-    UpdateLastSynchronousState::execute(baseFolder, *lastSyncState);
+    const UpdateLastSynchronousState::ChangedFolders changedFolders = UpdateLastSynchronousState::execute(baseFolder, *lastSyncState);
+
+    if (haveLastSyncState)
+    {
+        //check if there is some work to do at all
+        if (changedFolders.empty())
+            return; //some users monitor the *.ffs_db file with RTS => don't touch the file if it isnt't strictly needed
+
+        //incremental update: write changed folders only
+        std::vector<std::pair<Zstring, const InSyncFolder*>> changedFolderList;
+        getChangedFolders(*lastSyncState, Zstring(), changedFolders, changedFolderList);
+
+        ByteArray updateStreamLeft;
+        ByteArray updateStreamRight;
+        StreamGenerator::executeJournal(changedFolderList, //throw FileError
+                                        AFS::getDisplayPath(journalPathLeft),
+                                        AFS::getDisplayPath(journalPathRight),
+                                        updateStreamLeft,
+                                        updateStreamRight);
+
+        journalEntryL.updates.push_back(updateStreamLeft);
+        journalEntryR.updates.push_back(updateStreamRight);
+
+        const size_t journalSize = getJournalSize(journalEntryL) + getJournalSize(journalEntryR);
+        const size_t dbSize = itStreamLeftOld->second.size() + itStreamRightOld->second.size();
+
+        if (journalSize * JOURNAL_COMPACTION_RATIO <= dbSize)
+        {
+            journalEntryL.journalId = journalEntryR.journalId = zen::generateGUID();
+
+            journalLeft [itStreamLeftOld ->first] = serializeJournalEntry(journalEntryL);
+            journalRight[itStreamRightOld->first] = serializeJournalEntry(journalEntryR);
+
+            //write (temp-) files as a transaction
+            saveStreams(journalLeft,  journalPathLeftTmp,  notifyProgress); //throw FileError
+            saveStreams(journalRight, journalPathRightTmp, notifyProgress); //
+
+            AFS::removeFile(journalPathLeft);                     //throw FileError
+            AFS::renameItem(journalPathLeftTmp, journalPathLeft); //throw FileError, (ErrorTargetExisting, ErrorDifferentVolume)
+
+            AFS::removeFile(journalPathRight);                      //
+            AFS::renameItem(journalPathRightTmp, journalPathRight); //
+            return;
+        }
+        //else: compaction => rewrite main database files
+    }
 
     //serialize again
     ByteArray updatedStreamLeft;
@@ -791,11 +1169,6 @@ void zen::saveLastSynchronousState(const BaseFolderPair& baseFolder, const std::
                              updatedStreamLeft,
                              updatedStreamRight);
 
-    //check if there is some work to do at all
-    if (itStreamLeftOld  != streamsLeft .end() && updatedStreamLeft  == itStreamLeftOld ->second &&
-        itStreamRightOld != streamsRight.end() && updatedStreamRight == itStreamRightOld->second)
-        return; //some users monitor the *.ffs_db file with RTS => don't touch the file if it isnt't strictly needed
-
     //erase old session data
     if (itStreamLeftOld != streamsLeft.end())
         streamsLeft.erase(itStreamLeftOld);
@@ -819,4 +1192,19 @@ void zen::saveLastSynchronousState(const BaseFolderPair& baseFolder, const std::
 
     AFS::removeFile(dbPathRight);                 //
     AFS::renameItem(dbPathRightTmp, dbPathRight); //
+
+    //remove journal entries of sessions no longer existing (including orphans of an interrupted compaction)
+    auto cleanJournal = [&](DbStreams& journalStreams, bool journalCorrupt, const DbStreams& dbStreams,
+                            const AbstractPath& journalPath, const AbstractPath& journalPathTmp) //throw FileError
+    {
+        const size_t entryCountOld = journalStreams.size();
+        erase_if(journalStreams, [&](const DbStreams::value_type& v) { return dbStreams.find(v.first) == dbStreams.end(); });
+
+        if (journalCorrupt || journalStreams.empty())
+            AFS::removeFile(journalPath); //throw FileError; other sessions: partner journal is still existing => mismatch is detected when loading
+        else if (journalStreams.size() != entryCountOld)
+            replaceDatabaseFile(journalStreams, journalPath, journalPathTmp, notifyProgress); //throw FileError
+    };
+    cleanJournal(journalLeft,  journalCorruptLeft,  streamsLeft,  journalPathLeft,  journalPathLeftTmp);  //throw FileError
+    cleanJournal(journalRight, journalCorruptRight, streamsRight, journalPathRight, journalPathRightTmp); //
 }
@@ -6,6 +6,7 @@
 
 #include "hard_filter.h"
 #include <set>
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <typeinfo>
@@ -229,6 +230,241 @@ bool matchesMaskBegin(const Zstring& name, const std::vector<Zstring>& masks)
 }
 }
 
+//#################################################################################################
+
+/*
+Evaluating a few hundred masks one after the other for each scanned item is slow => compile the literal parts of all masks into an Aho-Corasick automaton:
+
+      mask    | type    | condition for literal occurrence [start, end) in path
+    +---------+---------+-----------------------------------------------------------
+    | abc     | LITERAL | start == 0 and end at path end or separator (folder mask on file: separator only)
+    | abc*    | PREFIX  | start == 0                                  (folder mask on file: separator at or after end)
+    | *abc    | SUFFIX  | end at path end or separator                (folder mask on file: separator only)
+    | *abc*   | INFIX   | any                                         (folder mask on file: separator at or after end)
+    +---------+---------+-----------------------------------------------------------
+
+=> equivalent to matchesMask<AnyMatch> for file+folder masks and matchesMask<ParentFolderMatch> for folder masks applied to files.
+All other masks ('?' or inner '*') are rare and evaluated via matchesMask() directly.
+*/
+class NameFilter::MaskMatcher
+{
+public:
+    MaskMatcher(const std::vector<Zstring>& masksFileFolder, const std::vector<Zstring>& masksFolder)
+    {
+        nodes_.emplace_back(); //root
+
+        for (const Zstring& mask : masksFileFolder) addMask(mask, false /*folderOnly*/);
+        for (const Zstring& mask : masksFolder    ) addMask(mask, true  /*folderOnly*/);
+
+        //breadth-first: failure link of a node is always a node of lower depth
+        std::vector<size_t> queue;
+        for (const auto& child : nodes_[0].children)
+            queue.push_back(child.second);
+
+        for (size_t i = 0; i < queue.size(); ++i)
+        {
+            const size_t nodeIdx = queue[i];
+            for (const auto& child : nodes_[nodeIdx].children)
+            {
+                size_t fail = nodes_[nodeIdx].fail;
+                for (;;)
+                {
+                    const size_t next = findChild(fail, child.first);
+                    if (next != NO_NODE)
+                    {
+                        fail = next;
+                        break;
+                    }
+                    if (fail == 0)
+                        break;
+                    fail = nodes_[fail].fail;
+                }
+                Node& childNode = nodes_[child.second];
+                childNode.fail = fail;
+                childNode.outputLink = !nodes_[fail].patterns.empty() ? fail : nodes_[fail].outputLink;
+
+                queue.push_back(child.second);
+            }
+        }
+    }
+
+    //file+folder masks: matchesMask<AnyMatch>; folder masks: matchesMask<ParentFolderMatch>
+    bool matchesFile(const Zstring& pathFmt) const { return matches(pathFmt, true); }
+
+    //all masks: matchesMask<AnyMatch>
+    bool matchesDir(const Zstring& pathFmt) const { return matches(pathFmt, false); }
+
+private:
+    MaskMatcher           (const MaskMatcher&) = delete;
+    MaskMatcher& operator=(const MaskMatcher&) = delete;
+
+    enum class MaskType
+    {
+        LITERAL,
+        PREFIX,
+        SUFFIX,
+        INFIX,
+    };
+
+    struct Pattern
+    {
+        MaskType type;
+        bool folderOnly;
+        size_t length;
+    };
+
+    static const size_t NO_NODE = static_cast<size_t>(-1);
+
+    struct Node
+    {
+        std::vector<std::pair<Zchar, size_t>> children; //sorted by character
+        size_t fail = 0;                //longest proper suffix which is also a trie path
+        size_t outputLink = NO_NODE;    //next node along failure links having patterns
+        std::vector<size_t> patterns;   //indices into patterns_ of masks ending at this node
+    };
+
+    void addMask(const Zstring& mask, bool folderOnly)
+    {
+        const Zchar* itBegin = mask.c_str();
+        const Zchar* itEnd   = mask.c_str() + mask.size();
+
+        const bool leadingStar  = itBegin != itEnd && *itBegin    == Zstr('*');
+        const bool trailingStar = itBegin != itEnd && itEnd[-1]   == Zstr('*');
+
+        while (itBegin != itEnd && *itBegin  == Zstr('*')) ++itBegin;
+        while (itBegin != itEnd && itEnd[-1] == Zstr('*')) --itEnd;
+
+        if (itBegin == itEnd) //"*"
+        {
+            (folderOnly ? matchAllFolder_ : matchAllFileFolder_) = true;
+            return;
+        }
+
+        if (std::any_of(itBegin, itEnd, [](Zchar c) { return c == Zstr('*') || c == Zstr('?'); }))
+        {
+            (folderOnly ? genericMasksFolder_ : genericMasksFileFolder_).push_back(mask);
+            return;
+        }
+
+        size_t nodeIdx = 0;
+        for (auto it = itBegin; it != itEnd; ++it)
+        {
+            size_t next = findChild(nodeIdx, *it);
+            if (next == NO_NODE)
+            {
+                next = nodes_.size();
+                auto& children = nodes_[nodeIdx].children;
+                children.insert(std::upper_bound(children.begin(), children.end(), *it,
+                [](Zchar c, const std::pair<Zchar, size_t>& child) { return c < child.first; }), std::make_pair(*it, next));
+                nodes_.emplace_back(); //invalidates "children"!
+            }
+            nodeIdx = next;
+        }
+
+        const MaskType type = leadingStar ? (trailingStar ? MaskType::INFIX  : MaskType::SUFFIX) :
+                              /**/          (trailingStar ? MaskType::PREFIX : MaskType::LITERAL);
+
+        nodes_[nodeIdx].patterns.push_back(patterns_.size());
+        patterns_.push_back({ type, folderOnly, static_cast<size_t>(itEnd - itBegin) });
+    }
+
+    size_t findChild(size_t nodeIdx, Zchar c) const
+    {
+        const auto& children = nodes_[nodeIdx].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+        [](const std::pair<Zchar, size_t>& child, Zchar ch) { return child.first < ch; });
+        return it != children.end() && it->first == c ? it->second : NO_NODE;
+    }
+
+    bool matches(const Zstring& pathFmt, bool isFile) const
+    {
+        const Zchar* const path = pathFmt.c_str();
+        const size_t pathLen = pathFmt.size();
+
+        if (matchAllFileFolder_)
+            return true;
+
+        //position after last separator: folder masks applied to files need a separator at or after the end of the match
+        size_t lastSepEnd = 0;
+        if (isFile)
+            for (size_t i = pathLen; i-- != 0;)
+                if (path[i] == FILE_NAME_SEPARATOR)
+                {
+                    lastSepEnd = i + 1;
+                    break;
+                }
+
+        if (matchAllFolder_ && (!isFile || lastSepEnd != 0))
+            return true;
+
+        size_t nodeIdx = 0;
+        for (size_t end = 1; end <= pathLen; ++end)
+        {
+            const Zchar c = path[end - 1];
+            for (;;)
+            {
+                const size_t next = findChild(nodeIdx, c);
+                if (next != NO_NODE)
+                {
+                    nodeIdx = next;
+                    break;
+                }
+                if (nodeIdx == 0)
+                    break;
+                nodeIdx = nodes_[nodeIdx].fail;
+            }
+
+            const bool atSeparator = end != pathLen && path[end] == FILE_NAME_SEPARATOR;
+            const bool atPathEnd   = end == pathLen;
+
+            for (size_t outIdx = !nodes_[nodeIdx].patterns.empty() ? nodeIdx : nodes_[nodeIdx].outputLink;
+                 outIdx != NO_NODE;
+                 outIdx = nodes_[outIdx].outputLink)
+                for (const size_t patternIdx : nodes_[outIdx].patterns)
+                {
+                    const Pattern& p = patterns_[patternIdx];
+                    const bool parentMatch = isFile && p.folderOnly;
+
+                    switch (p.type)
+                    {
+                        case MaskType::LITERAL:
+                            if (p.length == end && (atSeparator || (atPathEnd && !parentMatch)))
+                                return true;
+                            break;
+                        case MaskType::PREFIX:
+                            if (p.length == end && (!parentMatch || end < lastSepEnd))
+                                return true;
+                            break;
+                        case MaskType::SUFFIX:
+                            if (atSeparator || (atPathEnd && !parentMatch))
+                                return true;
+                            break;
+                        case MaskType::INFIX:
+                            if (!parentMatch || end < lastSepEnd)
+                                return true;
+                            break;
+                    }
+                }
+        }
+
+        if (matchesMask<AnyMatch>(pathFmt, genericMasksFileFolder_))
+            return true;
+
+        return isFile ?
+               matchesMask<ParentFolderMatch>(pathFmt, genericMasksFolder_) :
+               matchesMask<AnyMatch         >(pathFmt, genericMasksFolder_);
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<Pattern> patterns_;
+
+    bool matchAllFileFolder_ = false; //"*" contained in file+folder masks
+    bool matchAllFolder_     = false; //"*" contained in folder masks
+
+    std::vector<Zstring> genericMasksFileFolder_; //masks not representable by a single literal
+    std::vector<Zstring> genericMasksFolder_;     //
+};
+
 
 std::vector<Zstring> zen::splitByDelimiter(const Zstring& filterString)
 {
@@ -260,6 +496,9 @@ NameFilter::NameFilter(const Zstring& includePhrase, const Zstring& excludePhras
     removeDuplicates(includeMasksFolder);
     removeDuplicates(excludeMasksFileFolder);
     removeDuplicates(excludeMasksFolder);
+
+    includeMatcher = std::make_shared<const MaskMatcher>(includeMasksFileFolder, includeMasksFolder);
+    excludeMatcher = std::make_shared<const MaskMatcher>(excludeMasksFileFolder, excludeMasksFolder);
 }
 
 
@@ -269,6 +508,8 @@ void NameFilter::addExclusion(const Zstring& excludePhrase)
 
     removeDuplicates(excludeMasksFileFolder);
     removeDuplicates(excludeMasksFolder);
+
+    excludeMatcher = std::make_shared<const MaskMatcher>(excludeMasksFileFolder, excludeMasksFolder);
 }
 
 
@@ -280,12 +521,12 @@ bool NameFilter::passFileFilter(const Zstring& relFilePath) const
     const Zstring& pathFmt = relFilePath; //nothing to do here
 #endif
 
-    if (matchesMask<AnyMatch         >(pathFmt, excludeMasksFileFolder) || //either full match on file or partial match on any parent folder
-        matchesMask<ParentFolderMatch>(pathFmt, excludeMasksFolder))       //partial match on any parent folder only
+    //file+folder masks: either full match on file or partial match on any parent folder
+    //folder masks: partial match on any parent folder only
+    if (excludeMatcher->matchesFile(pathFmt))
         return false;
 
-    return matchesMask<AnyMatch         >(pathFmt, includeMasksFileFolder) ||
-           matchesMask<ParentFolderMatch>(pathFmt, includeMasksFolder);
+    return includeMatcher->matchesFile(pathFmt);
 }
 
 
@@ -299,8 +540,7 @@ bool NameFilter::passDirFilter(const Zstring& relDirPath, bool* childItemMightMa
     const Zstring& pathFmt = relDirPath; //nothing to do here
 #endif
 
-    if (matchesMask<AnyMatch>(pathFmt, excludeMasksFileFolder) ||
-        matchesMask<AnyMatch>(pathFmt, excludeMasksFolder))
+    if (excludeMatcher->matchesDir(pathFmt))
     {
         if (childItemMightMatch)
             *childItemMightMatch = false; //perf: no need to traverse deeper; subfolders/subfiles would be excluded by filter anyway!
@@ -318,8 +558,7 @@ bool NameFilter::passDirFilter(const Zstring& relDirPath, bool* childItemMightMa
         return false;
     }
 
-    if (!matchesMask<AnyMatch>(pathFmt, includeMasksFileFolder) &&
-        !matchesMask<AnyMatch>(pathFmt, includeMasksFolder))
+    if (!includeMatcher->matchesDir(pathFmt))
     {
         if (childItemMightMatch)
         {
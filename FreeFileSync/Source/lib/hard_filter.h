@@ -95,6 +95,10 @@ private:
     std::vector<Zstring> includeMasksFolder;     //upper case (windows) + unique items by construction
     std::vector<Zstring> excludeMasksFileFolder; //
     std::vector<Zstring> excludeMasksFolder;     //
+
+    class MaskMatcher; //all masks of a set compiled into a single automaton: evaluate each path in one pass
+    std::shared_ptr<const MaskMatcher> includeMatcher; //immutable => share among NameFilter copies
+    std::shared_ptr<const MaskMatcher> excludeMatcher; //always bound!
 };
 
 
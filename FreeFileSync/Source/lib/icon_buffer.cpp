@@ -7,10 +7,17 @@
 #include "icon_buffer.h"
 #include <map>
 #include <set>
+#include <list>
+#include <ctime>
 #include <zen/thread.h> //includes <std/thread.hpp>
 #include <zen/scope_guard.h>
+#include <zen/file_access.h>
+#include <zen/file_io.h>
+#include <zen/serialize.h>
 #include <wx+/image_resources.h>
+#include <wx+/zlib_wrap.h>
 #include "icon_loader.h"
+#include "ffs_paths.h"
 
 #ifdef ZEN_WIN
     #include <zen/win_ver.h>
@@ -24,6 +31,9 @@ using AFS = AbstractFileSystem;
 namespace
 {
 const size_t BUFFER_SIZE_MAX = 800; //maximum number of icons to hold in buffer: must be big enough to hold visible icons + preload buffer! Consider OS limit on GDI resources (wxBitmap)!!!
+const size_t ICON_LOADER_THREADS = 4; //loading thumbnails and file icons is I/O bound, especially for network folders
+
+const std::int64_t ICON_CACHE_MAX_AGE = 7 * 24 * 3600; //unit: [s]; reload icons by extension once in a while: icon theme might have changed
 
 #ifndef NDEBUG
     const std::thread::id mainThreadId = std::this_thread::get_id();
@@ -63,6 +73,7 @@ bool hasWindowsLinkExtension(const Zstring& filePath)
            equalNoCase(ext, L"url") ||
            equalNoCase(ext, L"website");
 }
+#endif
 
 
 //test for extension for non-thumbnail icons that can have a stock icon which does not have to be physically read from disc
@@ -71,6 +82,7 @@ bool hasStandardIconExtension(const Zstring& filePath)
 {
     const Zstring ext = getFileExtension(filePath);
 
+#ifdef ZEN_WIN
     if (equalNoCase(ext, L"ani") || //no need for non-POD global with these few comparisons!
         equalNoCase(ext, L"cur") ||
         equalNoCase(ext, L"exe") ||
@@ -80,10 +92,128 @@ bool hasStandardIconExtension(const Zstring& filePath)
         return false;
 
     return !hasWindowsLinkExtension(filePath);
-}
+
+#elif defined ZEN_LINUX
+    //no extension: mime type is determined by full file name (e.g. "AUTHORS") or file content
+    return !ext.empty() && ext != Zstr("desktop"); //desktop entries specify their own icon
+
+#elif defined ZEN_MAC
+    return !ext.empty();
 #endif
 }
 
+
+//---------------------- Persistent Icon Cache -------------------------
+//icons by extension are shared between runs: no icon theme lookups when starting to scroll
+
+const char FILE_FORMAT_DESCR[] = "FreeFileSync";
+const int ICON_CACHE_FORMAT_VER = 1;
+
+using MemStreamOut = MemoryStreamOut<ByteArray>;
+using MemStreamIn  = MemoryStreamIn <ByteArray>;
+
+
+Zstring getIconCachePath(IconBuffer::IconSize sz)
+{
+    return getConfigDir() + Zstr("IconCache-") + numberTo<Zstring>(IconBuffer::getSize(sz)) + Zstr(".ffs_icons");
+}
+
+
+std::map<Zstring, wxBitmap, LessFilePath> loadExtensionIcons(IconBuffer::IconSize sz, std::int64_t& creationTime) //throw FileError
+{
+    const Zstring filePath = getIconCachePath(sz);
+
+    if (!fileExists(filePath)) //no error: first run
+        return {};
+
+    const ByteArray buffer = loadBinContainer<ByteArray>(filePath, nullptr); //throw FileError
+    try
+    {
+        MemStreamIn streamIn(buffer);
+
+        char formatDescr[sizeof(FILE_FORMAT_DESCR)] = {};
+        readArray(streamIn, formatDescr, sizeof(formatDescr)); //throw UnexpectedEndOfStreamError
+
+        if (!std::equal(FILE_FORMAT_DESCR, FILE_FORMAT_DESCR + sizeof(FILE_FORMAT_DESCR), formatDescr) ||
+            readNumber<std::int32_t>(streamIn) != ICON_CACHE_FORMAT_VER)
+            return {}; //outdated or corrupt: rebuild from scratch
+
+        const std::int64_t cacheCreated = readNumber<std::int64_t>(streamIn);
+        if (cacheCreated + ICON_CACHE_MAX_AGE < std::time(nullptr))
+            return {};
+
+        MemStreamIn streamBody(decompress(readContainer<ByteArray>(streamIn))); //throw ZlibInternalError
+
+        std::map<Zstring, wxBitmap, LessFilePath> output;
+        size_t iconCount = readNumber<std::uint32_t>(streamBody);
+        while (iconCount-- != 0)
+        {
+            const Zstring extension = utfCvrtTo<Zstring>(readContainer<Zbase<char>>(streamBody));
+            const int  width     = readNumber<std::int32_t>(streamBody);
+            const int  height    = readNumber<std::int32_t>(streamBody);
+            const bool withAlpha = readNumber<std::int8_t >(streamBody) != 0;
+
+            const int pixelSize = IconBuffer::getSize(sz);
+            if (width <= 0 || height <= 0 || width > pixelSize || height > pixelSize)
+                return {}; //corrupt
+
+            ImageHolder ih(width, height, withAlpha);
+            readArray(streamBody, ih.getRgb(), width * height * 3);
+            if (withAlpha)
+                readArray(streamBody, ih.getAlpha(), width * height);
+
+            output.emplace(extension, extractWxBitmap(std::move(ih)));
+        }
+        creationTime = cacheCreated;
+        return output;
+    }
+    catch (ZlibInternalError&) { return {}; } //corrupt cache file: not an error, just rebuild
+    catch (UnexpectedEndOfStreamError&) { return {}; } //
+}
+
+
+//creationTime: time of the oldest icon lookup => don't renew when adding icons, or the cache would never expire
+void saveExtensionIcons(IconBuffer::IconSize sz, const std::map<Zstring, wxBitmap, LessFilePath>& extensionIcons, std::int64_t creationTime) //throw FileError
+{
+    std::vector<std::pair<Zstring, wxImage>> images;
+    for (const auto& item : extensionIcons)
+        if (item.second.IsOk()) //failed icon lookups are not cached
+            images.emplace_back(item.first, item.second.ConvertToImage());
+
+    MemStreamOut streamBody;
+    writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(images.size()));
+    for (const auto& item : images)
+    {
+        const wxImage& img = item.second;
+        writeContainer(streamBody, utfCvrtTo<Zbase<char>>(item.first));
+        writeNumber<std::int32_t>(streamBody, img.GetWidth());
+        writeNumber<std::int32_t>(streamBody, img.GetHeight());
+        writeNumber<std::int8_t >(streamBody, img.HasAlpha());
+
+        writeArray(streamBody, img.GetData(), img.GetWidth() * img.GetHeight() * 3);
+        if (img.HasAlpha())
+            writeArray(streamBody, img.GetAlpha(), img.GetWidth() * img.GetHeight());
+    }
+
+    const Zstring filePath = getIconCachePath(sz);
+
+    MemStreamOut streamOut;
+    writeArray(streamOut, FILE_FORMAT_DESCR, sizeof(FILE_FORMAT_DESCR));
+    writeNumber<std::int32_t>(streamOut, ICON_CACHE_FORMAT_VER);
+    writeNumber<std::int64_t>(streamOut, creationTime);
+    try
+    {
+        writeContainer(streamOut, compress(streamBody.ref(), 3)); //throw ZlibInternalError
+    }
+    catch (ZlibInternalError&)
+    {
+        throw FileError(replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(filePath)), L"zlib internal error");
+    }
+
+    saveBinContainer(filePath, streamOut.ref(), nullptr); //throw FileError
+}
+}
+
 //################################################################################################################################################
 
 ImageHolder getDisplayIcon(const AbstractPath& itemPath, IconBuffer::IconSize sz)
@@ -189,9 +319,9 @@ public:
         if (it == iconList.end())
             return NoValue();
 
-        markAsHot(it);
-
         IconData& idata = refData(it);
+        priorityList.splice(priorityList.end(), priorityList, idata.priorityPos); //mark as hot: move to end of list, O(1)
+
         if (idata.iconRaw) //if not yet converted...
         {
             idata.iconFmt = std::make_unique<wxBitmap>(extractWxBitmap(std::move(idata.iconRaw))); //convert in main thread!
@@ -207,11 +337,10 @@ public:
 
         //thread safety: moving ImageHolder is free from side effects, but ~wxBitmap() is NOT! => do NOT delete items from iconList here!
         auto rc = iconList.emplace(filePath, makeValueObject());
-        assert(rc.second); //insertion took place
-        if (rc.second)
+        if (rc.second) //else: loaded by another worker thread in the meantime
         {
             refData(rc.first).iconRaw = std::move(icon);
-            priorityListPushBack(rc.first);
+            refData(rc.first).priorityPos = priorityList.insert(priorityList.end(), rc.first);
         }
     }
 
@@ -224,9 +353,8 @@ public:
 
         while (iconList.size() > BUFFER_SIZE_MAX)
         {
-            auto itDelPos = firstInsertPos;
-            priorityListPopFront();
-            iconList.erase(itDelPos); //remove oldest element
+            iconList.erase(priorityList.front()); //remove least recently used element
+            priorityList.pop_front();
         }
     }
 
@@ -243,67 +371,12 @@ private:
     static IconData makeValueObject() { return IconData(); }
 #endif
 
-    //call while holding lock:
-    void priorityListPopFront()
-    {
-        assert(firstInsertPos!= iconList.end());
-        firstInsertPos = refData(firstInsertPos).next_;
-
-        if (firstInsertPos != iconList.end())
-            refData(firstInsertPos).prev_ = iconList.end();
-        else //priority list size > BUFFER_SIZE_MAX in this context, but still for completeness:
-            lastInsertPos = iconList.end();
-    }
-
-    //call while holding lock:
-    void priorityListPushBack(FileIconMap::iterator it)
-    {
-        if (lastInsertPos == iconList.end())
-        {
-            assert(firstInsertPos == iconList.end());
-            firstInsertPos = lastInsertPos = it;
-            refData(it).prev_ = refData(it).next_ = iconList.end();
-        }
-        else
-        {
-            refData(it).next_ = iconList.end();
-            refData(it).prev_ = lastInsertPos;
-            refData(lastInsertPos).next_ = it;
-            lastInsertPos = it;
-        }
-    }
-
-    //call while holding lock:
-    void markAsHot(FileIconMap::iterator it) //mark existing buffer entry as if newly inserted
-    {
-        assert(it != iconList.end());
-        if (refData(it).next_ != iconList.end())
-        {
-            if (refData(it).prev_ != iconList.end())
-            {
-                refData(refData(it).prev_).next_ = refData(it).next_; //remove somewhere from the middle
-                refData(refData(it).next_).prev_ = refData(it).prev_; //
-            }
-            else
-            {
-                assert(it == firstInsertPos);
-                priorityListPopFront();
-            }
-            priorityListPushBack(it);
-        }
-        else
-        {
-            if (refData(it).prev_ != iconList.end())
-                assert(it == lastInsertPos); //nothing to do
-            else
-                assert(iconList.size() == 1 && it == firstInsertPos && it == lastInsertPos); //nothing to do
-        }
-    }
+    using PriorityList = std::list<FileIconMap::iterator>; //sorted by time of last access: least recently used first
 
     struct IconData
     {
         IconData() {}
-        IconData(IconData&& tmp) : iconRaw(std::move(tmp.iconRaw)), iconFmt(std::move(tmp.iconFmt)), prev_(tmp.prev_), next_(tmp.next_) {}
+        IconData(IconData&& tmp) : iconRaw(std::move(tmp.iconRaw)), iconFmt(std::move(tmp.iconFmt)), priorityPos(tmp.priorityPos) {}
 
         ImageHolder iconRaw; //native icon representation: may be used by any thread
 
@@ -313,14 +386,12 @@ private:
         //- prohibit calls to ~wxBitmap() and transitively ~IconData()
         //- prohibit even wxBitmap() default constructor - better be safe than sorry!
 
-        FileIconMap::iterator prev_; //store list sorted by time of insertion into buffer
-        FileIconMap::iterator next_; //
+        PriorityList::iterator priorityPos;
     };
 
     mutable std::mutex lockIconList;
     FileIconMap iconList; //shared resource; Zstring is thread-safe like an int
-    FileIconMap::iterator firstInsertPos = iconList.end();
-    FileIconMap::iterator lastInsertPos  = iconList.end();
+    PriorityList priorityList;
 };
 
 //################################################################################################################################################
@@ -401,24 +472,42 @@ struct IconBuffer::Pimpl
     std::shared_ptr<WorkLoad> workload = std::make_shared<WorkLoad>();
     std::shared_ptr<Buffer>   buffer   = std::make_shared<Buffer>();
 
-    InterruptibleThread worker;
+    std::vector<InterruptibleThread> worker;
 
     //-------------------------
     std::map<Zstring, wxBitmap, LessFilePath> extensionIcons;
+    std::int64_t extensionIconsCreated = 0; //0 if no icons were loaded from the persistent icon cache
+    bool extensionIconsAdded = false; //=> update persistent icon cache
 };
 
 
 IconBuffer::IconBuffer(IconSize sz) : pimpl(std::make_unique<Pimpl>()), iconSizeType(sz)
 {
-    pimpl->worker = InterruptibleThread(WorkerThread(pimpl->workload, pimpl->buffer, sz));
+    try
+    {
+        pimpl->extensionIcons = loadExtensionIcons(sz, pimpl->extensionIconsCreated); //throw FileError
+    }
+    catch (FileError&) {} //not critical: just a cache
+
+    for (size_t i = 0; i < ICON_LOADER_THREADS; ++i)
+        pimpl->worker.emplace_back(WorkerThread(pimpl->workload, pimpl->buffer, sz));
 }
 
 
 IconBuffer::~IconBuffer()
 {
     setWorkload({}); //make sure interruption point is always reached!
-    pimpl->worker.interrupt();
-    pimpl->worker.join();
+    for (InterruptibleThread& wt : pimpl->worker)
+        wt.interrupt(); //interrupt all at once, then join
+    for (InterruptibleThread& wt : pimpl->worker)
+        wt.join();
+
+    if (pimpl->extensionIconsAdded)
+        try
+        {
+            saveExtensionIcons(iconSizeType, pimpl->extensionIcons, pimpl->extensionIconsCreated != 0 ? pimpl->extensionIconsCreated : std::time(nullptr)); //throw FileError
+        }
+        catch (FileError&) {} //not critical: next run will look up icons again
 }
 
 
@@ -449,24 +538,21 @@ int IconBuffer::getSize(IconSize sz)
 
 bool IconBuffer::readyForRetrieval(const AbstractPath& filePath)
 {
-#ifdef ZEN_WIN
     if (iconSizeType == IconBuffer::SIZE_SMALL)
         if (hasStandardIconExtension(AFS::getFileShortName(filePath)))
             return true;
-#endif
+
     return pimpl->buffer->hasIcon(filePath);
 }
 
 
 Opt<wxBitmap> IconBuffer::retrieveFileIcon(const AbstractPath& filePath)
 {
-#ifdef ZEN_WIN
     //perf: let's read icons which don't need file access right away! No async delay justified!
     const Zstring fileName = AFS::getFileShortName(filePath);
     if (iconSizeType == IconBuffer::SIZE_SMALL) //non-thumbnail view, we need file type icons only!
         if (hasStandardIconExtension(fileName))
             return this->getIconByExtension(fileName); //buffered!!!
-#endif
 
     if (Opt<wxBitmap> ico = pimpl->buffer->retrieve(filePath))
         return ico;
@@ -500,6 +586,7 @@ wxBitmap IconBuffer::getIconByExtension(const Zstring& filePath)
         //don't pass actual file name to getIconByTemplatePath(), e.g. "AUTHORS" has own mime type on Linux!!!
         //=> we want to buffer by extension only to minimize buffer-misses!
         it = pimpl->extensionIcons.emplace(extension, extractWxBitmap(getIconByTemplatePath(templateName, IconBuffer::getSize(iconSizeType)))).first;
+        pimpl->extensionIconsAdded = true;
     }
     //need buffer size limit???
     return it->second;
@@ -13,6 +13,7 @@
     #include "file_icon_win.h"
 
 #elif defined ZEN_LINUX
+    #include <mutex>
     #include <gtk/gtk.h>
     #include <sys/stat.h>
 
@@ -118,8 +119,11 @@ ImageHolder getIconByAttribute(LPCWSTR pszPath, DWORD dwFileAttributes, int pixe
 }
 
 #elif defined ZEN_LINUX
+std::mutex lockIconTheme; //GtkIconTheme is not thread-safe: IconBuffer loads icons from multiple threads
+
 ImageHolder imageHolderFromGicon(GIcon* gicon, int pixelSize)
 {
+    std::lock_guard<std::mutex> dummy(lockIconTheme);
     if (gicon)
         if (GtkIconTheme* defaultTheme = ::gtk_icon_theme_get_default()) //not owned!
             if (GtkIconInfo* iconInfo = ::gtk_icon_theme_lookup_by_gicon(defaultTheme, gicon, pixelSize, GTK_ICON_LOOKUP_USE_BUILTIN)) //this may fail if icon is not installed on system
@@ -0,0 +1,231 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#include "parallel_compare.h"
+#include <set>
+#include <deque>
+#include <zen/file_access.h>
+#include <zen/thread.h>
+#include <zen/scope_guard.h>
+#include <zen/fixed_list.h>
+#include "binary.h"
+#include "status_handler_impl.h"
+#include "status_handler_async.h"
+
+using namespace zen;
+using AFS = AbstractFileSystem;
+
+
+size_t DeviceCatalog::getDeviceIndex(const AbstractPath& baseFolderPath) //noexcept
+{
+    auto it = devIdxByFolder.find(baseFolderPath);
+    if (it != devIdxByFolder.end())
+        return it->second;
+
+    size_t devIdx = deviceCount;
+    if (Opt<Zstring> nativePath = AFS::getNativeItemPath(baseFolderPath))
+        try
+        {
+            auto rv = devIdxByVolume.emplace(getVolumeId(*nativePath), deviceCount); //throw FileError
+            devIdx = rv.first->second;
+        }
+        catch (FileError&) {} //e.g. base folder not existing: assume independent device
+    //else: unknown device, e.g. SFTP: assume independent
+
+    if (devIdx == deviceCount)
+        ++deviceCount;
+
+    devIdxByFolder.emplace(baseFolderPath, devIdx);
+    return devIdx;
+}
+
+
+namespace
+{
+//-------------------------------------------------------------------------------------------------
+
+class TaskScheduler
+{
+public:
+    TaskScheduler(const std::vector<BinaryCompareTask>& workLoad, size_t threadsPerDevice) :
+        workLoad_(workLoad),
+        threadsPerDevice_(std::max<size_t>(threadsPerDevice, 1))
+    {
+        //keep original order within each device combination: process files of the same folder one after another
+        for (size_t i = 0; i < workLoad.size(); ++i)
+            pendingByDevice[std::make_pair(workLoad[i].deviceL, workLoad[i].deviceR)].push_back(i);
+    }
+
+    //context of worker thread: returns false if all tasks are taken
+    bool getNextTask(size_t& taskIdx) //throw ThreadInterruption
+    {
+        std::unique_lock<std::mutex> dummy(lockTasks);
+        auto itGroup = pendingByDevice.end();
+        interruptibleWait(conditionDeviceAvailable, dummy, [&] { return pendingByDevice.empty() || (itGroup = findAvailableGroup()) != pendingByDevice.end(); }); //throw ThreadInterruption
+
+        if (pendingByDevice.empty())
+            return false;
+
+        std::deque<size_t>& pending = itGroup->second;
+        taskIdx = pending.front();
+        pending.pop_front();
+        if (pending.empty())
+            pendingByDevice.erase(itGroup);
+
+        ++activeByDevice[workLoad_[taskIdx].deviceL];
+        if (workLoad_[taskIdx].deviceR != workLoad_[taskIdx].deviceL)
+            ++activeByDevice[workLoad_[taskIdx].deviceR];
+        return true;
+    }
+
+    //context of worker thread
+    void notifyTaskDone(size_t taskIdx)
+    {
+        {
+            std::lock_guard<std::mutex> dummy(lockTasks);
+            --activeByDevice[workLoad_[taskIdx].deviceL];
+            if (workLoad_[taskIdx].deviceR != workLoad_[taskIdx].deviceL)
+                --activeByDevice[workLoad_[taskIdx].deviceR];
+        }
+        conditionDeviceAvailable.notify_all(); //instead of notify_one(); workaround bug: https://svn.boost.org/trac/boost/ticket/7796
+    }
+
+private:
+    TaskScheduler           (const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    using DeviceGroups = std::map<std::pair<size_t, size_t>, std::deque<size_t>>; //(left device, right device) => task indexes
+
+    DeviceGroups::iterator findAvailableGroup() //called with lockTasks held
+    {
+        for (auto it = pendingByDevice.begin(); it != pendingByDevice.end(); ++it)
+            if (activeByDevice[it->first.first ] < threadsPerDevice_ &&
+                activeByDevice[it->first.second] < threadsPerDevice_)
+                return it;
+        return pendingByDevice.end();
+    }
+
+    const std::vector<BinaryCompareTask>& workLoad_;
+    const size_t threadsPerDevice_;
+
+    std::mutex lockTasks;
+    std::condition_variable conditionDeviceAvailable;
+    DeviceGroups pendingByDevice;
+    std::map<size_t, size_t> activeByDevice; //device => number of running comparisons
+};
+
+
+class WorkerThread
+{
+public:
+    WorkerThread(const std::vector<BinaryCompareTask>& workLoad,
+                 std::vector<BinaryCompareResult>& results,
+                 const std::shared_ptr<TaskScheduler>& scheduler,
+                 const std::shared_ptr<AsyncProcessCallback>& acb) :
+        workLoad_(workLoad),
+        results_(results),
+        scheduler_(scheduler),
+        acb_(acb) {}
+
+    void operator()() //thread entry
+    {
+#ifdef ZEN_WIN
+        setCurrentThreadName("Binary Comparison");
+#endif
+        WorkerProcessCallback callback(*acb_);
+
+        size_t taskIdx = 0;
+        while (scheduler_->getNextTask(taskIdx)) //throw ThreadInterruption
+        {
+            acb_->incActiveWorker();
+            ZEN_ON_SCOPE_EXIT(acb_->decActiveWorker());
+
+            const BinaryCompareTask& task = workLoad_[taskIdx];
+            BinaryCompareResult& result = results_[taskIdx]; //each task is processed by a single thread => no locking required
+
+            callback.reportStatus(replaceCpy(txtComparingContentOfFiles, L"%x", task.displayPath)); //throw ThreadInterruption
+
+            result.errMsg = tryReportingError([&]
+            {
+                StatisticsReporter statReporter(1, task.fileSize, callback);
+
+                auto onUpdateStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
+
+                result.haveSameContent = filesHaveSameContent(task.filePathL, task.filePathR, onUpdateStatus); //throw FileError, ThreadInterruption
+                statReporter.reportDelta(1, 0);
+
+                statReporter.reportFinished();
+            }, callback); //throw ThreadInterruption
+
+            scheduler_->notifyTaskDone(taskIdx);
+        }
+    }
+
+private:
+    const std::vector<BinaryCompareTask>& workLoad_;
+    std::vector<BinaryCompareResult>& results_;
+    std::shared_ptr<TaskScheduler> scheduler_;
+    std::shared_ptr<AsyncProcessCallback> acb_;
+    const std::wstring txtComparingContentOfFiles = _("Comparing content of files %x");
+};
+}
+
+
+std::vector<BinaryCompareResult> zen::compareFilesBinary(const std::vector<BinaryCompareTask>& workLoad, //throw X
+                                                         size_t threadsPerDevice,
+                                                         ProcessCallback& callback)
+{
+    std::vector<BinaryCompareResult> results(workLoad.size());
+    if (workLoad.empty())
+        return results;
+
+    std::set<size_t> devices;
+    for (const BinaryCompareTask& task : workLoad)
+    {
+        devices.insert(task.deviceL);
+        devices.insert(task.deviceR);
+    }
+    //upper bound: scheduler enforces the per-device limit
+    const size_t threadCount = std::min(workLoad.size(), std::max<size_t>(threadsPerDevice, 1) * devices.size());
+
+    FixedList<InterruptibleThread> worker;
+
+    ZEN_ON_SCOPE_FAIL
+    (
+        for (InterruptibleThread& wt : worker)
+        wt.interrupt(); //interrupt all at once first, then join
+        for (InterruptibleThread& wt : worker)
+            if (wt.joinable()) //= precondition of thread::join(), which throws an exception if violated!
+                wt.join();     //in this context it is possible a thread is *not* joinable anymore due to the thread::try_join_for() below!
+            );
+
+    auto scheduler = std::make_shared<TaskScheduler>(workLoad, threadsPerDevice);
+    auto acb       = std::make_shared<AsyncProcessCallback>();
+
+    for (size_t i = 0; i < threadCount; ++i)
+        worker.emplace_back(WorkerThread(workLoad, results, scheduler, acb));
+
+    //wait until done
+    for (InterruptibleThread& wt : worker)
+    {
+        do
+        {
+            //update status
+            const std::wstring statusText = acb->getCurrentStatus();
+            if (!statusText.empty())
+                callback.reportStatus(statusText); //throw!
+            else
+                callback.requestUiRefresh(); //throw!
+
+            //process statistics and errors
+            acb->processRequests(callback); //throw!
+        }
+        while (!wt.tryJoinFor(std::chrono::milliseconds(UI_UPDATE_INTERVAL / 2)));
+    }
+
+    acb->processRequests(callback); //report remaining deltas after all threads have finished
+    return results;
+}
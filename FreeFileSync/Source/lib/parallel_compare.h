@@ -0,0 +1,57 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#ifndef PARALLEL_COMPARE_H_7834957834957349857
+#define PARALLEL_COMPARE_H_7834957834957349857
+
+#include <map>
+#include <vector>
+#include <zen/optional.h>
+#include <zen/file_id_def.h>
+#include "../fs/abstract.h"
+#include "../process_callback.h"
+
+
+namespace zen
+{
+//group base folders by device: file comparisons accessing the same device share a concurrency limit
+class DeviceCatalog
+{
+public:
+    size_t getDeviceIndex(const AbstractPath& baseFolderPath); //noexcept
+
+private:
+    std::map<AbstractPath, size_t, AbstractFileSystem::LessAbstractPath> devIdxByFolder;
+    std::map<VolumeId, size_t> devIdxByVolume;
+    size_t deviceCount = 0;
+};
+
+
+struct BinaryCompareTask
+{
+    AbstractPath filePathL;
+    AbstractPath filePathR;
+    std::uint64_t fileSize; //same on both sides
+    std::wstring displayPath; //for status messages
+    size_t deviceL; //see DeviceCatalog
+    size_t deviceR; //
+};
+
+
+struct BinaryCompareResult
+{
+    bool haveSameContent = false;
+    Opt<std::wstring> errMsg; //ignored error
+};
+
+//compare files concurrently: up to "threadsPerDevice" comparisons may access the same device at a time
+//status updates and error reporting are executed in the context of the calling thread
+std::vector<BinaryCompareResult> compareFilesBinary(const std::vector<BinaryCompareTask>& workLoad, //throw X
+                                                    size_t threadsPerDevice,
+                                                    ProcessCallback& callback);
+}
+
+#endif //PARALLEL_COMPARE_H_7834957834957349857
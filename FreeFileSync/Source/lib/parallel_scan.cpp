@@ -5,113 +5,22 @@
 // *****************************************************************************
 
 #include "parallel_scan.h"
+#include <deque>
 #include <zen/file_error.h>
+#include <zen/file_access.h>
 #include <zen/thread.h>
 #include <zen/scope_guard.h>
 #include <zen/fixed_list.h>
 #include <zen/tick_count.h>
 #include "db_file.h"
 #include "lock_holder.h"
+#include "scan_snapshot.h"
 
 using namespace zen;
 
 
 namespace
 {
-/*
-#ifdef ZEN_WIN
-
-struct DiskInfo
-{
-    DiskInfo() :
-        driveType(DRIVE_UNKNOWN),
-        diskID(-1) {}
-
-    UINT driveType;
-    int diskID; // -1 if id could not be determined, this one is filled if driveType == DRIVE_FIXED or DRIVE_REMOVABLE;
-};
-
-inline
-bool operator<(const DiskInfo& lhs, const DiskInfo& rhs)
-{
-    if (lhs.driveType != rhs.driveType)
-        return lhs.driveType < rhs.driveType;
-
-    if (lhs.diskID < 0 || rhs.diskID < 0)
-        return false;
-    //consider "same", reason: one volume may be uniquely associated with one disk, while the other volume is associated to the same disk AND another one!
-    //volume <-> disk is 0..N:1..N
-
-    return lhs.diskID < rhs.diskID ;
-}
-
-
-DiskInfo retrieveDiskInfo(const Zstring& itemPath)
-{
-    std::vector<wchar_t> volName(std::max(pathName.size(), static_cast<size_t>(10000)));
-
-    DiskInfo output;
-
-    //full pathName need not yet exist!
-    if (!::GetVolumePathName(itemPath.c_str(),  //__in   LPCTSTR lpszFileName,
-                             &volName[0],       //__out  LPTSTR lpszVolumePathName,
-                             static_cast<DWORD>(volName.size()))) //__in   DWORD cchBufferLength
-        return output;
-
-    const Zstring rootPathName = &volName[0];
-
-    output.driveType = ::GetDriveType(rootPathName.c_str());
-
-    if (output.driveType == DRIVE_NO_ROOT_DIR) //these two should be the same error category
-        output.driveType = DRIVE_UNKNOWN;
-
-    if (output.driveType != DRIVE_FIXED && output.driveType != DRIVE_REMOVABLE)
-        return output; //no reason to get disk ID
-
-    //go and find disk id:
-
-    //format into form: "\\.\C:"
-    Zstring volnameFmt = rootPathName;
-    if (endsWith(volnameFmt, FILE_NAME_SEPARATOR))
-        volnameFmt.pop_back();
-    volnameFmt = L"\\\\.\\" + volnameFmt;
-
-    HANDLE hVolume = ::CreateFile(volnameFmt.c_str(),
-                                  0,
-                                  FILE_SHARE_READ | FILE_SHARE_WRITE,
-                                  nullptr,
-                                  OPEN_EXISTING,
-                                  0,
-                                  nullptr);
-    if (hVolume == INVALID_HANDLE_VALUE)
-        return output;
-    ZEN_ON_SCOPE_EXIT(::CloseHandle(hVolume));
-
-    std::vector<char> buffer(sizeof(VOLUME_DISK_EXTENTS) + sizeof(DISK_EXTENT)); //reserve buffer for at most one disk! call below will then fail if volume spans multiple disks!
-
-    DWORD bytesReturned = 0;
-    if (!::DeviceIoControl(hVolume,                              //_In_         HANDLE hDevice,
-                           IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, //_In_         DWORD dwIoControlCode,
-                           nullptr,                              //_In_opt_     LPVOID lpInBuffer,
-                           0,                                    //_In_         DWORD nInBufferSize,
-                           &buffer[0],                           //_Out_opt_    LPVOID lpOutBuffer,
-                           static_cast<DWORD>(buffer.size()),    //_In_         DWORD nOutBufferSize,
-                           &bytesReturned,                       //_Out_opt_    LPDWORD lpBytesReturned
-                           nullptr))                             //_Inout_opt_  LPOVERLAPPED lpOverlapped
-        return output;
-
-    const VOLUME_DISK_EXTENTS& volDisks = *reinterpret_cast<VOLUME_DISK_EXTENTS*>(&buffer[0]);
-
-    if (volDisks.NumberOfDiskExtents != 1)
-        return output;
-
-    output.diskID = volDisks.Extents[0].DiskNumber;
-
-    return output;
-}
-#endif
-*/
-
 /*
 PERF NOTE
 
@@ -134,20 +43,7 @@ Windows 7:                                        Windows XP:
 2 Threads:         42s      |        11s             2 Threads:         38s      |         8s
 
 => Traversing does not take any advantage of file locality so that even multiple threads operating on the same disk impose no performance overhead! (even faster on XP)
-
-std::vector<std::set<DirectoryKey>> separateByDistinctDisk(const std::set<DirectoryKey>& dirkeys)
-{
-    //use one thread per physical disk:
-    using DiskKeyMapping = std::map<DiskInfo, std::set<DirectoryKey>>;
-    DiskKeyMapping tmp;
-    std::for_each(dirkeys.begin(), dirkeys.end(),
-    [&](const DirectoryKey& key) { tmp[retrieveDiskInfo(key.dirpathFull_)].insert(key); });
-
-    std::vector<std::set<DirectoryKey>> buckets;
-    std::transform(tmp.begin(), tmp.end(), std::back_inserter(buckets),
-    [&](const DiskKeyMapping::value_type& diskToKey) { return diskToKey.second; });
-    return buckets;
-}
+=> fillBuffer() runs a separate pool of worker threads per device, all threads of a pool are sharing the sub-folder traversals of the device's base folders
 */
 
 //------------------------------------------------------------------------------------------
@@ -267,35 +163,198 @@ private:
     std::atomic<int> activeWorker{ 0 }; //
 };
 
+
 //-------------------------------------------------------------------------------------------------
 
-struct TraverserConfig
+class TraverserConfig //shared by all threads working on the same base folder
 {
 public:
-    TraverserConfig(int threadID,
-                    const AbstractPath& baseFolderPath,
+    TraverserConfig(const AbstractPath& baseFolderPath,
                     const HardFilter::FilterRef& filter,
                     SymLinkHandling handleSymlinks,
                     std::map<Zstring, std::wstring, LessFilePath>& failedFolderReads,
                     std::map<Zstring, std::wstring, LessFilePath>& failedItemReads,
+                    bool useSnapshot,
+                    ScanSnapshot&& lastSnapshot,
+                    const ChangeListPos& changeListPos,
+                    std::set<Zstring, LessFilePath>&& changedFolders,
+                    bool skipUnchangedFolders,
                     AsyncCallback& acb) :
         baseFolderPath_(baseFolderPath),
         filter_(filter),
         handleSymlinks_(handleSymlinks),
+        useSnapshot_(useSnapshot),
+        acb_(acb),
         failedDirReads_ (failedFolderReads),
         failedItemReads_(failedItemReads),
-        acb_(acb),
-        threadID_(threadID) {}
+        lastSnapshot_(std::move(lastSnapshot)),
+        changedFolders_(std::move(changedFolders)),
+        skipUnchangedFolders_(skipUnchangedFolders)
+    {
+        newSnapshot_.changeListPos = changeListPos;
+    }
+
+    void addFailedFolderRead(const Zstring& folderRelPath, const std::wstring& msg)
+    {
+        std::lock_guard<std::mutex> dummy(lockFailedReads);
+        failedDirReads_[folderRelPath] = msg;
+    }
+
+    void addFailedItemRead(const Zstring& itemRelPath, const std::wstring& msg)
+    {
+        std::lock_guard<std::mutex> dummy(lockFailedReads);
+        failedItemReads_[itemRelPath] = msg;
+    }
+
+    //lastSnapshot_ is not modified structurally while worker threads are running => no locking required
+    const FolderSnapshot* getLastSnapshot(const Zstring& folderRelPath, const FolderSignature& sig) const
+    {
+        if (changedFolders_.find(folderRelPath) != changedFolders_.end())
+            return nullptr; //reported by RealTimeSync: e.g. file content modified in place, which does not change the folder signature
+
+        auto it = lastSnapshot_.folders.find(folderRelPath);
+        if (it != lastSnapshot_.folders.end() && it->second.signature == sig)
+            return &it->second;
+        return nullptr;
+    }
+
+    //RealTimeSync recorded all changes since the last scan and none for this folder => no need to check the folder signature
+    //each folder is handled by a single task => caller may move the snapshot without locking
+    FolderSnapshot* getUnchangedSnapshot(const Zstring& folderRelPath)
+    {
+        if (skipUnchangedFolders_ && changedFolders_.find(folderRelPath) == changedFolders_.end())
+        {
+            auto it = lastSnapshot_.folders.find(folderRelPath);
+            if (it != lastSnapshot_.folders.end())
+                return &it->second;
+        }
+        return nullptr;
+    }
+
+    void addSnapshot(const Zstring& folderRelPath, FolderSnapshot&& snapshot)
+    {
+        std::lock_guard<std::mutex> dummy(lockSnapshot);
+        newSnapshot_.folders[folderRelPath] = std::move(snapshot);
+    }
+
+    const ScanSnapshot& getNewSnapshot() const { return newSnapshot_; } //context of main thread after all workers have finished
 
     const AbstractPath baseFolderPath_;
     const HardFilter::FilterRef filter_; //always bound!
     const SymLinkHandling handleSymlinks_;
+    const bool useSnapshot_;
+
+    AsyncCallback& acb_;
+
+private:
+    TraverserConfig           (const TraverserConfig&) = delete;
+    TraverserConfig& operator=(const TraverserConfig&) = delete;
 
+    std::mutex lockFailedReads;
     std::map<Zstring, std::wstring, LessFilePath>& failedDirReads_;
     std::map<Zstring, std::wstring, LessFilePath>& failedItemReads_;
 
-    AsyncCallback& acb_;
-    const int threadID_;
+    ScanSnapshot lastSnapshot_;
+    const std::set<Zstring, LessFilePath> changedFolders_; //relative paths of folders reported as changed by RealTimeSync
+    const bool skipUnchangedFolders_;
+
+    std::mutex lockSnapshot;
+    ScanSnapshot newSnapshot_;
+};
+
+
+struct TraverserTask
+{
+    TraverserConfig* cfg = nullptr;    //always bound
+    Zstring folderRelPath;             //empty for base folder
+    FolderContainer* output = nullptr; //always bound
+    int level = 0;
+};
+
+
+/*
+work-stealing scheduler for the worker threads of a single device:
+    - each thread processes its own queue in LIFO order: depth-first => few pending tasks + directory locality
+    - idle threads steal from the front of the other queues: FIFO => take over the biggest unprocessed sub trees
+    - a single lock is sufficient: traversing is I/O bound and there is only one task per folder
+*/
+class TaskScheduler
+{
+public:
+    TaskScheduler(size_t threadCount) : taskQueues(std::max<size_t>(threadCount, 1)) {}
+
+    size_t getThreadCount() const { return taskQueues.size(); }
+
+    void addTask(size_t queueIdx, TraverserTask&& task)
+    {
+        {
+            std::lock_guard<std::mutex> dummy(lockQueues);
+            taskQueues[queueIdx].push_back(std::move(task));
+            ++tasksQueued;
+            ++tasksPending;
+        }
+        conditionQueueChanged.notify_all(); //instead of notify_one(); workaround bug: https://svn.boost.org/trac/boost/ticket/7796
+    }
+
+    //context of worker thread: returns false if all tasks are done
+    bool getNextTask(size_t queueIdx, TraverserTask& task) //throw ThreadInterruption
+    {
+        std::unique_lock<std::mutex> dummy(lockQueues);
+        interruptibleWait(conditionQueueChanged, dummy, [this] { return tasksQueued > 0 || tasksPending == 0; }); //throw ThreadInterruption
+
+        if (tasksQueued == 0)
+            return false;
+
+        std::deque<TraverserTask>& ownQueue = taskQueues[queueIdx];
+        if (!ownQueue.empty())
+        {
+            task = std::move(ownQueue.back());
+            ownQueue.pop_back();
+        }
+        else
+            for (size_t i = 1; i < taskQueues.size(); ++i)
+            {
+                std::deque<TraverserTask>& otherQueue = taskQueues[(queueIdx + i) % taskQueues.size()];
+                if (!otherQueue.empty())
+                {
+                    task = std::move(otherQueue.front());
+                    otherQueue.pop_front();
+                    break;
+                }
+            }
+        --tasksQueued;
+        return true;
+    }
+
+    //context of worker thread
+    void notifyTaskDone()
+    {
+        {
+            std::lock_guard<std::mutex> dummy(lockQueues);
+            assert(tasksPending > 0);
+            if (--tasksPending > 0)
+                return;
+        }
+        conditionQueueChanged.notify_all(); //all done: wake up idle threads so that they can quit
+    }
+
+private:
+    TaskScheduler           (const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    std::mutex lockQueues;
+    std::condition_variable conditionQueueChanged;
+    std::vector<std::deque<TraverserTask>> taskQueues; //one per worker thread
+    size_t tasksQueued  = 0; //
+    size_t tasksPending = 0; //queued + currently executing
+};
+
+
+struct WorkerContext //owned by a single worker thread
+{
+    TaskScheduler& scheduler;
+    const size_t queueIdx;
+    const int threadID;
     TickVal lastReportTime;
 };
 
@@ -304,12 +363,16 @@ class DirCallback : public AFS::TraverserCallback
 {
 public:
     DirCallback(TraverserConfig& config,
+                WorkerContext& ctx,
                 const Zstring& parentRelPathPf, //postfixed with FILE_NAME_SEPARATOR!
                 FolderContainer& output,
+                FolderSnapshot* snapshotOut, //optional: record unfiltered folder content
                 int level) :
         cfg(config),
+        ctx_(ctx),
         parentRelPathPf_(parentRelPathPf),
         output_(output),
+        snapshotOut_(snapshotOut),
         level_(level) {}
 
     virtual void                               onFile   (const FileInfo&    fi) override; //
@@ -319,10 +382,17 @@ public:
     HandleError reportDirError (const std::wstring& msg, size_t retryNumber)                          override; //throw ThreadInterruption
     HandleError reportItemError(const std::wstring& msg, size_t retryNumber, const Zstring& itemName) override; //
 
+    bool haveIgnoredErrors() const { return ignoredErrors; }
+
+    void onFolderComplete(); //sort folder content and schedule sub folders
+
 private:
     TraverserConfig& cfg;
+    WorkerContext& ctx_;
     const Zstring parentRelPathPf_;
     FolderContainer& output_;
+    FolderSnapshot* const snapshotOut_;
+    bool ignoredErrors = false; //incomplete folder content must not be recorded in the snapshot
     const int level_;
 };
 
@@ -336,10 +406,13 @@ void DirCallback::onFile(const FileInfo& fi) //throw ThreadInterruption
         endsWith(fi.itemName, LOCK_FILE_ENDING))
         return;
 
+    if (snapshotOut_)
+        snapshotOut_->files[fi.itemName] = FileDescriptor(fi.lastWriteTime, fi.fileSize, fi.id, fi.symlinkInfo != nullptr);
+
     const Zstring fileRelPath = parentRelPathPf_ + fi.itemName;
 
     //update status information no matter whether item is excluded or not!
-    if (cfg.acb_.mayReportCurrentFile(cfg.threadID_, cfg.lastReportTime))
+    if (cfg.acb_.mayReportCurrentFile(ctx_.threadID, ctx_.lastReportTime))
         cfg.acb_.reportCurrentFile(AFS::getDisplayPath(AFS::appendRelPath(cfg.baseFolderPath_, fileRelPath)));
 
     //------------------------------------------------------------------------------------
@@ -368,10 +441,13 @@ std::unique_ptr<AFS::TraverserCallback> DirCallback::onDir(const DirInfo& di) //
 {
     interruptionPoint(); //throw ThreadInterruption
 
+    if (snapshotOut_)
+        snapshotOut_->folders.insert(di.itemName);
+
     const Zstring& folderRelPath = parentRelPathPf_ + di.itemName;
 
     //update status information no matter whether item is excluded or not!
-    if (cfg.acb_.mayReportCurrentFile(cfg.threadID_, cfg.lastReportTime))
+    if (cfg.acb_.mayReportCurrentFile(ctx_.threadID, ctx_.lastReportTime))
         cfg.acb_.reportCurrentFile(AFS::getDisplayPath(AFS::appendRelPath(cfg.baseFolderPath_, folderRelPath)));
 
     //------------------------------------------------------------------------------------
@@ -382,19 +458,29 @@ std::unique_ptr<AFS::TraverserCallback> DirCallback::onDir(const DirInfo& di) //
         return nullptr; //do NOT traverse subdirs
     //else: attention! ensure directory filtering is applied later to exclude actually filtered directories
 
-    FolderContainer& subFolder = output_.addSubFolder(di.itemName);
+    output_.addSubFolder(di.itemName); //traversed after this folder is complete: see onFolderComplete()
     if (passFilter)
         cfg.acb_.incItemsScanned(); //add 1 element to the progress indicator
 
     //------------------------------------------------------------------------------------
-    if (level_ > 100) //Win32 traverser: stack overflow approximately at level 1000
-        if (!tryReportingItemError([&] //check after FolderContainer::addSubFolder()
+    if (level_ > 100) //catch endless recursion, e.g. followed symlinks pointing to a parent folder
+        tryReportingItemError([&] //check after FolderContainer::addSubFolder(); sub folders are not scheduled: see onFolderComplete()
     {
         throw FileError(replaceCpy(_("Cannot enumerate directory %x."), L"%x", AFS::getDisplayPath(AFS::appendRelPath(cfg.baseFolderPath_, folderRelPath))), L"Endless recursion.");
-        }, *this, di.itemName))
-    return nullptr;
+    }, *this, di.itemName);
 
-    return std::make_unique<DirCallback>(cfg, folderRelPath + FILE_NAME_SEPARATOR, subFolder, level_ + 1); //releaseDirTraverser() is guaranteed to be called in any case
+    return nullptr; //don't recurse on the current thread: onFolderComplete() schedules separate tasks that may be stolen by idle worker threads
+}
+
+
+void DirCallback::onFolderComplete()
+{
+    //sort while this folder's FolderContainer is accessed by the current thread only: sub folder tasks hold references into "output_.folders"!
+    output_.sortItems();
+
+    if (level_ <= 100) //see onDir()
+        for (auto& item : output_.folders)
+            ctx_.scheduler.addTask(ctx_.queueIdx, { &cfg, parentRelPathPf_ + item.first, &item.second, level_ + 1 });
 }
 
 
@@ -405,7 +491,7 @@ DirCallback::HandleLink DirCallback::onSymlink(const SymlinkInfo& si) //throw Th
     const Zstring& linkRelPath = parentRelPathPf_ + si.itemName;
 
     //update status information no matter whether item is excluded or not!
-    if (cfg.acb_.mayReportCurrentFile(cfg.threadID_, cfg.lastReportTime))
+    if (cfg.acb_.mayReportCurrentFile(ctx_.threadID, ctx_.lastReportTime))
         cfg.acb_.reportCurrentFile(AFS::getDisplayPath(AFS::appendRelPath(cfg.baseFolderPath_, linkRelPath)));
 
     switch (cfg.handleSymlinks_)
@@ -414,6 +500,9 @@ DirCallback::HandleLink DirCallback::onSymlink(const SymlinkInfo& si) //throw Th
             return LINK_SKIP;
 
         case SymLinkHandling::DIRECT:
+            if (snapshotOut_)
+                snapshotOut_->symlinks[si.itemName] = LinkDescriptor(si.lastWriteTime);
+
             if (cfg.filter_->passFileFilter(linkRelPath)) //always use file filter: Link type may not be "stable" on Linux!
             {
                 output_.addSubLink(si.itemName, LinkDescriptor(si.lastWriteTime));
@@ -444,10 +533,12 @@ DirCallback::HandleError DirCallback::reportDirError(const std::wstring& msg, si
     switch (cfg.acb_.reportError(msg, retryNumber)) //throw ThreadInterruption
     {
         case FillBufferCallback::ON_ERROR_IGNORE:
-            cfg.failedDirReads_[beforeLast(parentRelPathPf_, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE)] = msg;
+            cfg.addFailedFolderRead(beforeLast(parentRelPathPf_, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE), msg);
+            ignoredErrors = true;
             return ON_ERROR_IGNORE;
 
         case FillBufferCallback::ON_ERROR_RETRY:
+            output_ = FolderContainer(); //the folder is traversed again from the start: see tryReportingDirError(); no sub folders were scheduled yet
             return ON_ERROR_RETRY;
     }
     assert(false);
@@ -460,7 +551,8 @@ DirCallback::HandleError DirCallback::reportItemError(const std::wstring& msg, s
     switch (cfg.acb_.reportError(msg, retryNumber)) //throw ThreadInterruption
     {
         case FillBufferCallback::ON_ERROR_IGNORE:
-            cfg.failedItemReads_[parentRelPathPf_ + itemName] =  msg;
+            cfg.addFailedItemRead(parentRelPathPf_ + itemName, msg);
+            ignoredErrors = true;
             return ON_ERROR_IGNORE;
 
         case FillBufferCallback::ON_ERROR_RETRY:
@@ -476,53 +568,123 @@ class WorkerThread
 {
 public:
     WorkerThread(int threadID,
-                 const std::shared_ptr<AsyncCallback>& acb,
-                 const AbstractPath& baseFolderPath,   //always bound!
-                 const HardFilter::FilterRef& filter, //
-                 SymLinkHandling handleSymlinks,
-                 DirectoryValue& dirOutput) :
-        acb_(acb),
-        outputContainer(dirOutput.folderCont),
-        travCfg(threadID,
-                baseFolderPath,
-                filter,
-                handleSymlinks, //shared by all(!) instances of DirCallback while traversing a folder hierarchy
-                dirOutput.failedFolderReads,
-                dirOutput.failedItemReads,
-                *acb_) {}
+                 size_t queueIdx,
+                 const std::shared_ptr<TaskScheduler>& scheduler,
+                 const std::shared_ptr<AsyncCallback>& acb) :
+        threadID_(threadID),
+        queueIdx_(queueIdx),
+        scheduler_(scheduler),
+        acb_(acb) {}
 
     void operator()() //thread entry
     {
 #ifdef ZEN_WIN
         setCurrentThreadName("Folder Traverser");
 #endif
+        WorkerContext ctx = { *scheduler_, queueIdx_, threadID_, TickVal() };
 
-        acb_->incActiveWorker();
-        ZEN_ON_SCOPE_EXIT(acb_->decActiveWorker());
+        TraverserTask task;
+        while (scheduler_->getNextTask(queueIdx_, task)) //throw ThreadInterruption
+        {
+            acb_->incActiveWorker();
+            ZEN_ON_SCOPE_EXIT(acb_->decActiveWorker());
+
+            const AbstractPath folderPath = AFS::appendRelPath(task.cfg->baseFolderPath_, task.folderRelPath);
+
+            if (acb_->mayReportCurrentFile(threadID_, ctx.lastReportTime))
+                acb_->reportCurrentFile(AFS::getDisplayPath(folderPath)); //just in case first directory access is blocking
+
+            FolderSnapshot* unchangedSnapshot = task.cfg->useSnapshot_ ? task.cfg->getUnchangedSnapshot(task.folderRelPath) : nullptr;
+
+            Opt<FolderSignature> folderSig;
+            if (task.cfg->useSnapshot_ && !unchangedSnapshot)
+                folderSig = getFolderSignature(folderPath); //take signature *before* reading the folder!
 
-        if (acb_->mayReportCurrentFile(travCfg.threadID_, travCfg.lastReportTime))
-            acb_->reportCurrentFile(AFS::getDisplayPath(travCfg.baseFolderPath_)); //just in case first directory access is blocking
+            FolderSnapshot snapshot;
+            DirCallback cb(*task.cfg, ctx, task.folderRelPath.empty() ? Zstring() : task.folderRelPath + FILE_NAME_SEPARATOR, *task.output,
+                           folderSig ? &snapshot : nullptr, task.level);
 
-        DirCallback cb(travCfg, Zstring(), outputContainer, 0);
+            if (unchangedSnapshot)
+                replaySnapshot(*unchangedSnapshot, cb); //throw ThreadInterruption
+            else if (const FolderSnapshot* lastSnapshot = folderSig ? task.cfg->getLastSnapshot(task.folderRelPath, *folderSig) : nullptr)
+                replaySnapshot(*lastSnapshot, cb); //throw ThreadInterruption; sub folders are still checked separately
+            else
+                AFS::traverseFolder(folderPath, cb); //throw X
 
-        AFS::traverseFolder(travCfg.baseFolderPath_, cb); //throw X
+            cb.onFolderComplete();
+
+            if (unchangedSnapshot)
+                task.cfg->addSnapshot(task.folderRelPath, std::move(*unchangedSnapshot)); //signature is still valid
+            else if (folderSig && !cb.haveIgnoredErrors())
+            {
+                snapshot.signature = *folderSig;
+                task.cfg->addSnapshot(task.folderRelPath, std::move(snapshot));
+            }
+
+            scheduler_->notifyTaskDone();
+        }
     }
 
 private:
+    static void replaySnapshot(const FolderSnapshot& snapshot, DirCallback& cb) //throw ThreadInterruption
+    {
+        for (const auto& item : snapshot.files)
+            cb.onFile({ item.first, item.second.fileSize, item.second.lastWriteTimeRaw, item.second.fileId, nullptr /*symlinkInfo*/ });
+
+        for (const auto& item : snapshot.symlinks)
+            cb.onSymlink({ item.first, item.second.lastWriteTimeRaw });
+
+        for (const Zstring& folderName : snapshot.folders)
+            cb.onDir({ folderName });
+    }
+
+    const int threadID_;
+    const size_t queueIdx_;
+    std::shared_ptr<TaskScheduler> scheduler_;
     std::shared_ptr<AsyncCallback> acb_;
-    FolderContainer& outputContainer;
-    TraverserConfig travCfg;
 };
+
+
+//group base folders by device: each device gets a worker thread pool of its own
+std::vector<std::vector<const DirectoryKey*>> separateByDevice(const std::set<DirectoryKey>& keysToRead)
+{
+    std::map<VolumeId, std::vector<const DirectoryKey*>> keysByVolume;
+    std::vector<std::vector<const DirectoryKey*>> buckets;
+
+    for (const DirectoryKey& key : keysToRead)
+    {
+        Opt<VolumeId> volId;
+        if (Opt<Zstring> nativePath = AFS::getNativeItemPath(key.folderPath_))
+            try
+            {
+                volId = getVolumeId(*nativePath); //throw FileError; base folder existence was checked already => not expected to block
+            }
+            catch (FileError&) {}
+
+        if (volId)
+            keysByVolume[*volId].push_back(&key);
+        else
+            buckets.push_back({ &key }); //unknown device, e.g. SFTP: assume independent
+    }
+
+    for (auto& item : keysByVolume)
+        buckets.push_back(std::move(item.second));
+    return buckets;
+}
 }
 
 
 void zen::fillBuffer(const std::set<DirectoryKey>& keysToRead, //in
                      std::map<DirectoryKey, DirectoryValue>& buf, //out
+                     size_t threadsPerDevice,
+                     bool useScanSnapshot,
+                     const ChangeList* changeList,
                      FillBufferCallback& callback,
                      size_t updateIntervalMs)
 {
     buf.clear();
 
+    FixedList<TraverserConfig> travConfigs; //referenced by worker threads => must outlive them!
     FixedList<InterruptibleThread> worker;
 
     ZEN_ON_SCOPE_FAIL
@@ -537,18 +699,59 @@ void zen::fillBuffer(const std::set<DirectoryKey>& keysToRead, //in
     auto acb = std::make_shared<AsyncCallback>(updateIntervalMs / 2 /*reportingIntervalMs*/);
 
     //init worker threads
-    for (const DirectoryKey& key : keysToRead)
+    for (const std::vector<const DirectoryKey*>& deviceKeys : separateByDevice(keysToRead))
     {
-        assert(buf.find(key) == buf.end());
-        DirectoryValue& dirOutput = buf[key];
-
-        const int threadId = static_cast<int>(worker.size());
-        worker.emplace_back(WorkerThread(threadId,
-                                         acb,
-                                         key.folderPath_, //AbstractPath is thread-safe like an int! :)
-                                         key.filter_,
-                                         key.handleSymlinks_,
-                                         dirOutput));
+        auto scheduler = std::make_shared<TaskScheduler>(threadsPerDevice);
+
+        for (const DirectoryKey* key : deviceKeys)
+        {
+            assert(buf.find(*key) == buf.end());
+            DirectoryValue& dirOutput = buf[*key];
+
+            const bool useSnapshot = useScanSnapshot && scanSnapshotSupported(key->folderPath_, key->handleSymlinks_);
+            ScanSnapshot lastSnapshot;
+            if (useSnapshot)
+                try
+                {
+                    lastSnapshot = loadScanSnapshot(key->folderPath_, key->handleSymlinks_); //throw FileError
+                }
+                catch (FileError&) {} //snapshot is just a cache: traverse everything
+
+            std::set<Zstring, LessFilePath> changedFolders;
+            bool skipUnchangedFolders = false;
+            if (useSnapshot && changeList)
+                if (Opt<Zstring> nativePath = AFS::getNativeItemPath(key->folderPath_))
+                {
+                    FolderChanges folderChanges = getFolderChanges(*changeList, *nativePath);
+                    changedFolders.swap(folderChanges.changedFolders);
+
+                    //last snapshot must have been taken during the run triggered by the directly preceding change list
+                    skipUnchangedFolders = folderChanges.complete && !changeList->pos.sessionId.empty() &&
+                                           lastSnapshot.changeListPos.sessionId == changeList->pos.sessionId &&
+                                           lastSnapshot.changeListPos.sequenceNo + 1 == changeList->pos.sequenceNo;
+                }
+
+            travConfigs.emplace_back(key->folderPath_, //AbstractPath is thread-safe like an int! :)
+                                     key->filter_,
+                                     key->handleSymlinks_, //shared by all(!) instances of DirCallback while traversing a folder hierarchy
+                                     dirOutput.failedFolderReads,
+                                     dirOutput.failedItemReads,
+                                     useSnapshot,
+                                     std::move(lastSnapshot),
+                                     changeList ? changeList->pos : ChangeListPos(),
+                                     std::move(changedFolders),
+                                     skipUnchangedFolders,
+                                     *acb);
+
+            //distribute base folders evenly: start traversing all of them right away
+            scheduler->addTask(buf.size() % scheduler->getThreadCount(), { &travConfigs.back(), Zstring(), &dirOutput.folderCont, 0 });
+        }
+
+        for (size_t queueIdx = 0; queueIdx < scheduler->getThreadCount(); ++queueIdx)
+        {
+            const int threadId = static_cast<int>(worker.size());
+            worker.emplace_back(WorkerThread(threadId, queueIdx, scheduler, acb));
+        }
     }
 
     //wait until done
@@ -566,4 +769,13 @@ void zen::fillBuffer(const std::set<DirectoryKey>& keysToRead, //in
 
         acb->incrementNotifyingThreadId(); //process info messages of one thread at a time only
     }
+
+    //all worker threads have finished: save folder snapshots for the next scan
+    for (const TraverserConfig& cfg : travConfigs)
+        if (cfg.useSnapshot_)
+            try
+            {
+                saveScanSnapshot(cfg.baseFolderPath_, cfg.handleSymlinks_, cfg.getNewSnapshot()); //throw FileError
+            }
+            catch (FileError&) {} //not critical: next scan will read all folders again
 }
@@ -10,6 +10,7 @@
 #include <map>
 #include <set>
 #include "hard_filter.h"
+#include "change_list.h"
 #include "../structures.h"
 #include "../file_hierarchy.h"
 
@@ -74,6 +75,9 @@ struct FillBufferCallback
 
 void fillBuffer(const std::set<DirectoryKey>& keysToRead, //in
                 std::map<DirectoryKey, DirectoryValue>& buf, //out
+                size_t threadsPerDevice, //worker threads sharing the traversal of all base folders located on the same device
+                bool useScanSnapshot, //skip reading folders that are unchanged since the last scan; see scan_snapshot.h for limitations!
+                const ChangeList* changeList, //optional: changes reported by RealTimeSync, see change_list.h
                 FillBufferCallback& callback,
                 size_t updateIntervalMs); //unit: [ms]
 }
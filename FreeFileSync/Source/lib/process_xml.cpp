@@ -1043,10 +1043,21 @@ void readConfig(const XmlIn& in, XmlGlobalSettings& config, int formatVer)
     inGeneral["AutomaticRetry"           ].attribute("Delay"  , config.automaticRetryDelay);
     inGeneral["FileTimeTolerance"        ].attribute("Seconds", config.fileTimeTolerance);
     inGeneral["FolderAccessTimeout"      ].attribute("Seconds", config.folderAccessTimeout);
+    inGeneral["ParallelFolderScan"       ].attribute("ThreadsPerDevice", config.scanThreadsPerDevice);
+    inGeneral["ScanSnapshot"             ].attribute("Enabled", config.scanSnapshot);
+    inGeneral["ParallelFileComparison"   ].attribute("ThreadsPerDevice", config.compareThreadsPerDevice);
+    inGeneral["ReuseContentComparison"   ].attribute("Enabled", config.reuseContentComparison);
+    inGeneral["CloneFiles"               ].attribute("Enabled", config.cloneFiles);
+    inGeneral["DeltaCopy"                ].attribute("Enabled", config.deltaCopy);
+    inGeneral["ParallelSync"             ].attribute("ThreadsPerFolderPair", config.syncThreadsPerFolderPair);
+    inGeneral["ParallelSync"             ].attribute("ThreadsTotal", config.syncThreadsTotal);
+    inGeneral["VersioningLimit"          ].attribute("Count"  , config.versionCountLimit);
+    inGeneral["VersioningLimit"          ].attribute("MaxAgeDays", config.versionMaxAgeDays);
     inGeneral["RunWithBackgroundPriority"].attribute("Enabled", config.runWithBackgroundPriority);
     inGeneral["LockDirectoriesDuringSync"].attribute("Enabled", config.createLockFile);
     inGeneral["VerifyCopiedFiles"        ].attribute("Enabled", config.verifyFileCopy);
     inGeneral["LastSyncsLogSizeMax"      ].attribute("Bytes"  , config.lastSyncsLogFileSizeMax);
+    inGeneral["LogMemoryLimit"           ].attribute("Bytes"  , config.logMemoryLimit);
     inGeneral["NotificationSound"        ].attribute("CompareFinished", config.soundFileCompareFinished);
     inGeneral["NotificationSound"        ].attribute("SyncFinished"   , config.soundFileSyncFinished);
 
@@ -1489,10 +1500,21 @@ void writeConfig(const XmlGlobalSettings& config, XmlOut& out)
     outGeneral["AutomaticRetry"           ].attribute("Delay"  , config.automaticRetryDelay);
     outGeneral["FileTimeTolerance"        ].attribute("Seconds", config.fileTimeTolerance);
     outGeneral["FolderAccessTimeout"      ].attribute("Seconds", config.folderAccessTimeout);
+    outGeneral["ParallelFolderScan"       ].attribute("ThreadsPerDevice", config.scanThreadsPerDevice);
+    outGeneral["ScanSnapshot"             ].attribute("Enabled", config.scanSnapshot);
+    outGeneral["ParallelFileComparison"   ].attribute("ThreadsPerDevice", config.compareThreadsPerDevice);
+    outGeneral["ReuseContentComparison"   ].attribute("Enabled", config.reuseContentComparison);
+    outGeneral["CloneFiles"               ].attribute("Enabled", config.cloneFiles);
+    outGeneral["DeltaCopy"                ].attribute("Enabled", config.deltaCopy);
+    outGeneral["ParallelSync"             ].attribute("ThreadsPerFolderPair", config.syncThreadsPerFolderPair);
+    outGeneral["ParallelSync"             ].attribute("ThreadsTotal", config.syncThreadsTotal);
+    outGeneral["VersioningLimit"          ].attribute("Count"  , config.versionCountLimit);
+    outGeneral["VersioningLimit"          ].attribute("MaxAgeDays", config.versionMaxAgeDays);
     outGeneral["RunWithBackgroundPriority"].attribute("Enabled", config.runWithBackgroundPriority);
     outGeneral["LockDirectoriesDuringSync"].attribute("Enabled", config.createLockFile);
     outGeneral["VerifyCopiedFiles"        ].attribute("Enabled", config.verifyFileCopy);
     outGeneral["LastSyncsLogSizeMax"      ].attribute("Bytes"  , config.lastSyncsLogFileSizeMax);
+    outGeneral["LogMemoryLimit"           ].attribute("Bytes"  , config.logMemoryLimit);
     outGeneral["NotificationSound"        ].attribute("CompareFinished", config.soundFileCompareFinished);
     outGeneral["NotificationSound"        ].attribute("SyncFinished"   , config.soundFileSyncFinished);
 
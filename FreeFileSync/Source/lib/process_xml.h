@@ -148,10 +148,21 @@ struct XmlGlobalSettings
 
     int fileTimeTolerance = 2; //max. allowed file time deviation; < 0 means unlimited tolerance; default 2s: FAT vs NTFS
     int folderAccessTimeout = 20;  //unit: [s]; consider CD-ROM insert or hard disk spin up time from sleep
+    size_t scanThreadsPerDevice = 4; //worker threads traversing the folders of a single device in parallel
+    bool scanSnapshot = false; //skip reading unchanged folders: misses files modified in place!
+    size_t compareThreadsPerDevice = 2; //binary comparisons accessing the same device in parallel
+    bool reuseContentComparison = false; //skip reading files found equal by content during last sync and unchanged since
+    bool cloneFiles = false; //Linux: create reflinks (btrfs, XFS) instead of copying file content
+    bool deltaCopy = false; //Linux: update large files by writing changed blocks only
+    size_t syncThreadsPerFolderPair = 1; //new files of a single folder pair being copied in parallel
+    size_t syncThreadsTotal = 1; //folder pairs without common folders being synchronized in parallel within this limit
+    int versionCountLimit = -1; //versions kept per file (VersioningStyle::ADD_TIMESTAMP); < 0 means no limit
+    int versionMaxAgeDays = -1; //remove older versions; < 0 means no limit
     bool runWithBackgroundPriority = false;
     bool createLockFile = true;
     bool verifyFileCopy = false;
     size_t lastSyncsLogFileSizeMax = 100000; //maximum size for LastSyncs.log: use a human-readable number
+    size_t logMemoryLimit = 100000000; //keep newest log messages in memory, move older ones to a temporary file; unit: [byte]
     Zstring soundFileCompareFinished;
     Zstring soundFileSyncFinished= Zstr("gong.wav");
 
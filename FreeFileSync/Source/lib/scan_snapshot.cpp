@@ -0,0 +1,224 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#include "scan_snapshot.h"
+#include <zen/crc.h>
+#include <zen/file_access.h>
+#include <zen/file_io.h>
+#include <zen/serialize.h>
+#include <wx+/zlib_wrap.h>
+#include "ffs_paths.h"
+
+#if defined ZEN_LINUX || defined ZEN_MAC
+    #include <sys/stat.h>
+#endif
+
+using namespace zen;
+
+
+namespace
+{
+//-------------------------------------------------------------------------------------------------------------------------------
+const char FILE_FORMAT_DESCR[] = "FreeFileSync";
+const int SNAPSHOT_FORMAT_VER = 2; //2: added change list position
+//-------------------------------------------------------------------------------------------------------------------------------
+
+using MemStreamOut = MemoryStreamOut<ByteArray>;
+using MemStreamIn  = MemoryStreamIn <ByteArray>;
+
+//-----------------------------------------------------------------------------------
+//| ensure 32/64 bit portability: use fixed size data types only e.g. std::uint32_t |
+//-----------------------------------------------------------------------------------
+
+Zstring getSnapshotFilePath(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks)
+{
+    //one file per base folder: don't load the snapshots of unrelated folder pairs
+    const std::string pathPhrase = utfCvrtTo<std::string>(AFS::getInitPathPhrase(baseFolderPath));
+
+    return getConfigDir() + Zstr("ScanSnapshot") + FILE_NAME_SEPARATOR +
+           numberTo<Zstring>(getCrc32(pathPhrase.begin(), pathPhrase.end())) + Zstr("-") + numberTo<Zstring>(static_cast<int>(handleSymlinks)) + Zstr(".ffs_scan");
+}
+
+
+void writeUtf8(MemStreamOut& output, const Zstring& str) { writeContainer(output, utfCvrtTo<Zbase<char>>(str)); }
+Zstring readUtf8(MemStreamIn& input) { return utfCvrtTo<Zstring>(readContainer<Zbase<char>>(input)); } //throw UnexpectedEndOfStreamError
+
+
+void writeSignature(MemStreamOut& output, const FolderSignature& sig)
+{
+    writeNumber<std::int64_t >(output, sig.modTime);
+    writeNumber<std::int64_t >(output, sig.changeTime);
+    writeNumber<std::uint64_t>(output, sig.volumeId);
+    writeNumber<std::uint64_t>(output, sig.fileIndex);
+}
+
+
+FolderSignature readSignature(MemStreamIn& input) //throw UnexpectedEndOfStreamError
+{
+    FolderSignature sig;
+    sig.modTime    = readNumber<std::int64_t >(input);
+    sig.changeTime = readNumber<std::int64_t >(input);
+    sig.volumeId   = readNumber<std::uint64_t>(input);
+    sig.fileIndex  = readNumber<std::uint64_t>(input);
+    return sig;
+}
+}
+
+
+Opt<FolderSignature> zen::getFolderSignature(const AbstractPath& folderPath) //noexcept
+{
+#ifdef ZEN_WIN
+    //folder modification time is not updated reliably (e.g. FAT, network shares)
+    (void)folderPath;
+    return NoValue();
+
+#elif defined ZEN_LINUX || defined ZEN_MAC
+    if (Opt<Zstring> nativePath = AFS::getNativeItemPath(folderPath))
+    {
+        struct ::stat folderInfo = {};
+        if (::stat(nativePath->c_str(), &folderInfo) == 0 && S_ISDIR(folderInfo.st_mode))
+        {
+            FolderSignature sig;
+#ifdef ZEN_LINUX
+            sig.modTime    = static_cast<std::int64_t>(folderInfo.st_mtim.tv_sec) * 1000000000 + folderInfo.st_mtim.tv_nsec;
+            sig.changeTime = static_cast<std::int64_t>(folderInfo.st_ctim.tv_sec) * 1000000000 + folderInfo.st_ctim.tv_nsec;
+#elif defined ZEN_MAC
+            sig.modTime    = static_cast<std::int64_t>(folderInfo.st_mtimespec.tv_sec) * 1000000000 + folderInfo.st_mtimespec.tv_nsec;
+            sig.changeTime = static_cast<std::int64_t>(folderInfo.st_ctimespec.tv_sec) * 1000000000 + folderInfo.st_ctimespec.tv_nsec;
+#endif
+            sig.volumeId  = folderInfo.st_dev;
+            sig.fileIndex = folderInfo.st_ino;
+            return sig;
+        }
+    }
+    return NoValue(); //e.g. SFTP, MTP
+#endif
+}
+
+
+bool zen::scanSnapshotSupported(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks)
+{
+    //followed symlinks: target may change without the parent folder noticing
+    return handleSymlinks != SymLinkHandling::FOLLOW && getFolderSignature(baseFolderPath);
+}
+
+
+void zen::saveScanSnapshot(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks, const ScanSnapshot& snapshot) //throw FileError
+{
+    MemStreamOut streamBody;
+    writeContainer           (streamBody, snapshot.changeListPos.sessionId);
+    writeNumber<std::uint64_t>(streamBody, snapshot.changeListPos.sequenceNo);
+
+    writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(snapshot.folders.size()));
+    for (const auto& item : snapshot.folders)
+    {
+        const FolderSnapshot& folder = item.second;
+        writeUtf8(streamBody, item.first);
+        writeSignature(streamBody, folder.signature);
+
+        writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(folder.files.size()));
+        for (const auto& file : folder.files)
+        {
+            writeUtf8(streamBody, file.first);
+            writeNumber<std::int64_t >(streamBody, file.second.lastWriteTimeRaw);
+            writeNumber<std::uint64_t>(streamBody, file.second.fileSize);
+            writeContainer(streamBody, file.second.fileId);
+            assert(!file.second.isFollowedSymlink);
+        }
+
+        writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(folder.symlinks.size()));
+        for (const auto& link : folder.symlinks)
+        {
+            writeUtf8(streamBody, link.first);
+            writeNumber<std::int64_t>(streamBody, link.second.lastWriteTimeRaw);
+        }
+
+        writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(folder.folders.size()));
+        for (const Zstring& folderName : folder.folders)
+            writeUtf8(streamBody, folderName);
+    }
+
+    const Zstring filePath = getSnapshotFilePath(baseFolderPath, handleSymlinks);
+
+    MemStreamOut streamOut;
+    writeArray(streamOut, FILE_FORMAT_DESCR, sizeof(FILE_FORMAT_DESCR));
+    writeNumber<std::int32_t>(streamOut, SNAPSHOT_FORMAT_VER);
+    writeUtf8(streamOut, AFS::getInitPathPhrase(baseFolderPath)); //detect CRC collisions
+    try
+    {
+        writeContainer(streamOut, compress(streamBody.ref(), 3)); //throw ZlibInternalError
+    }
+    catch (ZlibInternalError&)
+    {
+        throw FileError(replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(filePath)), L"zlib internal error");
+    }
+
+    makeDirectoryRecursively(beforeLast(filePath, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE)); //throw FileError
+    saveBinContainer(filePath, streamOut.ref(), nullptr); //throw FileError
+}
+
+
+ScanSnapshot zen::loadScanSnapshot(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks) //throw FileError
+{
+    const Zstring filePath = getSnapshotFilePath(baseFolderPath, handleSymlinks);
+
+    if (!fileExists(filePath)) //no error: first scan
+        return ScanSnapshot();
+
+    const ByteArray buffer = loadBinContainer<ByteArray>(filePath, nullptr); //throw FileError
+    try
+    {
+        MemStreamIn streamIn(buffer);
+
+        char formatDescr[sizeof(FILE_FORMAT_DESCR)] = {};
+        readArray(streamIn, formatDescr, sizeof(formatDescr)); //throw UnexpectedEndOfStreamError
+
+        if (!std::equal(FILE_FORMAT_DESCR, FILE_FORMAT_DESCR + sizeof(FILE_FORMAT_DESCR), formatDescr) ||
+            readNumber<std::int32_t>(streamIn) != SNAPSHOT_FORMAT_VER)
+            return ScanSnapshot(); //outdated or corrupt: rebuild from scratch
+
+        if (readUtf8(streamIn) != AFS::getInitPathPhrase(baseFolderPath))
+            return ScanSnapshot(); //file name collision
+
+        MemStreamIn streamBody(decompress(readContainer<ByteArray>(streamIn))); //throw ZlibInternalError
+
+        ScanSnapshot output;
+        output.changeListPos.sessionId  = readContainer<std::string>(streamBody);
+        output.changeListPos.sequenceNo = readNumber<std::uint64_t>(streamBody);
+
+        size_t folderCount = readNumber<std::uint32_t>(streamBody);
+        while (folderCount-- != 0)
+        {
+            const Zstring folderRelPath = readUtf8(streamBody);
+            FolderSnapshot& folder = output.folders[folderRelPath];
+            folder.signature = readSignature(streamBody);
+
+            size_t fileCount = readNumber<std::uint32_t>(streamBody);
+            while (fileCount-- != 0)
+            {
+                const Zstring fileName = readUtf8(streamBody);
+                const std::int64_t lastWriteTimeRaw = readNumber<std::int64_t >(streamBody);
+                const std::uint64_t fileSize        = readNumber<std::uint64_t>(streamBody);
+                const AFS::FileId fileId = readContainer<AFS::FileId>(streamBody);
+                folder.files[fileName] = FileDescriptor(lastWriteTimeRaw, fileSize, fileId, false /*isSymlink*/);
+            }
+
+            size_t linkCount = readNumber<std::uint32_t>(streamBody);
+            while (linkCount-- != 0)
+            {
+                const Zstring linkName = readUtf8(streamBody);
+                folder.symlinks[linkName] = LinkDescriptor(readNumber<std::int64_t>(streamBody));
+            }
+
+            size_t subFolderCount = readNumber<std::uint32_t>(streamBody);
+            while (subFolderCount-- != 0)
+                folder.folders.insert(readUtf8(streamBody));
+        }
+        return output;
+    }
+    catch (ZlibInternalError&) { return ScanSnapshot(); } //corrupt cache file: not an error, just rebuild
+    catch (UnexpectedEndOfStreamError&) { return ScanSnapshot(); } //
+}
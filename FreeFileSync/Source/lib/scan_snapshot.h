@@ -0,0 +1,71 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#ifndef SCAN_SNAPSHOT_H_3847598347534257893
+#define SCAN_SNAPSHOT_H_3847598347534257893
+
+#include <map>
+#include <set>
+#include <zen/file_error.h>
+#include <zen/optional.h>
+#include "../structures.h"
+#include "../file_hierarchy.h"
+#include "change_list.h"
+
+
+namespace zen
+{
+/*
+persistent result of the last folder traversal: re-use the item list of folders that have not changed since
+
+CAVEAT: a folder's modification time only changes when items are created, deleted or renamed, but NOT when the content of an
+existing file is overwritten in place! => a folder snapshot is only reliable for folders whose files are replaced, never modified in place
+*/
+
+struct FolderSignature
+{
+    std::int64_t modTime    = 0; //unit: [ns]
+    std::int64_t changeTime = 0; //
+    std::uint64_t volumeId  = 0;
+    std::uint64_t fileIndex = 0;
+};
+
+inline
+bool operator==(const FolderSignature& lhs, const FolderSignature& rhs)
+{
+    return lhs.modTime    == rhs.modTime    &&
+           lhs.changeTime == rhs.changeTime &&
+           lhs.volumeId   == rhs.volumeId   &&
+           lhs.fileIndex  == rhs.fileIndex;
+}
+
+//get signature *before* reading the folder: a change during traversal must not be masked
+Opt<FolderSignature> getFolderSignature(const AbstractPath& folderPath); //noexcept; returns NoValue() if not supported
+
+
+struct FolderSnapshot //unfiltered(!) content of a single folder as reported by the folder traverser
+{
+    FolderSignature signature;
+    std::map<Zstring, FileDescriptor, LessFilePath> files;
+    std::map<Zstring, LinkDescriptor, LessFilePath> symlinks; //SymLinkHandling::DIRECT only
+    std::set<Zstring, LessFilePath> folders;
+};
+
+struct ScanSnapshot
+{
+    ChangeListPos changeListPos; //RealTimeSync change list the scan was started with: see change_list.h
+    std::map<Zstring, FolderSnapshot, LessFilePath> folders; //folder relative path (empty for base folder) => snapshot
+};
+
+
+//snapshots are independent from the filter: stored per base folder and symlink handling
+bool scanSnapshotSupported(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks);
+
+ScanSnapshot loadScanSnapshot(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks); //throw FileError
+void         saveScanSnapshot(const AbstractPath& baseFolderPath, SymLinkHandling handleSymlinks, const ScanSnapshot& snapshot); //throw FileError
+}
+
+#endif //SCAN_SNAPSHOT_H_3847598347534257893
@@ -0,0 +1,188 @@
+// *****************************************************************************
+// * This file is part of the FreeFileSync project. It is distributed under    *
+// * GNU General Public License: http://www.gnu.org/licenses/gpl-3.0           *
+// * Copyright (C) Zenju (zenju AT freefilesync DOT org) - All Rights Reserved *
+// *****************************************************************************
+
+#ifndef STATUS_HANDLER_ASYNC_H_2874589234758923475
+#define STATUS_HANDLER_ASYNC_H_2874589234758923475
+
+#include <vector>
+#include <zen/thread.h>
+#include <zen/string_base.h>
+#include "../process_callback.h"
+
+
+namespace zen
+{
+//forward ProcessCallback requests of worker threads to the main thread: actor pattern
+class AsyncProcessCallback
+{
+public:
+    //blocking call: context of worker thread
+    ProcessCallback::Response reportError(const std::wstring& msg, size_t retryNumber) //throw ThreadInterruption
+    {
+        std::unique_lock<std::mutex> dummy(lockErrorInfo);
+        interruptibleWait(conditionCanReportError, dummy, [this] { return !errorInfo && !errorResponse; }); //throw ThreadInterruption
+
+        errorInfo = std::make_unique<std::pair<BasicWString, size_t>>(copyStringTo<BasicWString>(msg), retryNumber);
+
+        interruptibleWait(conditionGotResponse, dummy, [this] { return static_cast<bool>(errorResponse); }); //throw ThreadInterruption
+
+        ProcessCallback::Response rv = *errorResponse;
+
+        errorInfo    .reset();
+        errorResponse.reset();
+
+        dummy.unlock(); //optimization for condition_variable::notify_all()
+        conditionCanReportError.notify_all(); //instead of notify_one(); workaround bug: https://svn.boost.org/trac/boost/ticket/7796
+
+        return rv;
+    }
+
+    void reportInfo(const std::wstring& msg) //context of worker thread
+    {
+        std::lock_guard<std::mutex> dummy(lockLogMsgs);
+        logMsgs.emplace_back(copyStringTo<BasicWString>(msg), false);
+    }
+
+    void reportFatalError(const std::wstring& msg) //context of worker thread
+    {
+        std::lock_guard<std::mutex> dummy(lockLogMsgs);
+        logMsgs.emplace_back(copyStringTo<BasicWString>(msg), true);
+    }
+
+    void updateProcessedData(int itemsDelta, std::int64_t bytesDelta) //context of worker thread
+    {
+        std::lock_guard<std::mutex> dummy(lockStatistics);
+        itemsProcessedDelta += itemsDelta;
+        bytesProcessedDelta += bytesDelta;
+    }
+
+    void updateTotalData(int itemsDelta, std::int64_t bytesDelta) //context of worker thread
+    {
+        std::lock_guard<std::mutex> dummy(lockStatistics);
+        itemsTotalDelta += itemsDelta;
+        bytesTotalDelta += bytesDelta;
+    }
+
+    void reportCurrentStatus(const std::wstring& statusText) //context of worker thread
+    {
+        std::lock_guard<std::mutex> dummy(lockCurrentStatus);
+        currentStatus = copyStringTo<BasicWString>(statusText);
+    }
+
+    void incActiveWorker() { ++activeWorker; } //context of worker thread
+    void decActiveWorker() { --activeWorker; } //
+
+    //context of main thread, call repreatedly: forward statistics, log messages and errors
+    void processRequests(ProcessCallback& callback) //throw X
+    {
+        forwardStatistics(callback); //noexcept
+
+        std::vector<LogMessage> msgs;
+        {
+            std::lock_guard<std::mutex> dummy(lockLogMsgs);
+            msgs.swap(logMsgs);
+        }
+        for (const LogMessage& msg : msgs)
+            if (msg.second)
+                callback.reportFatalError(copyStringTo<std::wstring>(msg.first)); //throw X
+            else
+                callback.reportInfo(copyStringTo<std::wstring>(msg.first)); //throw X
+
+        std::unique_lock<std::mutex> dummy(lockErrorInfo);
+        if (errorInfo.get() && !errorResponse.get())
+        {
+            ProcessCallback::Response rv = callback.reportError(copyStringTo<std::wstring>(errorInfo->first), errorInfo->second); //throw X
+            errorResponse = std::make_unique<ProcessCallback::Response>(rv);
+
+            dummy.unlock(); //optimization for condition_variable::notify_all()
+            conditionGotResponse.notify_all(); //instead of notify_one(); workaround bug: https://svn.boost.org/trac/boost/ticket/7796
+        }
+    }
+
+    //context of main thread, call repreatedly: forward statistics only, e.g. while log messages and errors of another worker take precedence
+    void forwardStatistics(ProcessCallback& callback) //noexcept
+    {
+        std::lock_guard<std::mutex> dummy(lockStatistics);
+        callback.updateProcessedData(itemsProcessedDelta, bytesProcessedDelta); //noexcept
+        callback.updateTotalData    (itemsTotalDelta,     bytesTotalDelta);     //
+        itemsProcessedDelta = itemsTotalDelta = 0;
+        bytesProcessedDelta = bytesTotalDelta = 0;
+    }
+
+    std::wstring getCurrentStatus() //context of main thread, call repreatedly
+    {
+        std::wstring statusText;
+        {
+            std::lock_guard<std::mutex> dummy(lockCurrentStatus);
+            statusText = copyStringTo<std::wstring>(currentStatus);
+        }
+
+        const long activeCount = activeWorker;
+        if (activeCount >= 2 && !statusText.empty())
+            statusText += L" [" + replaceCpy(_P("1 thread", "%x threads", activeCount), L"%x", numberTo<std::wstring>(activeCount)) + L"]";
+        return statusText;
+    }
+
+private:
+    using BasicWString = Zbase<wchar_t, StorageRefCountThreadSafe>; //thread-safe string class for UI texts
+    using LogMessage = std::pair<BasicWString, bool>; //message + is fatal error
+
+    //---- error handling ----
+    std::mutex lockErrorInfo;
+    std::condition_variable conditionCanReportError;
+    std::condition_variable conditionGotResponse;
+    std::unique_ptr<std::pair<BasicWString, size_t>> errorInfo; //error message + retry number
+    std::unique_ptr<ProcessCallback::Response> errorResponse;
+
+    //---- log messages ----
+    std::mutex lockLogMsgs;
+    std::vector<LogMessage> logMsgs;
+
+    //---- statistics ----
+    std::mutex lockStatistics;
+    int          itemsProcessedDelta = 0;
+    std::int64_t bytesProcessedDelta = 0;
+    int          itemsTotalDelta     = 0;
+    std::int64_t bytesTotalDelta     = 0;
+
+    //---- status updates ----
+    std::mutex lockCurrentStatus;
+    BasicWString currentStatus;
+
+    std::atomic<int> activeWorker{ 0 }; //std:atomic is uninitialized by default!
+};
+
+
+//ProcessCallback for worker threads: allows to reuse tryReportingError() and StatisticsReporter unchanged
+class WorkerProcessCallback : public ProcessCallback
+{
+public:
+    WorkerProcessCallback(AsyncProcessCallback& acb) : acb_(acb) {}
+
+    void initNewPhase(int objectsTotal, std::int64_t dataTotal, Phase phaseId) override { assert(false); }
+
+    void updateProcessedData(int objectsDelta, std::int64_t dataDelta) override { acb_.updateProcessedData(objectsDelta, dataDelta); }
+    void updateTotalData    (int objectsDelta, std::int64_t dataDelta) override { acb_.updateTotalData    (objectsDelta, dataDelta); }
+
+    void requestUiRefresh() override { interruptionPoint(); } //throw ThreadInterruption
+    void forceUiRefresh  () override { interruptionPoint(); } //
+
+    void reportStatus(const std::wstring& text) override { acb_.reportCurrentStatus(text); interruptionPoint(); } //throw ThreadInterruption
+    void reportInfo  (const std::wstring& text) override { acb_.reportCurrentStatus(text); acb_.reportInfo(text); interruptionPoint(); } //
+
+    void reportWarning(const std::wstring& warningMessage, bool& warningActive) override { assert(false); }
+
+    Response reportError(const std::wstring& errorMessage, size_t retryNumber) override { return acb_.reportError(errorMessage, retryNumber); } //throw ThreadInterruption
+    void reportFatalError(const std::wstring& errorMessage) override { acb_.reportFatalError(errorMessage); interruptionPoint(); } //throw ThreadInterruption
+
+    void abortProcessNow() override { assert(false); }
+
+private:
+    AsyncProcessCallback& acb_;
+};
+}
+
+#endif //STATUS_HANDLER_ASYNC_H_2874589234758923475
@@ -1,5 +1,11 @@
 #include "versioning.h"
 #include <cstddef> //required by GCC 4.8.1 to find ptrdiff_t
+#include <map>
+#include <atomic>
+#include <zen/thread.h>
+#include <zen/scope_guard.h>
+#include <zen/serialize.h>
+#include <wx+/zlib_wrap.h>
 
 using namespace zen;
 using AFS = AbstractFileSystem;
@@ -12,6 +18,13 @@ Zstring getDotExtension(const Zstring& relativePath) //including "." if extensio
     const Zstring& extension = getFileExtension(relativePath);
     return extension.empty() ? extension : Zstr('.') + extension;
 };
+
+
+inline
+Zstring getVersionRelPath(const Zstring& relativePath, const Zstring& timeStamp) //e.g. "subdir\Sample.txt 2012-05-15 131513.txt"
+{
+    return relativePath + Zstr(' ') + timeStamp + getDotExtension(relativePath);
+}
 }
 
 bool impl::isMatchingVersion(const Zstring& shortname, const Zstring& shortnameVersioned) //e.g. ("Sample.txt", "Sample.txt 2012-05-15 131513.txt")
@@ -62,6 +75,22 @@ bool impl::isMatchingVersion(const Zstring& shortname, const Zstring& shortnameV
 }
 
 
+bool impl::parseVersionName(const Zstring& shortnameVersioned, Zstring& shortname, Zstring& timeStamp) //e.g. "Sample.txt 2012-05-15 131513.txt"
+{
+    const size_t timeStampLen = 17; //"2012-05-15 131513"
+
+    //version name ends with the extension of the original name, if any
+    const Zstring dotExtension = getDotExtension(shortnameVersioned);
+    if (shortnameVersioned.size() <= dotExtension.size() + timeStampLen + 1)
+        return false;
+
+    const size_t timeStampPos = shortnameVersioned.size() - dotExtension.size() - timeStampLen;
+    shortname = Zstring(shortnameVersioned.c_str(), timeStampPos - 1);
+    timeStamp = Zstring(shortnameVersioned.c_str() + timeStampPos, timeStampLen);
+    return isMatchingVersion(shortname, shortnameVersioned);
+}
+
+
 /*
 create target super directories if missing
 */
@@ -79,7 +108,7 @@ void FileVersioner::moveItemToVersioning(const AbstractPath& itemPath, const Zst
             versionedRelPath = relativePath;
             break;
         case VersioningStyle::ADD_TIMESTAMP: //assemble time-stamped version name
-            versionedRelPath = relativePath + Zstr(' ') + timeStamp_ + getDotExtension(relativePath);
+            versionedRelPath = getVersionRelPath(relativePath, timeStamp_);
             assert(impl::isMatchingVersion(afterLast(relativePath,     FILE_NAME_SEPARATOR, IF_MISSING_RETURN_ALL),
                                            afterLast(versionedRelPath, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_ALL))); //paranoid? no!
             break;
@@ -95,13 +124,20 @@ void FileVersioner::moveItemToVersioning(const AbstractPath& itemPath, const Zst
         //create intermediate directories if missing
         const AbstractPath versionedParentPath = AFS::appendRelPath(versioningFolderPath_, beforeLast(versionedRelPath, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE));
         if (!AFS::somethingExists(versionedParentPath)) //->(minor) file system race condition!
-        {
-            AFS::createFolderRecursively(versionedParentPath); //throw FileError
-            //retry: this should work now!
-            moveItem(itemPath, versionedItemPath); //throw FileError
-            return;
-        }
-        throw;
+            try
+            {
+                AFS::createFolderRecursively(versionedParentPath); //throw FileError
+            }
+            catch (FileError&) { if (!AFS::folderExists(versionedParentPath)) throw; } //created by a concurrent move in the meantime?
+
+        //retry even if parent folder was existing: it might have been created by a concurrent move after the first attempt failed
+        moveItem(itemPath, versionedItemPath); //throw FileError
+    }
+
+    if (versioningStyle_ == VersioningStyle::ADD_TIMESTAMP)
+    {
+        std::lock_guard<std::mutex> dummy(lockVersionedRelPaths);
+        versionedRelPaths_.push_back(relativePath); //missing source item was not moved: no problem, limitVersions() ignores missing versions
     }
 }
 
@@ -183,7 +219,7 @@ void moveFileOrSymlink(const AbstractPath& sourcePath, //throw FileError
             AFS::copySymlink(sourcePath, targetPath, false /*copy filesystem permissions*/); //throw FileError
         else
             AFS::copyFileTransactional(sourcePath, targetPath, //throw FileError, ErrorFileLocked
-            false /*copyFilePermissions*/, true /*transactionalCopy*/, nullptr /*onDeleteTargetFile*/, onNotifyCopyStatus);
+            false /*copyFilePermissions*/, true /*transactionalCopy*/, false /*cloneIfPossible*/, false /*deltaCopy*/, nullptr /*onDeleteTargetFile*/, onNotifyCopyStatus);
 
         AFS::removeFile(sourcePath); //throw FileError; newly copied file is NOT deleted if exception is thrown here!
     };
@@ -200,7 +236,7 @@ void moveFile(const AbstractPath& sourcePath, //throw FileError
     {
         assert(!AFS::somethingExists(targetPath));
         AFS::copyFileTransactional(sourcePath, targetPath, //throw FileError, ErrorFileLocked
-        false /*copyFilePermissions*/, true /*transactionalCopy*/, nullptr /*onDeleteTargetFile*/, onNotifyCopyStatus);
+        false /*copyFilePermissions*/, true /*transactionalCopy*/, false /*cloneIfPossible*/, false /*deltaCopy*/, nullptr /*onDeleteTargetFile*/, onNotifyCopyStatus);
         AFS::removeFile(sourcePath); //throw FileError; newly copied file is NOT deleted if exception is thrown here!
     };
     moveItem(sourcePath, targetPath, copyDelete); //throw FileError
@@ -360,71 +396,369 @@ void FileVersioner::revisionFolderImpl(const AbstractPath& folderPath, const Zst
 }
 
 
+
+namespace
+{
+const size_t VERSION_REMOVAL_THREADS = 4; //removing versions is bound by file system latency, e.g. network shares
+
+//-------------------------------------------------------------------------------------------------------------------------------
+const char FILE_FORMAT_DESCR[] = "FreeFileSync";
+const int VERSION_INDEX_FORMAT_VER = 1;
+//-------------------------------------------------------------------------------------------------------------------------------
+
+using MemStreamOut = MemoryStreamOut<ByteArray>;
+using MemStreamIn  = MemoryStreamIn <ByteArray>;
+
+using VersionTime = std::uint64_t; //time stamp as sortable number: "2012-05-15 131513" <-> 20120515131513; 0 is invalid
+
+//relative path of versioned item, e.g. "subdir\Sample.txt" |-> ascending time stamps of its versions
+using VersionIndex = std::map<Zstring, std::vector<VersionTime>, LessFilePath>;
+
+
+VersionTime timeStampToNumber(const Zstring& timeStamp)
+{
+    VersionTime number = 0;
+    for (const Zchar c : timeStamp)
+        if (isDigit(c))
+            number = number * 10 + (c - Zstr('0'));
+    return number;
+}
+
+
+Zstring numberToTimeStamp(VersionTime number)
+{
+    Zchar buffer[] = Zstr("0000-00-00 000000");
+    for (size_t i = strLength(buffer); i-- > 0;)
+        if (isDigit(buffer[i]))
+        {
+            buffer[i] = static_cast<Zchar>(Zstr('0') + number % 10);
+            number /= 10;
+        }
+    return buffer;
+}
+
+
+void writeUtf8(MemStreamOut& output, const Zstring& str) { writeContainer(output, utfCvrtTo<Zbase<char>>(str)); }
+Zstring readUtf8(MemStreamIn& input) { return utfCvrtTo<Zstring>(readContainer<Zbase<char>>(input)); } //throw UnexpectedEndOfStreamError
+
+
+AbstractPath getVersionIndexPath(const AbstractPath& versioningFolderPath, const Zstring& tmpSuffix = Zstring()) //e.g. ".tmp"
+{
+#ifdef ZEN_WIN
+    const Zstring indexName = Zstr("versions");
+#elif defined ZEN_LINUX || defined ZEN_MAC
+    const Zstring indexName = Zstr(".versions"); //files beginning with dots are hidden e.g. in Nautilus
+#endif
+    //no time stamp => never mistaken for a version of a file
+    return AFS::appendRelPath(versioningFolderPath, indexName + tmpSuffix + Zstr(".ffs_index"));
+}
+
+
+//raw file content: also needed to detect concurrent updates by other FreeFileSync instances
+Opt<ByteArray> loadVersionIndexFile(const AbstractPath& indexPath) //throw FileError; return "NoValue()" if missing
+{
+    if (!AFS::somethingExists(indexPath))
+        return NoValue();
+
+    const std::unique_ptr<AFS::InputStream> fileStreamIn = AFS::getInputStream(indexPath); //throw FileError, ErrorFileLocked
+    return unbufferedLoad<ByteArray>(*fileStreamIn, nullptr); //throw FileError
+}
+
+
+Opt<VersionIndex> parseVersionIndex(const ByteArray& buffer) //return "NoValue()" if outdated or corrupt => rebuild
+{
+    try
+    {
+        MemStreamIn streamIn(buffer);
+
+        char formatDescr[sizeof(FILE_FORMAT_DESCR)] = {};
+        readArray(streamIn, formatDescr, sizeof(formatDescr)); //throw UnexpectedEndOfStreamError
+
+        if (!std::equal(FILE_FORMAT_DESCR, FILE_FORMAT_DESCR + sizeof(FILE_FORMAT_DESCR), formatDescr) ||
+            readNumber<std::int32_t>(streamIn) != VERSION_INDEX_FORMAT_VER)
+            return NoValue();
+
+        MemStreamIn streamBody(decompress(readContainer<ByteArray>(streamIn))); //throw ZlibInternalError
+
+        VersionIndex index;
+        size_t itemCount = readNumber<std::uint32_t>(streamBody);
+        while (itemCount-- != 0)
+        {
+            std::vector<VersionTime>& versions = index[readUtf8(streamBody)];
+
+            size_t versionCount = readNumber<std::uint32_t>(streamBody);
+            versions.reserve(versionCount);
+            while (versionCount-- != 0)
+                versions.push_back(readNumber<std::uint64_t>(streamBody));
+        }
+        return index;
+    }
+    catch (ZlibInternalError&) { return NoValue(); } //corrupt index: not an error, just rebuild
+    catch (UnexpectedEndOfStreamError&) { return NoValue(); } //
+}
+
+
 /*
-void FileVersioner::limitVersions(std::function<void()> updateUI) //throw FileError
+no lock file: another FreeFileSync instance may update the index of the same versioning folder at the same time
+=> the index was changed by someone else since loading it: remove it instead, so that the next limitVersions() rebuilds it with a full traversal
+=> replacing the index is checked again afterwards: only a concurrent replace right between check and rename of the other instance goes unnoticed
+*/
+void saveVersionIndex(const AbstractPath& versioningFolderPath, const VersionIndex& index, const Opt<ByteArray>& indexFileOld) //throw FileError
 {
-    if (versionCountLimit_ < 0) //no limit!
-        return;
+    const AbstractPath indexPath = getVersionIndexPath(versioningFolderPath);
 
-    //buffer map "directory |-> list of immediate child file and symlink short names"
-    std::map<Zstring, std::vector<Zstring>, LessFilePath> dirBuffer;
+    MemStreamOut streamBody;
+    writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(index.size()));
+    for (const auto& item : index)
+    {
+        writeUtf8(streamBody, item.first);
+        writeNumber<std::uint32_t>(streamBody, static_cast<std::uint32_t>(item.second.size()));
+        for (const VersionTime versionTime : item.second)
+            writeNumber<std::uint64_t>(streamBody, versionTime);
+    }
 
-    auto getVersionsBuffered = [&](const Zstring& dirpath) -> const std::vector<Zstring>&
+    MemStreamOut streamOut;
+    writeArray(streamOut, FILE_FORMAT_DESCR, sizeof(FILE_FORMAT_DESCR));
+    writeNumber<std::int32_t>(streamOut, VERSION_INDEX_FORMAT_VER);
+    try
     {
-        auto it = dirBuffer.find(dirpath);
-        if (it != dirBuffer.end())
-            return it->second;
+        writeContainer(streamOut, compress(streamBody.ref(), 3)); //throw ZlibInternalError
+    }
+    catch (ZlibInternalError&)
+    {
+        throw FileError(replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(AFS::getDisplayPath(indexPath))), L"zlib internal error");
+    }
 
-        std::vector<Zstring> fileShortNames;
-        TraverseVersionsOneLevel tol(fileShortNames, updateUI); //throw FileError
-        traverseFolder(dirpath, tol);
+    auto indexChanged = [&](const Opt<ByteArray>& indexFileExpected)
+    {
+        try
+        {
+            const Opt<ByteArray> indexFile = loadVersionIndexFile(indexPath); //throw FileError
+            return static_cast<bool>(indexFile) != static_cast<bool>(indexFileExpected) || (indexFile && !(*indexFile == *indexFileExpected));
+        }
+        catch (FileError&) { return true; } //e.g. index removed by other instance while reading
+    };
 
-        auto& newEntry = dirBuffer[dirpath]; //transactional behavior!!!
-        newEntry.swap(fileShortNames);       //-> until C++11 emplace is available
+    //write as a transaction: an index with missing versions is worse than none
+    AbstractPath indexPathTmp = getVersionIndexPath(versioningFolderPath, Zstr(".tmp"));
+    for (int i = 0;; ++i)
+        try
+        {
+            const std::uint64_t bufferSize = streamOut.ref().size();
+            const std::unique_ptr<AFS::OutputStream> fileStreamOut = AFS::getOutputStream(indexPathTmp, &bufferSize, nullptr /*modificationTime*/); //throw FileError, ErrorTargetExisting
+            unbufferedSave(streamOut.ref(), *fileStreamOut, nullptr); //throw FileError
+            fileStreamOut->finalize([] {}); //throw FileError
+            break;
+        }
+        catch (ErrorTargetExisting&) //temporary file of another instance or orphan of an aborted run: don't touch
+        {
+            if (i == 10) throw; //avoid endless recursion in pathological cases
+            indexPathTmp = getVersionIndexPath(versioningFolderPath, Zchar('_') + numberTo<Zstring>(i) + Zstr(".tmp"));
+        }
+    ZEN_ON_SCOPE_FAIL(try { AFS::removeFile(indexPathTmp); }
+    catch (FileError&) {});
 
-        return newEntry;
+    auto discardIndex = [&]
+    {
+        AFS::removeFile(indexPathTmp); //throw FileError
+        AFS::removeFile(indexPath);    //throw FileError
     };
 
-    std::for_each(fileRelNames.begin(), fileRelNames.end(),
-                  [&](const Zstring& relativePath) //e.g. "subdir\Sample.txt"
+    if (indexChanged(indexFileOld))
+        return discardIndex(); //throw FileError
+
+    AFS::removeFile(indexPath); //throw FileError
+    try
+    {
+        AFS::renameItem(indexPathTmp, indexPath); //throw FileError, ErrorTargetExisting, (ErrorDifferentVolume)
+    }
+    catch (ErrorTargetExisting&) { return discardIndex(); } //throw FileError; other instance was faster
+
+    if (indexChanged(streamOut.ref())) //replaced by other instance in the meantime
+        AFS::removeFile(indexPath); //throw FileError
+}
+
+
+//one-time traversal if index is missing
+class VersionTraverserCallback : public AFS::TraverserCallback
+{
+public:
+    VersionTraverserCallback(const Zstring& relPathPf, VersionIndex& index, const std::function<void()>& updateUI) :
+        relPathPf_(relPathPf), index_(index), updateUI_(updateUI) {}
+
+private:
+    void onFile(const FileInfo& fi) override { addVersion(fi.itemName); }
+
+    std::unique_ptr<TraverserCallback> onDir(const DirInfo& di) override
+    {
+        updateUI_(); //throw X
+        return std::make_unique<VersionTraverserCallback>(relPathPf_ + di.itemName + FILE_NAME_SEPARATOR, index_, updateUI_);
+    }
+
+    HandleLink onSymlink(const SymlinkInfo& si) override
+    {
+        addVersion(si.itemName); //file and folder symlinks are versioned as a whole
+        return TraverserCallback::LINK_SKIP;
+    }
+
+    HandleError reportDirError (const std::wstring& msg, size_t retryNumber)                          override { throw FileError(msg); }
+    HandleError reportItemError(const std::wstring& msg, size_t retryNumber, const Zstring& itemName) override { throw FileError(msg); }
+
+    void addVersion(const Zstring& itemName)
     {
-        const Zstring filepath = appendSeparator(versioningDirectory_) + relativePath; //e.g. "D:\Revisions\subdir\Sample.txt"
-        const Zstring parentDir = beforeLast(filepath, FILE_NAME_SEPARATOR);    //e.g. "D:\Revisions\subdir"
-        const Zstring shortname = afterLast(relativePath, FILE_NAME_SEPARATOR); //e.g. "Sample.txt"; returns the whole string if seperator not found
+        Zstring shortname;
+        Zstring timeStamp;
+        if (impl::parseVersionName(itemName, shortname, timeStamp)) //ignore everything else
+            index_[relPathPf_ + shortname].push_back(timeStampToNumber(timeStamp)); //sorted later
+    }
 
-        const std::vector<Zstring>& allVersions = getVersionsBuffered(parentDir);
+    const Zstring relPathPf_;
+    VersionIndex& index_;
+    const std::function<void()>& updateUI_;
+};
 
-        //filter out only those versions that match the given relative name
-        std::vector<Zstring> matches; //e.g. "Sample.txt 2012-05-15 131513.txt"
 
-        std::copy_if(allVersions.begin(), allVersions.end(), std::back_inserter(matches),
-        [&](const Zstring& shortnameVer) { return impl::isMatchingVersion(shortname, shortnameVer); });
+void removeVersion(const AbstractPath& versionPath) //throw FileError
+{
+    try
+    {
+        AFS::removeFile(versionPath); //throw FileError; missing version is not an error: index may be outdated
+    }
+    catch (FileError&)
+    {
+        if (AFS::symlinkExists(versionPath) && AFS::folderExists(versionPath)) //folder symlink
+            AFS::removeFolderSimple(versionPath); //throw FileError
+        else
+            throw;
+    }
+}
+}
+
+
+void FileVersioner::skipLimitVersions() //throw FileError
+{
+    if (versioningStyle_ != VersioningStyle::ADD_TIMESTAMP)
+        return;
 
-        //take advantage of version naming convention to find oldest versions
-        if (matches.size() <= static_cast<size_t>(versionCountLimit_))
-            return;
-        std::nth_element(matches.begin(), matches.end() - versionCountLimit_, matches.end(), LessFilePath()); //windows: ignore case!
+    //index would miss the new versions => remove it; will be rebuilt by the next limitVersions()
+    if (!versionedRelPaths_.empty())
+        AFS::removeFile(getVersionIndexPath(versioningFolderPath_)); //throw FileError
+    versionedRelPaths_.clear();
+}
+
+
+void FileVersioner::limitVersions(const std::function<void()>& updateUI) //throw FileError
+{
+    if (versioningStyle_ != VersioningStyle::ADD_TIMESTAMP)
+        return;
 
-        //delete obsolete versions
-        std::for_each(matches.begin(), matches.end() - versionCountLimit_,
-                      [&](const Zstring& shortnameVer)
+    if (versionCountLimit_ < 0 && versionCutOff_.empty()) //no limit!
+        return skipLimitVersions(); //throw FileError
+
+    if (versionedRelPaths_.empty() && versionsLimited_) //nothing changed since last call
+        return;
+
+    if (versionedRelPaths_.empty() && !AFS::folderExists(versioningFolderPath_)) //nothing versioned yet
+        return;
+
+    const Opt<ByteArray> indexFileOld = loadVersionIndexFile(getVersionIndexPath(versioningFolderPath_)); //throw FileError
+    Opt<VersionIndex> index;
+    if (indexFileOld)
+        index = parseVersionIndex(*indexFileOld);
+    if (!index)
+    {
+        index = VersionIndex(); //includes versions created during this run
+        VersionTraverserCallback vt(Zstring(), *index, updateUI);
+        AFS::traverseFolder(versioningFolderPath_, vt); //throw FileError
+
+        for (auto& item : *index)
+            std::sort(item.second.begin(), item.second.end());
+    }
+
+    //add versions created during this run
+    const VersionTime syncTime = timeStampToNumber(timeStamp_);
+    for (const Zstring& relPath : versionedRelPaths_)
+    {
+        std::vector<VersionTime>& versions = (*index)[relPath];
+        auto it = std::lower_bound(versions.begin(), versions.end(), syncTime);
+        if (it == versions.end() || *it != syncTime)
+            versions.insert(it, syncTime);
+    }
+    versionedRelPaths_.clear();
+
+    //determine obsolete versions: oldest first for each item
+    const VersionTime cutOffTime = versionCutOff_.empty() ? 0 : timeStampToNumber(versionCutOff_);
+
+    std::vector<std::pair<VersionIndex::iterator, size_t>> obsoleteVersions; //(item, position of time stamp)
+    for (auto it = index->begin(); it != index->end(); ++it)
+    {
+        const std::vector<VersionTime>& versions = it->second;
+
+        size_t removeCount = std::lower_bound(versions.begin(), versions.end(), cutOffTime) - versions.begin();
+        if (versionCountLimit_ >= 0 && versions.size() > static_cast<size_t>(versionCountLimit_))
+            removeCount = std::max(removeCount, versions.size() - versionCountLimit_);
+
+        for (size_t i = 0; i < removeCount; ++i)
+            obsoleteVersions.emplace_back(it, i);
+    }
+
+    //remove versions in parallel: worker threads only read "index" and "obsoleteVersions"
+    std::vector<char> versionRemoved(obsoleteVersions.size()); //each element is written by a single worker
+    std::atomic<size_t> nextPos(0);
+    std::mutex lockErrors;
+    Opt<FileError> firstError;
+
+    auto removeVersions = [&] //throw ThreadInterruption
+    {
+        for (size_t pos = nextPos++; pos < obsoleteVersions.size(); pos = nextPos++)
         {
-            updateUI();
-            const Zstring fullnameVer = parentDir + FILE_NAME_SEPARATOR + shortnameVer;
+            interruptionPoint(); //throw ThreadInterruption
+
+            const auto& item = obsoleteVersions[pos];
+            const Zstring versionRelPath = getVersionRelPath(item.first->first, numberToTimeStamp(item.first->second[item.second]));
             try
             {
-                removeFile(fullnameVer); //throw FileError
+                removeVersion(AFS::appendRelPath(versioningFolderPath_, versionRelPath)); //throw FileError
+                versionRemoved[pos] = true;
             }
-            catch (FileError&)
+            catch (const FileError& e)
             {
-#ifdef ZEN_WIN //if it's a directory symlink:
-                if (symlinkExists(fullnameVer) && dirExists(fullnameVer))
-                    removeDirectory(fullnameVer); //throw FileError
-                else
-#endif
-                    throw;
+                std::lock_guard<std::mutex> dummy(lockErrors);
+                if (!firstError)
+                    firstError = e;
             }
-        });
-    });
+        }
+    };
+
+    std::vector<InterruptibleThread> worker;
+    ZEN_ON_SCOPE_EXIT(for (InterruptibleThread& wt : worker) if (wt.joinable()) { wt.interrupt(); wt.join(); }); //user abort: don't leave threads accessing local variables!
+
+    for (size_t i = 0; i < std::min(VERSION_REMOVAL_THREADS, obsoleteVersions.size()); ++i)
+        worker.emplace_back(removeVersions);
+
+    for (InterruptibleThread& wt : worker)
+        while (!wt.tryJoinFor(std::chrono::milliseconds(100)))
+            updateUI(); //throw X
+
+    //update index: also if some versions could not be removed
+    for (size_t pos = 0; pos < obsoleteVersions.size(); ++pos)
+        if (versionRemoved[pos])
+            obsoleteVersions[pos].first->second[obsoleteVersions[pos].second] = 0; //mark as removed
+
+    for (auto it = index->begin(); it != index->end();)
+    {
+        std::vector<VersionTime>& versions = it->second;
+        versions.erase(std::remove(versions.begin(), versions.end(), 0), versions.end());
+
+        if (versions.empty())
+            it = index->erase(it);
+        else
+            ++it;
+    }
+
+    saveVersionIndex(versioningFolderPath_, *index, indexFileOld); //throw FileError
+    versionsLimited_ = true;
+
+    if (firstError)
+        throw *firstError;
 }
-*/
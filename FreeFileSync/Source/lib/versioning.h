@@ -7,6 +7,7 @@
 #ifndef VERSIONING_H_8760247652438056
 #define VERSIONING_H_8760247652438056
 
+#include <mutex>
 #include <functional>
 #include <zen/time.h>
 #include <zen/file_error.h>
@@ -26,6 +27,13 @@ namespace zen
     - replaces already existing target files/dirs (supports retry)
         => (unlikely) risk of data loss for naming convention "versioning":
         race-condition if two FFS instances start at the very same second OR multiple folder pairs process the same filepath!!
+    - revisionFile() and revisionFolder() are thread-safe, limitVersions() is not
+
+version retention (VersioningStyle::ADD_TIMESTAMP only):
+    - index file in versioning folder lists all versions: <relpath>\<filename>.<ext> |-> sorted time stamps
+    - built by a single traversal if missing, then updated incrementally => no traversal of the versioning folder for each sync
+    - versions created by other means than FreeFileSync are not considered until the index file is deleted
+    - index changed by another FreeFileSync instance in the meantime: index file is deleted => rebuilt during the next run
 */
 
 class FileVersioner
@@ -33,16 +41,34 @@ class FileVersioner
 public:
     FileVersioner(const AbstractPath& versioningFolderPath, //throw FileError
                   VersioningStyle versioningStyle,
-                  const TimeComp& timeStamp) :
+                  const TimeComp& timeStamp,
+                  int versionCountLimit, //< 0 means no limit
+                  int versionMaxAgeDays) : //
         versioningFolderPath_(versioningFolderPath),
         versioningStyle_(versioningStyle),
-        timeStamp_(formatTime<Zstring>(Zstr("%Y-%m-%d %H%M%S"), timeStamp)) //e.g. "2012-05-15 131513"
+        timeStamp_(formatTime<Zstring>(Zstr("%Y-%m-%d %H%M%S"), timeStamp)), //e.g. "2012-05-15 131513"
+        versionCountLimit_(versionCountLimit)
     {
         if (AbstractFileSystem::isNullPath(versioningFolderPath_))
             throw std::logic_error("Contract violation! " + std::string(__FILE__) + ":" + numberTo<std::string>(__LINE__));
 
         if (timeStamp_.size() != 17) //formatTime() returns empty string on error; unexpected length: e.g. problem in year 10,000!
             throw FileError(_("Unable to create time stamp for versioning:") + L" \"" + utfCvrtTo<std::wstring>(timeStamp_) + L"\"");
+
+        if (versionMaxAgeDays >= 0)
+        {
+            const time_t syncTime = localToTimeT(timeStamp);
+            if (syncTime == -1)
+                throw FileError(_("Unable to create time stamp for versioning:") + L" \"" + utfCvrtTo<std::wstring>(timeStamp_) + L"\"");
+
+            const std::int64_t maxAgeSec = static_cast<std::int64_t>(versionMaxAgeDays) * 24 * 3600; //int would overflow for more than 24855 days
+            if (maxAgeSec < syncTime) //else: cut-off before 1970 => no version is old enough
+            {
+                versionCutOff_ = formatTime<Zstring>(Zstr("%Y-%m-%d %H%M%S"), localTime(syncTime - static_cast<time_t>(maxAgeSec))); //versions with older time stamp are removed
+                if (versionCutOff_.size() != 17)
+                    throw FileError(_("Unable to create time stamp for versioning:") + L" \"" + utfCvrtTo<std::wstring>(versionCutOff_) + L"\"");
+            }
+        }
     }
 
     bool revisionFile(const AbstractPath& filePath, //throw FileError; return "false" if file is not existing
@@ -59,7 +85,8 @@ public:
                         //called frequently if move has to revert to copy + delete => see zen::copyFile for limitations when throwing exceptions!
                         const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus);
 
-    //void limitVersions(std::function<void()> updateUI); //throw FileError; call when done revisioning!
+    void limitVersions(const std::function<void()>& updateUI); //throw FileError; call when done revisioning!
+    void skipLimitVersions(); //throw FileError; call instead of limitVersions() if it can't be cancelled, e.g. on abort
 
 private:
     void revisionFolderImpl(const AbstractPath& folderPath, const Zstring& relativePath,
@@ -74,13 +101,18 @@ private:
     const AbstractPath versioningFolderPath_;
     const VersioningStyle versioningStyle_;
     const Zstring timeStamp_;
+    const int versionCountLimit_;
+    Zstring versionCutOff_; //empty if no age limit
 
-    //std::vector<Zstring> fileRelNames; //store list of revisioned file and symlink relative names for limitVersions()
+    std::mutex lockVersionedRelPaths;
+    std::vector<Zstring> versionedRelPaths_; //store list of revisioned file and symlink relative paths for limitVersions()
+    bool versionsLimited_ = false; //limitVersions() succeeded before: redo only for new versions
 };
 
 namespace impl //declare for unit tests:
 {
 bool isMatchingVersion(const Zstring& shortname, const Zstring& shortnameVersion);
+bool parseVersionName(const Zstring& shortnameVersion, Zstring& shortname, Zstring& timeStamp); //e.g. "Sample.txt 2012-05-15 131513.txt" -> ("Sample.txt", "2012-05-15 131513")
 }
 }
 
@@ -5,11 +5,13 @@
 // *****************************************************************************
 
 #include "synchronization.h"
+#include <deque>
 #include <zen/process_priority.h>
 #include <zen/perf.h>
 #include "lib/db_file.h"
 #include "lib/dir_exist_async.h"
 #include "lib/status_handler_impl.h"
+#include "lib/status_handler_async.h"
 #include "lib/versioning.h"
 #include "lib/binary.h"
 #include "fs/concrete.h"
@@ -41,196 +43,52 @@ int getCUD(const SyncStatistics& stat)
 
 SyncStatistics::SyncStatistics(const FolderComparison& folderCmp)
 {
-    std::for_each(begin(folderCmp), end(folderCmp), [&](const BaseFolderPair& baseFolder) { recurse(baseFolder); });
+    std::for_each(begin(folderCmp), end(folderCmp), [&](const BaseFolderPair& baseFolder) { addSubTree(baseFolder); });
 }
 
 
 SyncStatistics::SyncStatistics(const HierarchyObject& hierObj)
 {
-    recurse(hierObj);
+    addSubTree(hierObj);
 }
 
 
-SyncStatistics::SyncStatistics(const FilePair& file)
+SyncStatistics::SyncStatistics(const FilePair& file) : stats(getItemStats(file))
 {
-    processFile(file);
-    rowsTotal += 1;
+    if (stats.conflictCount > 0)
+        conflictMsgs.emplace_back(file.getPairRelativePath(), file.getSyncOpConflict());
+    stats.rowCount += 1;
 }
 
 
-inline
-void SyncStatistics::recurse(const HierarchyObject& hierObj)
+void SyncStatistics::addSubTree(const HierarchyObject& hierObj)
 {
-    for (const FilePair& file : hierObj.refSubFiles())
-        processFile(file);
-    for (const SymlinkPair& link : hierObj.refSubLinks())
-        processLink(link);
-    for (const FolderPair& folder : hierObj.refSubFolders())
-        processFolder(folder);
+    stats.add(hierObj.getSubTreeStats()); //buffered: O(1) unless items have changed
 
-    rowsTotal += hierObj.refSubFolders().size();
-    rowsTotal += hierObj.refSubFiles  ().size();
-    rowsTotal += hierObj.refSubLinks  ().size();
+    collectConflicts(hierObj);
 }
 
 
-inline
-void SyncStatistics::processFile(const FilePair& file)
+void SyncStatistics::collectConflicts(const HierarchyObject& hierObj)
 {
-    switch (file.getSyncOperation()) //evaluate comparison result and sync direction
-    {
-        case SO_CREATE_NEW_LEFT:
-            ++createLeft;
-            dataToProcess += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
-            break;
-
-        case SO_CREATE_NEW_RIGHT:
-            ++createRight;
-            dataToProcess += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
-            break;
-
-        case SO_DELETE_LEFT:
-            ++deleteLeft;
-            break;
-
-        case SO_DELETE_RIGHT:
-            ++deleteRight;
-            break;
-
-        case SO_MOVE_LEFT_TARGET:
-            ++updateLeft;
-            break;
-
-        case SO_MOVE_RIGHT_TARGET:
-            ++updateRight;
-            break;
-
-        case SO_MOVE_LEFT_SOURCE:  //ignore; already counted
-        case SO_MOVE_RIGHT_SOURCE: //
-            break;
-
-        case SO_OVERWRITE_LEFT:
-            ++updateLeft;
-            dataToProcess += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
-            break;
-
-        case SO_OVERWRITE_RIGHT:
-            ++updateRight;
-            dataToProcess += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
-            break;
+    if (hierObj.getSubTreeStats().conflictCount == 0) //skip sub trees without conflicts
+        return;
 
-        case SO_UNRESOLVED_CONFLICT:
+    for (const FilePair& file : hierObj.refSubFiles())
+        if (file.getSyncOperation() == SO_UNRESOLVED_CONFLICT)
             conflictMsgs.emplace_back(file.getPairRelativePath(), file.getSyncOpConflict());
-            break;
-
-        case SO_COPY_METADATA_TO_LEFT:
-            ++updateLeft;
-            break;
-
-        case SO_COPY_METADATA_TO_RIGHT:
-            ++updateRight;
-            break;
-
-        case SO_DO_NOTHING:
-        case SO_EQUAL:
-            break;
-    }
-}
-
-
-inline
-void SyncStatistics::processLink(const SymlinkPair& link)
-{
-    switch (link.getSyncOperation()) //evaluate comparison result and sync direction
-    {
-        case SO_CREATE_NEW_LEFT:
-            ++createLeft;
-            break;
 
-        case SO_CREATE_NEW_RIGHT:
-            ++createRight;
-            break;
-
-        case SO_DELETE_LEFT:
-            ++deleteLeft;
-            break;
-
-        case SO_DELETE_RIGHT:
-            ++deleteRight;
-            break;
-
-        case SO_OVERWRITE_LEFT:
-        case SO_COPY_METADATA_TO_LEFT:
-            ++updateLeft;
-            break;
-
-        case SO_OVERWRITE_RIGHT:
-        case SO_COPY_METADATA_TO_RIGHT:
-            ++updateRight;
-            break;
-
-        case SO_UNRESOLVED_CONFLICT:
+    for (const SymlinkPair& link : hierObj.refSubLinks())
+        if (link.getSyncOperation() == SO_UNRESOLVED_CONFLICT)
             conflictMsgs.emplace_back(link.getPairRelativePath(), link.getSyncOpConflict());
-            break;
 
-        case SO_MOVE_LEFT_SOURCE:
-        case SO_MOVE_RIGHT_SOURCE:
-        case SO_MOVE_LEFT_TARGET:
-        case SO_MOVE_RIGHT_TARGET:
-            assert(false);
-        case SO_DO_NOTHING:
-        case SO_EQUAL:
-            break;
-    }
-}
-
-
-inline
-void SyncStatistics::processFolder(const FolderPair& folder)
-{
-    switch (folder.getSyncOperation()) //evaluate comparison result and sync direction
+    for (const FolderPair& folder : hierObj.refSubFolders())
     {
-        case SO_CREATE_NEW_LEFT:
-            ++createLeft;
-            break;
-
-        case SO_CREATE_NEW_RIGHT:
-            ++createRight;
-            break;
-
-        case SO_DELETE_LEFT: //if deletion variant == user-defined directory existing on other volume, this results in a full copy + delete operation!
-            ++deleteLeft;    //however we cannot (reliably) anticipate this situation, fortunately statistics can be adapted during sync!
-            break;
-
-        case SO_DELETE_RIGHT:
-            ++deleteRight;
-            break;
-
-        case SO_UNRESOLVED_CONFLICT:
+        if (folder.getSyncOperation() == SO_UNRESOLVED_CONFLICT)
             conflictMsgs.emplace_back(folder.getPairRelativePath(), folder.getSyncOpConflict());
-            break;
 
-        case SO_OVERWRITE_LEFT:
-        case SO_COPY_METADATA_TO_LEFT:
-            ++updateLeft;
-            break;
-
-        case SO_OVERWRITE_RIGHT:
-        case SO_COPY_METADATA_TO_RIGHT:
-            ++updateRight;
-            break;
-
-        case SO_MOVE_LEFT_SOURCE:
-        case SO_MOVE_RIGHT_SOURCE:
-        case SO_MOVE_LEFT_TARGET:
-        case SO_MOVE_RIGHT_TARGET:
-            assert(false);
-        case SO_DO_NOTHING:
-        case SO_EQUAL:
-            break;
+        collectConflicts(folder); //recurse
     }
-
-    recurse(folder); //since we model logical stats, we recurse, even if deletion variant is "recycler" or "versioning + same volume", which is a single physical operation!
 }
 
 //-----------------------------------------------------------------------------------------------------------
@@ -288,9 +146,11 @@ class DeletionHandling //abstract deletion variants: permanently, recycle bin, u
 public:
     DeletionHandling(const AbstractPath& baseFolderPath,
                      DeletionPolicy handleDel, //nothrow!
-                     const Zstring& versioningFolderPhrase,
+                     const AbstractPath& versioningFolderPath,
                      VersioningStyle versioningStyle,
                      const TimeComp& timeStamp,
+                     int versionCountLimit,
+                     int versionMaxAgeDays,
                      ProcessCallback& procCallback);
     ~DeletionHandling()
     {
@@ -307,22 +167,25 @@ public:
         */
     }
 
-    //clean-up temporary directory (recycle bin optimization)
+    //clean-up temporary directory (recycle bin optimization), remove obsolete versions (only if allowUserCallback)
     void tryCleanup(bool allowUserCallback); //throw FileError; throw X -> call this in non-exceptional coding, i.e. somewhere after sync!
 
+    //thread-safe: may be called by multiple worker threads using their own ProcessCallback
     template <class Function> void removeFileWithCallback (const AbstractPath& filePath, const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus); //
-    template <class Function> void removeDirWithCallback  (const AbstractPath& dirPath,  const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus); //throw FileError
-    template <class Function> void removeLinkWithCallback (const AbstractPath& linkPath, const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus); //
+    template <class Function> void removeDirWithCallback  (const AbstractPath& dirPath,  const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus, ProcessCallback& callback); //throw FileError
+    template <class Function> void removeLinkWithCallback (const AbstractPath& linkPath, const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus, ProcessCallback& callback); //
 
     const std::wstring& getTxtRemovingFile   () const { return txtRemovingFile;      } //
     const std::wstring& getTxtRemovingSymLink() const { return txtRemovingSymlink;   } //buffered status texts
     const std::wstring& getTxtRemovingDir    () const { return txtRemovingDirectory; } //
 
+    DeletionPolicy getDeletionPolicy() const { return deletionPolicy_; }
+
 private:
     DeletionHandling           (const DeletionHandling&) = delete;
     DeletionHandling& operator=(const DeletionHandling&) = delete;
 
-    AFS::RecycleSession& getOrCreateRecyclerSession() //throw FileError => dont create in constructor!!!
+    AFS::RecycleSession& getOrCreateRecyclerSession() //throw FileError => dont create in constructor!!!; call while holding "lockRecycler"
     {
         assert(deletionPolicy_ == DeletionPolicy::RECYCLER);
         if (!recyclerSession.get())
@@ -333,8 +196,9 @@ private:
     FileVersioner& getOrCreateVersioner() //throw FileError => dont create in constructor!!!
     {
         assert(deletionPolicy_ == DeletionPolicy::VERSIONING);
+        std::lock_guard<std::mutex> dummy(lockVersioner);
         if (!versioner.get())
-            versioner = std::make_unique<FileVersioner>(versioningFolderPath, versioningStyle_, timeStamp_); //throw FileError
+            versioner = std::make_unique<FileVersioner>(versioningFolderPath, versioningStyle_, timeStamp_, versionCountLimit_, versionMaxAgeDays_); //throw FileError
         return *versioner;
     }
 
@@ -343,12 +207,16 @@ private:
     const DeletionPolicy deletionPolicy_; //keep it invariant! e.g. consider getOrCreateVersioner() one-time construction!
 
     const AbstractPath baseFolderPath_;
+    std::mutex lockRecycler; //RecycleSession is not thread-safe: e.g. collects items for batch-recycling on Windows
     std::unique_ptr<AFS::RecycleSession> recyclerSession;
 
     //used only for DeletionPolicy::VERSIONING:
     const AbstractPath versioningFolderPath;
     const VersioningStyle versioningStyle_;
     const TimeComp timeStamp_;
+    const int versionCountLimit_;
+    const int versionMaxAgeDays_;
+    std::mutex lockVersioner;
     std::unique_ptr<FileVersioner> versioner; //throw FileError in constructor => create on demand!
 
     //buffer status texts:
@@ -363,16 +231,20 @@ private:
 
 DeletionHandling::DeletionHandling(const AbstractPath& baseFolderPath,
                                    DeletionPolicy handleDel, //nothrow!
-                                   const Zstring& versioningFolderPhrase,
+                                   const AbstractPath& versioningFolderPath,
                                    VersioningStyle versioningStyle,
                                    const TimeComp& timeStamp,
+                                   int versionCountLimit,
+                                   int versionMaxAgeDays,
                                    ProcessCallback& procCallback) :
     procCallback_(procCallback),
     deletionPolicy_(handleDel),
     baseFolderPath_(baseFolderPath),
-    versioningFolderPath(createAbstractPath(versioningFolderPhrase)),
+    versioningFolderPath(versioningFolderPath),
     versioningStyle_(versioningStyle),
     timeStamp_(timeStamp),
+    versionCountLimit_(versionCountLimit),
+    versionMaxAgeDays_(versionMaxAgeDays),
     txtMovingFile  (_("Moving file %x to %y")),
     txtMovingFolder(_("Moving folder %x to %y"))
 {
@@ -426,16 +298,17 @@ void DeletionHandling::tryCleanup(bool allowUserCallback) //throw FileError; thr
             break;
 
         case DeletionPolicy::VERSIONING:
-            //if (versioner.get())
-            //{
-            //    if (allowUserCallback)
-            //    {
-            //        procCallback_.reportStatus(_("Removing old versions...")); //throw ?
-            //        versioner->limitVersions([&] { procCallback_.requestUiRefresh(); /*throw ? */ }); //throw FileError
-            //    }
-            //    else
-            //        versioner->limitVersions([] {}); //throw FileError
-            //}
+            if (allowUserCallback)
+            {
+                //versions expire even if nothing was versioned during this run
+                if (versioner.get() || versionMaxAgeDays_ >= 0)
+                {
+                    procCallback_.reportStatus(_("Removing old versions...")); //throw ?
+                    getOrCreateVersioner().limitVersions([&] { procCallback_.requestUiRefresh(); /*throw ? */ }); //throw FileError
+                }
+            }
+            else if (versioner.get()) //e.g. synchronization aborted: removing old versions could not be cancelled => leave it to the next run
+                versioner->skipLimitVersions(); //throw FileError
             break;
     }
 }
@@ -445,7 +318,8 @@ template <class Function>
 void DeletionHandling::removeDirWithCallback(const AbstractPath& folderPath,
                                              const Zstring& relativePath,
                                              Function onNotifyItemDeletion,
-                                             const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus) //throw FileError
+                                             const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus,
+                                             ProcessCallback& callback) //throw FileError
 {
     switch (deletionPolicy_)
     {
@@ -454,7 +328,7 @@ void DeletionHandling::removeDirWithCallback(const AbstractPath& folderPath,
             auto notifyDeletion = [&](const std::wstring& statusText, const std::wstring& displayPath)
             {
                 onNotifyItemDeletion(); //it would be more correct to report *after* work was done!
-                procCallback_.reportStatus(replaceCpy(statusText, L"%x", fmtPath(displayPath)));
+                callback.reportStatus(replaceCpy(statusText, L"%x", fmtPath(displayPath)));
             };
             auto onBeforeFileDeletion = [&](const std::wstring& displayPath) { notifyDeletion(txtRemovingFile,      displayPath); };
             auto onBeforeDirDeletion  = [&](const std::wstring& displayPath) { notifyDeletion(txtRemovingDirectory, displayPath); };
@@ -464,16 +338,23 @@ void DeletionHandling::removeDirWithCallback(const AbstractPath& folderPath,
         break;
 
         case DeletionPolicy::RECYCLER:
-            if (getOrCreateRecyclerSession().recycleItem(folderPath, relativePath)) //throw FileError; return true if item existed
+        {
+            bool recycled = false;
+            {
+                std::lock_guard<std::mutex> dummy(lockRecycler);
+                recycled = getOrCreateRecyclerSession().recycleItem(folderPath, relativePath); //throw FileError; return true if item existed
+            }
+            if (recycled)
                 onNotifyItemDeletion(); //moving to recycler is ONE logical operation, irrespective of the number of child elements!
-            break;
+        }
+        break;
 
         case DeletionPolicy::VERSIONING:
         {
             auto notifyMove = [&](const std::wstring& statusText, const std::wstring& displayPathFrom, const std::wstring& displayPathTo)
             {
                 onNotifyItemDeletion(); //it would be more correct to report *after* work was done!
-                procCallback_.reportStatus(replaceCpy(replaceCpy(statusText, L"%x", L"\n" + fmtPath(displayPathFrom)), L"%y", L"\n" + fmtPath(displayPathTo)));
+                callback.reportStatus(replaceCpy(replaceCpy(statusText, L"%x", L"\n" + fmtPath(displayPathFrom)), L"%y", L"\n" + fmtPath(displayPathTo)));
             };
             auto onBeforeFileMove   = [&](const std::wstring& displayPathFrom, const std::wstring& displayPathTo) { notifyMove(txtMovingFile,   displayPathFrom, displayPathTo); };
             auto onBeforeFolderMove = [&](const std::wstring& displayPathFrom, const std::wstring& displayPathTo) { notifyMove(txtMovingFolder, displayPathFrom, displayPathTo); };
@@ -503,8 +384,11 @@ void DeletionHandling::removeFileWithCallback(const AbstractPath& filePath,
                 break;
 
             case DeletionPolicy::RECYCLER:
+            {
+                std::lock_guard<std::mutex> dummy(lockRecycler);
                 deleted = getOrCreateRecyclerSession().recycleItem(filePath, relativePath); //throw FileError; return true if item existed
-                break;
+            }
+            break;
 
             case DeletionPolicy::VERSIONING:
                 deleted = getOrCreateVersioner().revisionFile(filePath, relativePath, onNotifyCopyStatus); //throw FileError
@@ -516,10 +400,10 @@ void DeletionHandling::removeFileWithCallback(const AbstractPath& filePath,
 
 
 template <class Function> inline
-void DeletionHandling::removeLinkWithCallback(const AbstractPath& linkPath, const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus) //throw FileError
+void DeletionHandling::removeLinkWithCallback(const AbstractPath& linkPath, const Zstring& relativePath, Function onNotifyItemDeletion, const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus, ProcessCallback& callback) //throw FileError
 {
     if (AFS::folderExists(linkPath)) //dir symlink
-        return removeDirWithCallback(linkPath, relativePath, onNotifyItemDeletion, onNotifyCopyStatus); //throw FileError
+        return removeDirWithCallback(linkPath, relativePath, onNotifyItemDeletion, onNotifyCopyStatus, callback); //throw FileError
     else //file symlink, broken symlink
         return removeFileWithCallback(linkPath, relativePath, onNotifyItemDeletion, onNotifyCopyStatus); //throw FileError
 }
@@ -535,83 +419,162 @@ void DeletionHandling::removeLinkWithCallback(const AbstractPath& linkPath, cons
 
 => generally assume deletion frees space; may avoid false positive disk space warnings for recycler and versioning
 */
-class MinimumDiskSpaceNeeded
+std::pair<std::int64_t, std::int64_t> getMinimumDiskSpaceNeeded(const BaseFolderPair& baseFolder)
+{
+    const SubTreeStats& stats = baseFolder.getSubTreeStats(); //buffered: see HierarchyObject
+    return { stats.spaceNeededLeft, stats.spaceNeededRight };
+}
+
+//----------------------------------------------------------------------------------------
+
+//execute independent file operations on worker threads while the main thread continues traversing the hierarchy
+//CAVEAT: worker threads must not access the FileSystemObject hierarchy! => results are applied by "onCompletion" in the context of the main thread
+class AsyncSyncTasks
 {
 public:
-    static std::pair<std::int64_t, std::int64_t> calculate(const BaseFolderPair& baseFolder)
+    using WorkItem   = std::function<void(ProcessCallback& workerCallback)>; //throw ThreadInterruption
+    using Completion = std::function<void()>; //noexcept
+
+    AsyncSyncTasks(size_t threadCount, ProcessCallback& callback) :
+        callback_(callback),
+        tasksPendingMax(2 * threadCount) //keep all threads busy, but don't run too far ahead of the status messages of the main thread
     {
-        MinimumDiskSpaceNeeded inst;
-        inst.recurse(baseFolder);
-        return std::make_pair(inst.spaceNeededLeft, inst.spaceNeededRight);
-    }
+        //thread creation failed: destroying a joinable thread calls std::terminate()
+        ZEN_ON_SCOPE_FAIL(for (InterruptibleThread& wt : worker) wt.interrupt();
+                          for (InterruptibleThread& wt : worker) wt.join(););
 
-private:
-    MinimumDiskSpaceNeeded() {}
+        for (size_t i = 0; i < threadCount; ++i)
+            worker.emplace_back([this]
+        {
+#ifdef ZEN_WIN
+            setCurrentThreadName("Sync Worker");
+#endif
+            this->runWorker(); //throw ThreadInterruption
+        });
+    }
 
-    void recurse(const HierarchyObject& hierObj)
+    ~AsyncSyncTasks()
     {
-        //don't process directories
+        for (InterruptibleThread& wt : worker)
+            wt.interrupt(); //interrupt all at once first, then join
+        for (InterruptibleThread& wt : worker)
+            wt.join();
+
+        //sync was aborted: still apply the results of finished operations => database must reflect the real file state
+        for (const Completion& onCompletion : tasksDone)
+            onCompletion();
+    }
 
-        //process files
-        for (const FilePair& file : hierObj.refSubFiles())
-            switch (file.getSyncOperation()) //evaluate comparison result and sync direction
+    //context of main thread: blocks if too many tasks are pending
+    void addTask(WorkItem&& work, Completion&& onCompletion) //throw X
+    {
+        for (;;)
+        {
+            processEvents(); //throw X
             {
-                case SO_CREATE_NEW_LEFT:
-                    spaceNeededLeft += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+                std::unique_lock<std::mutex> dummy(lockTasks);
+                if (tasksPending < tasksPendingMax)
+                {
+                    tasksQueued.emplace_back(std::move(work), std::move(onCompletion));
+                    ++tasksPending;
                     break;
+                }
+                conditionTaskDone.wait_for(dummy, std::chrono::milliseconds(UI_UPDATE_INTERVAL / 2));
+            }
+            reportStatus(); //throw X
+        }
+        conditionNewTask.notify_all(); //instead of notify_one(); workaround bug: https://svn.boost.org/trac/boost/ticket/7796
+    }
 
-                case SO_CREATE_NEW_RIGHT:
-                    spaceNeededRight += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
-                    break;
+    //context of main thread: forward worker requests and apply results of finished tasks
+    void processEvents() //throw X
+    {
+        acb.processRequests(callback_); //throw X
 
-                case SO_DELETE_LEFT:
-                    //if (freeSpaceDelLeft_)
-                    spaceNeededLeft -= static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
-                    break;
+        std::vector<Completion> completions;
+        {
+            std::lock_guard<std::mutex> dummy(lockTasks);
+            completions.swap(tasksDone);
+        }
+        for (const Completion& onCompletion : completions)
+            onCompletion();
+    }
 
-                case SO_DELETE_RIGHT:
-                    //if (freeSpaceDelRight_)
-                    spaceNeededRight -= static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
+    //context of main thread
+    void waitUntilDone() //throw X
+    {
+        for (;;)
+        {
+            processEvents(); //throw X
+            {
+                std::unique_lock<std::mutex> dummy(lockTasks);
+                if (tasksPending == 0)
                     break;
+                conditionTaskDone.wait_for(dummy, std::chrono::milliseconds(UI_UPDATE_INTERVAL / 2));
+            }
+            reportStatus(); //throw X
+        }
+        processEvents(); //throw X
+    }
 
-                case SO_OVERWRITE_LEFT:
-                    //if (freeSpaceDelLeft_)
-                    spaceNeededLeft -= static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
-                    spaceNeededLeft += static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
-                    break;
+private:
+    AsyncSyncTasks           (const AsyncSyncTasks&) = delete;
+    AsyncSyncTasks& operator=(const AsyncSyncTasks&) = delete;
 
-                case SO_OVERWRITE_RIGHT:
-                    //if (freeSpaceDelRight_)
-                    spaceNeededRight -= static_cast<std::int64_t>(file.getFileSize<RIGHT_SIDE>());
-                    spaceNeededRight += static_cast<std::int64_t>(file.getFileSize<LEFT_SIDE>());
-                    break;
+    void reportStatus() //throw X
+    {
+        const std::wstring statusText = acb.getCurrentStatus();
+        if (!statusText.empty())
+            callback_.reportStatus(statusText); //throw X
+        else
+            callback_.requestUiRefresh(); //throw X
+    }
 
-                case SO_DO_NOTHING:
-                case SO_EQUAL:
-                case SO_UNRESOLVED_CONFLICT:
-                case SO_COPY_METADATA_TO_LEFT:
-                case SO_COPY_METADATA_TO_RIGHT:
-                case SO_MOVE_LEFT_SOURCE:
-                case SO_MOVE_RIGHT_SOURCE:
-                case SO_MOVE_LEFT_TARGET:
-                case SO_MOVE_RIGHT_TARGET:
-                    break;
+    void runWorker() //throw ThreadInterruption
+    {
+        WorkerProcessCallback workerCallback(acb);
+        for (;;)
+        {
+            std::pair<WorkItem, Completion> task;
+            {
+                std::unique_lock<std::mutex> dummy(lockTasks);
+                interruptibleWait(conditionNewTask, dummy, [this] { return !tasksQueued.empty(); }); //throw ThreadInterruption
+                task = std::move(tasksQueued.front());
+                tasksQueued.pop_front();
             }
+            {
+                acb.incActiveWorker();
+                ZEN_ON_SCOPE_EXIT(acb.decActiveWorker());
+                task.first(workerCallback); //throw ThreadInterruption
+            }
+            {
+                std::lock_guard<std::mutex> dummy(lockTasks);
+                tasksDone.push_back(std::move(task.second));
+                --tasksPending;
+            }
+            conditionTaskDone.notify_all();
+        }
+    }
 
-        //symbolic links
-        //[...]
+    ProcessCallback& callback_;
+    AsyncProcessCallback acb;
 
-        //recurse into sub-dirs
-        for (const FolderPair& folder : hierObj.refSubFolders())
-            recurse(folder);
-    }
+    std::mutex lockTasks;
+    std::condition_variable conditionNewTask;
+    std::condition_variable conditionTaskDone;
+    std::deque<std::pair<WorkItem, Completion>> tasksQueued;
+    std::vector<Completion> tasksDone;
+    size_t tasksPending = 0; //queued + running
+    const size_t tasksPendingMax;
 
-    std::int64_t spaceNeededLeft  = 0;
-    std::int64_t spaceNeededRight = 0;
+    std::vector<InterruptibleThread> worker;
 };
 
 //----------------------------------------------------------------------------------------
 
+const std::uint64_t DELTA_COPY_MIN_FILE_SIZE = 16 * 1024 * 1024; //smaller files: reading both source and target costs more than a full copy
+
+
 class SynchronizeFolderPair
 {
 public:
@@ -619,26 +582,45 @@ public:
                           bool verifyCopiedFiles,
                           bool copyFilePermissions,
                           bool failSafeFileCopy,
+                          bool cloneFiles,
+                          bool deltaCopy,
+                          bool deltaCopyInPlace,
+                          size_t threadCount,
 #ifdef ZEN_WIN
                           shadow::ShadowCopy* shadowCopyHandler,
+                          std::mutex& lockShadowCopy,
 #endif
                           DeletionHandling& delHandlingLeft,
                           DeletionHandling& delHandlingRight) :
         procCallback_(procCallback),
 #ifdef ZEN_WIN
         shadowCopyHandler_(shadowCopyHandler),
+        lockShadowCopy_(lockShadowCopy),
 #endif
         delHandlingLeft_(delHandlingLeft),
         delHandlingRight_(delHandlingRight),
         verifyCopiedFiles_(verifyCopiedFiles),
         copyFilePermissions_(copyFilePermissions),
-        failSafeFileCopy_(failSafeFileCopy) {}
+        failSafeFileCopy_(failSafeFileCopy),
+        cloneFiles_(cloneFiles),
+        deltaCopy_(deltaCopy),
+        deltaCopyInPlace_(deltaCopyInPlace),
+        threadCount_(threadCount) {}
 
     void startSync(BaseFolderPair& baseFolder)
     {
-        runZeroPass(baseFolder);       //first process file moves
-        runPass<PASS_ONE>(baseFolder); //delete files (or overwrite big ones with smaller ones)
-        runPass<PASS_TWO>(baseFolder); //copy rest
+        runZeroPass(baseFolder); //first process file moves
+
+        if (threadCount_ > 1) //delete items and copy new files in parallel: all other operations remain sequential
+        {
+            runPassAsync<PASS_ONE>(baseFolder); //delete files (or overwrite big ones with smaller ones)
+            runPassAsync<PASS_TWO>(baseFolder); //copy rest
+        }
+        else
+        {
+            runPass<PASS_ONE>(baseFolder); //delete files (or overwrite big ones with smaller ones)
+            runPass<PASS_TWO>(baseFolder); //copy rest
+        }
     }
 
 private:
@@ -662,6 +644,15 @@ private:
     void runZeroPass(HierarchyObject& hierObj);
     template <PassId pass>
     void runPass(HierarchyObject& hierObj);
+    template <PassId pass>
+    void runPassAsync(BaseFolderPair& baseFolder);
+
+    //run on worker thread if available, in which case "onSuccess" is called later in the context of the main thread
+    template <class Function, class Completion>
+    void runDeletion(Function removeItem /*throw FileError*/, Completion onSuccess) { runDeletion(removeItem, onSuccess, [] {}); }
+    //"onAsyncFailure": called in the context of the main thread if removal on a worker thread failed and the error was ignored
+    template <class Function, class Completion, class Failure>
+    void runDeletion(Function removeItem /*throw FileError*/, Completion onSuccess, Failure onAsyncFailure);
 
     void synchronizeFile(FilePair& file);
     template <SelectedSide side> void synchronizeFileInt(FilePair& file, SyncOperation syncOp);
@@ -683,8 +674,16 @@ private:
 
     AFS::FileAttribAfterCopy copyFileWithCallback(const AbstractPath& sourcePath,
                                                   const AbstractPath& targetPath,
+                                                  bool deltaCopy, //update existing target by writing changed blocks only
                                                   const std::function<void()>& onDeleteTargetFile,
-                                                  const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus) const; //throw FileError
+                                                  const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus,
+                                                  ProcessCallback& callback) const; //throw FileError
+
+    //thread-safe: does not access FileSystemObject hierarchy; returns NoValue() if source file was deleted meanwhile
+    Opt<AFS::FileAttribAfterCopy> copyNewFile(const AbstractPath& sourcePath,
+                                              const AbstractPath& targetPath,
+                                              std::int64_t fileSize,
+                                              ProcessCallback& callback) const; //throw FileError
 
     template <SelectedSide side>
     DeletionHandling& getDelHandling();
@@ -692,6 +691,7 @@ private:
     ProcessCallback& procCallback_;
 #ifdef ZEN_WIN
     shadow::ShadowCopy* shadowCopyHandler_; //optional!
+    std::mutex& lockShadowCopy_; //shadowCopyHandler_ is not thread-safe: shared by all folder pairs
 #endif
     DeletionHandling& delHandlingLeft_;
     DeletionHandling& delHandlingRight_;
@@ -699,6 +699,13 @@ private:
     const bool verifyCopiedFiles_;
     const bool copyFilePermissions_;
     const bool failSafeFileCopy_;
+    const bool cloneFiles_;
+    const bool deltaCopy_;
+    const bool deltaCopyInPlace_; //false if the scan snapshot is used: updating a file in place doesn't change its parent folder's modification time
+    const size_t threadCount_;
+
+    AsyncSyncTasks* asyncTasks_ = nullptr; //only set during PASS_ONE and PASS_TWO if threadCount_ > 1
+    std::vector<FolderPair*> foldersDeletionFailed_; //asynchronous folder deletion failed: sub items still need to be processed
 
     //preload status texts
     const std::wstring txtCreatingFile     {_("Creating file %x"         )};
@@ -792,7 +799,7 @@ void SynchronizeFolderPair::prepare2StepMove(FilePair& sourceObj,
                                      sourceObj.isFollowedSymlink<side>());
 
     FilePair& tempFile = sourceObj.base().addSubFile<side>(afterLast(sourceRelPathTmp, FILE_NAME_SEPARATOR, IF_MISSING_RETURN_ALL), descrSource);
-    static_assert(IsSameType<FixedList<FilePair>, HierarchyObject::FileList>::value,
+    static_assert(IsSameType<HierarchyList<FilePair>, HierarchyObject::FileList>::value,
                   "ATTENTION: we're adding to the file list WHILE looping over it! This is only working because FixedList iterators are not invalidated by insertion!");
     sourceObj.removeObject<side>(); //remove only *after* evaluating "sourceObj, side"!
 
@@ -1083,7 +1090,60 @@ void SynchronizeFolderPair::runPass(HierarchyObject& hierObj)
         if (pass == this->getPass(folder))
             tryReportingError([&] { synchronizeFolder(folder); }, procCallback_); //throw X?
 
-        this->runPass<pass>(folder); //recurse
+        //asynchronous folder deletion: sub items are removed together with the folder => don't touch them while the deletion is running! (failure: see runPassAsync())
+        if (!(asyncTasks_ && pass == PASS_ONE && this->getPass(folder) == PASS_ONE))
+            this->runPass<pass>(folder); //recurse
+    }
+}
+
+
+template <SynchronizeFolderPair::PassId pass>
+void SynchronizeFolderPair::runPassAsync(BaseFolderPair& baseFolder)
+{
+    AsyncSyncTasks asyncTasks(threadCount_, procCallback_);
+    asyncTasks_ = &asyncTasks;
+    ZEN_ON_SCOPE_EXIT(asyncTasks_ = nullptr);
+
+    runPass<pass>(baseFolder);
+    asyncTasks.waitUntilDone(); //throw X; complete each pass before starting the next: e.g. symlink deleted in first pass is replaced by file in second
+
+    //runPass() skipped the sub items of folders deleted asynchronously: process them one by one if the deletion failed (same as synchronous runPass())
+    while (!foldersDeletionFailed_.empty())
+    {
+        std::vector<FolderPair*> folders;
+        folders.swap(foldersDeletionFailed_);
+
+        for (FolderPair* folder : folders)
+            runPass<pass>(*folder);
+        asyncTasks.waitUntilDone(); //throw X
+    }
+}
+
+
+template <class Function, class Completion, class Failure>
+void SynchronizeFolderPair::runDeletion(Function removeItem, Completion onSuccess, Failure onAsyncFailure) //throw FileError
+{
+    if (asyncTasks_)
+    {
+        auto success = std::make_shared<bool>(false);
+
+        asyncTasks_->addTask([removeItem, success](ProcessCallback& workerCallback) //throw ThreadInterruption
+        {
+            if (!tryReportingError([&] { removeItem(workerCallback); }, workerCallback)) //throw ThreadInterruption
+                *success = true;
+        },
+        [onSuccess, onAsyncFailure, success] //noexcept
+        {
+            if (*success)
+                onSuccess();
+            else
+                onAsyncFailure();
+        }); //throw X
+    }
+    else
+    {
+        removeItem(procCallback_); //throw FileError
+        onSuccess();
     }
 }
 
@@ -1149,44 +1209,49 @@ void SynchronizeFolderPair::synchronizeFileInt(FilePair& file, SyncOperation syn
                     return; //if parent directory creation failed, there's no reason to show more errors!
 
             //can't use "getAbstractPath<sideTrg>()" as file name is not available!
+            const AbstractPath sourcePath = file.getAbstractPath<sideSrc>();
             const AbstractPath targetPath = AFS::appendRelPath(file.base().getAbstractPath<sideTrg>(), file.getRelativePath<sideSrc>());
+            const std::int64_t fileSize   = file.getFileSize<sideSrc>();
             reportInfo(txtCreatingFile, AFS::getDisplayPath(targetPath));
 
-            StatisticsReporter statReporter(1, file.getFileSize<sideSrc>(), procCallback_);
-            try
+            auto updateFilePair = [&file](const Opt<AFS::FileAttribAfterCopy>& newAttr) //context of main thread
             {
-                auto onNotifyCopyStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
-
-                const AFS::FileAttribAfterCopy newAttr = copyFileWithCallback(file.getAbstractPath<sideSrc>(),
-                                                                              targetPath,
-                                                                              nullptr, //no target to delete
-                                                                              onNotifyCopyStatus); //throw FileError
-                statReporter.reportDelta(1, 0);
+                if (newAttr)
+                    file.setSyncedTo<sideTrg>(file.getItemName<sideSrc>(), newAttr->fileSize,
+                                              newAttr->modificationTime, //target time set from source
+                                              newAttr->modificationTime,
+                                              newAttr->targetFileId,
+                                              newAttr->sourceFileId,
+                                              false, file.isFollowedSymlink<sideSrc>());
+                else
+                    //source deleted meanwhile...nothing was done (logical point of view!)
+                    file.removeObject<sideSrc>(); //remove only *after* evaluating "file, sideSrc"!
+            };
 
-                //update FilePair
-                file.setSyncedTo<sideTrg>(file.getItemName<sideSrc>(), newAttr.fileSize,
-                                          newAttr.modificationTime, //target time set from source
-                                          newAttr.modificationTime,
-                                          newAttr.targetFileId,
-                                          newAttr.sourceFileId,
-                                          false, file.isFollowedSymlink<sideSrc>());
-            }
-            catch (FileError&)
+            if (asyncTasks_)
             {
-                warn_static("still an error if base dir is missing!")
-                //  const Zstring basedir = beforeLast(file.getBaseDirPf<side>(), FILE_NAME_SEPARATOR); //what about C:\ ???
-                //if (!dirExists(basedir) ||
+                struct CopyResult
+                {
+                    bool success = false;
+                    Opt<AFS::FileAttribAfterCopy> newAttr;
+                };
+                auto result = std::make_shared<CopyResult>();
 
+                asyncTasks_->addTask([this, sourcePath, targetPath, fileSize, result](ProcessCallback& workerCallback) //throw ThreadInterruption
+                {
+                    workerCallback.reportStatus(replaceCpy(txtCreatingFile, L"%x", fmtPath(AFS::getDisplayPath(targetPath))));
 
-                if (!AFS::somethingExists(file.getAbstractPath<sideSrc>())) //do not check on type (symlink, file, folder) -> if there is a type change, FFS should error out!
+                    if (!tryReportingError([&] { result->newAttr = copyNewFile(sourcePath, targetPath, fileSize, workerCallback); }, workerCallback)) //throw ThreadInterruption
+                        result->success = true;
+                },
+                [updateFilePair, result] //noexcept
                 {
-                    //source deleted meanwhile...nothing was done (logical point of view!)
-                    file.removeObject<sideSrc>(); //remove only *after* evaluating "file, sideSrc"!
-                }
-                else
-                    throw;
+                    if (result->success)
+                        updateFilePair(result->newAttr);
+                }); //throw X
             }
-            statReporter.reportFinished();
+            else
+                updateFilePair(copyNewFile(sourcePath, targetPath, fileSize, procCallback_)); //throw FileError
         }
         break;
 
@@ -1194,18 +1259,24 @@ void SynchronizeFolderPair::synchronizeFileInt(FilePair& file, SyncOperation syn
         case SO_DELETE_RIGHT:
             reportInfo(getDelHandling<sideTrg>().getTxtRemovingFile(), AFS::getDisplayPath(file.getAbstractPath<sideTrg>()));
             {
-                StatisticsReporter statReporter(1, 0, procCallback_);
+                DeletionHandling& delHandling = getDelHandling<sideTrg>();
+                const AbstractPath filePath   = file.getAbstractPath<sideTrg>();
+                const Zstring      relPath    = file.getPairRelativePath();
 
-                auto onNotifyItemDeletion = [&] { statReporter.reportDelta(1, 0); };
-                auto onNotifyCopyStatus   = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
+                runDeletion([&delHandling, filePath, relPath](ProcessCallback& callback) //throw FileError
+                {
+                    StatisticsReporter statReporter(1, 0, callback);
 
-                getDelHandling<sideTrg>().removeFileWithCallback(file.getAbstractPath<sideTrg>(), file.getPairRelativePath(), onNotifyItemDeletion, onNotifyCopyStatus); //throw FileError
+                    auto onNotifyItemDeletion = [&] { statReporter.reportDelta(1, 0); };
+                    auto onNotifyCopyStatus   = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
 
-                warn_static("what if item not found? still an error if base dir is missing; externally deleted otherwise!")
+                    delHandling.removeFileWithCallback(filePath, relPath, onNotifyItemDeletion, onNotifyCopyStatus); //throw FileError
 
-                file.removeObject<sideTrg>(); //update FilePair
+                    warn_static("what if item not found? still an error if base dir is missing; externally deleted otherwise!")
 
-                statReporter.reportFinished();
+                    statReporter.reportFinished();
+                },
+                [&file] { file.removeObject<sideTrg>(); }); //update FilePair; throw FileError
             }
             break;
 
@@ -1277,10 +1348,17 @@ void SynchronizeFolderPair::synchronizeFileInt(FilePair& file, SyncOperation syn
                     reportStatus(txtOverwritingFile, AFS::getDisplayPath(targetPathResolvedOld)); //restore status text copy file
             };
 
+            //delta copy: without fail-safe file copy the target is updated in place => old version can't be moved to recycler/versioning
+            const bool deltaCopy = deltaCopy_ &&
+                                   file.getFileSize<sideSrc>() >= DELTA_COPY_MIN_FILE_SIZE &&
+                                   (failSafeFileCopy_ || (deltaCopyInPlace_ && getDelHandling<sideTrg>().getDeletionPolicy() == DeletionPolicy::PERMANENT));
+
             const AFS::FileAttribAfterCopy newAttr = copyFileWithCallback(file.getAbstractPath<sideSrc>(),
                                                                           targetPathResolvedNew,
+                                                                          deltaCopy,
                                                                           onDeleteTargetFile,
-                                                                          onNotifyCopyStatus); //throw FileError
+                                                                          onNotifyCopyStatus,
+                                                                          procCallback_); //throw FileError
             statReporter.reportDelta(1, 0); //we model "delete + copy" as ONE logical operation
 
             //update FilePair
@@ -1400,16 +1478,22 @@ void SynchronizeFolderPair::synchronizeLinkInt(SymlinkPair& symlink, SyncOperati
         case SO_DELETE_RIGHT:
             reportInfo(getDelHandling<sideTrg>().getTxtRemovingSymLink(), AFS::getDisplayPath(symlink.getAbstractPath<sideTrg>()));
             {
-                StatisticsReporter statReporter(1, 0, procCallback_);
+                DeletionHandling& delHandling = getDelHandling<sideTrg>();
+                const AbstractPath linkPath   = symlink.getAbstractPath<sideTrg>();
+                const Zstring      relPath    = symlink.getPairRelativePath();
 
-                auto onNotifyItemDeletion = [&] { statReporter.reportDelta(1, 0); };
-                auto onNotifyCopyStatus   = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
+                runDeletion([&delHandling, linkPath, relPath](ProcessCallback& callback) //throw FileError
+                {
+                    StatisticsReporter statReporter(1, 0, callback);
 
-                getDelHandling<sideTrg>().removeLinkWithCallback(symlink.getAbstractPath<sideTrg>(), symlink.getPairRelativePath(), onNotifyItemDeletion, onNotifyCopyStatus); //throw FileError
+                    auto onNotifyItemDeletion = [&] { statReporter.reportDelta(1, 0); };
+                    auto onNotifyCopyStatus   = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
 
-                symlink.removeObject<sideTrg>(); //update SymlinkPair
+                    delHandling.removeLinkWithCallback(linkPath, relPath, onNotifyItemDeletion, onNotifyCopyStatus, callback); //throw FileError
 
-                statReporter.reportFinished();
+                    statReporter.reportFinished();
+                },
+                [&symlink] { symlink.removeObject<sideTrg>(); }); //update SymlinkPair; throw FileError
             }
             break;
 
@@ -1422,7 +1506,7 @@ void SynchronizeFolderPair::synchronizeLinkInt(SymlinkPair& symlink, SyncOperati
                 auto onNotifyCopyStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
 
                 //reportStatus(getDelHandling<sideTrg>().getTxtRemovingSymLink(), AFS::getDisplayPath(symlink.getAbstractPath<sideTrg>()));
-                getDelHandling<sideTrg>().removeLinkWithCallback(symlink.getAbstractPath<sideTrg>(), symlink.getPairRelativePath(), [] {}, onNotifyCopyStatus); //throw FileError
+                getDelHandling<sideTrg>().removeLinkWithCallback(symlink.getAbstractPath<sideTrg>(), symlink.getPairRelativePath(), [] {}, onNotifyCopyStatus, procCallback_); //throw FileError
 
                 //symlink.removeObject<sideTrg>(); -> "symlink, sideTrg" evaluated below!
 
@@ -1545,20 +1629,33 @@ void SynchronizeFolderPair::synchronizeFolderInt(FolderPair& folder, SyncOperati
             reportInfo(getDelHandling<sideTrg>().getTxtRemovingDir(), AFS::getDisplayPath(folder.getAbstractPath<sideTrg>()));
             {
                 const SyncStatistics subStats(folder); //counts sub-objects only!
+                const int          itemsExpected = 1 + getCUD(subStats);
+                const std::int64_t bytesExpected = subStats.getDataToProcess();
 
-                StatisticsReporter statReporter(1 + getCUD(subStats), subStats.getDataToProcess(), procCallback_);
+                DeletionHandling& delHandling = getDelHandling<sideTrg>();
+                const AbstractPath folderPath = folder.getAbstractPath<sideTrg>();
+                const Zstring      relPath    = folder.getPairRelativePath();
 
-                auto onNotifyItemDeletion = [&] { statReporter.reportDelta(1, 0); };
-                auto onNotifyCopyStatus   = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
+                //children are deleted together with their folder: ordering constraints within the folder are handled by DeletionHandling
+                runDeletion([&delHandling, folderPath, relPath, itemsExpected, bytesExpected](ProcessCallback& callback) //throw FileError
+                {
+                    StatisticsReporter statReporter(itemsExpected, bytesExpected, callback);
 
-                getDelHandling<sideTrg>().removeDirWithCallback(folder.getAbstractPath<sideTrg>(), folder.getPairRelativePath(), onNotifyItemDeletion, onNotifyCopyStatus); //throw FileError
+                    auto onNotifyItemDeletion = [&] { statReporter.reportDelta(1, 0); };
+                    auto onNotifyCopyStatus   = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
 
-                folder.refSubFiles  ().clear(); //
-                folder.refSubLinks  ().clear(); //update FolderPair
-                folder.refSubFolders().clear(); //
-                folder.removeObject<sideTrg>(); //
+                    delHandling.removeDirWithCallback(folderPath, relPath, onNotifyItemDeletion, onNotifyCopyStatus, callback); //throw FileError
 
-                statReporter.reportFinished();
+                    statReporter.reportFinished();
+                },
+                [&folder] //throw FileError
+                {
+                    folder.refSubFiles  ().clear(); //
+                    folder.refSubLinks  ().clear(); //update FolderPair
+                    folder.refSubFolders().clear(); //
+                    folder.removeObject<sideTrg>(); //
+                },
+                [this, &folder] { foldersDeletionFailed_.push_back(&folder); }); //runPassAsync() processes the sub items later
             }
             break;
 
@@ -1682,14 +1779,18 @@ void verifyFiles(const AbstractPath& sourcePath, const AbstractPath& targetPath,
 
 AFS::FileAttribAfterCopy SynchronizeFolderPair::copyFileWithCallback(const AbstractPath& sourcePath,  //throw FileError
                                                                      const AbstractPath& targetPath,
+                                                                     bool deltaCopy,
                                                                      const std::function<void()>& onDeleteTargetFile,
-                                                                     const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus) const //returns current attributes of source file
+                                                                     const std::function<void(std::int64_t bytesDelta)>& onNotifyCopyStatus,
+                                                                     ProcessCallback& callback) const //returns current attributes of source file
 {
-    auto copyOperation = [this, &targetPath, &onDeleteTargetFile, &onNotifyCopyStatus](const AbstractPath& sourcePathTmp)
+    auto copyOperation = [this, &targetPath, deltaCopy, &onDeleteTargetFile, &onNotifyCopyStatus, &callback](const AbstractPath& sourcePathTmp)
     {
         AFS::FileAttribAfterCopy newAttr = AFS::copyFileTransactional(sourcePathTmp, targetPath, //throw FileError, ErrorFileLocked
                                                                       copyFilePermissions_,
                                                                       failSafeFileCopy_,
+                                                                      cloneFiles_,
+                                                                      deltaCopy,
                                                                       onDeleteTargetFile,
                                                                       onNotifyCopyStatus);
 
@@ -1698,8 +1799,8 @@ AFS::FileAttribAfterCopy SynchronizeFolderPair::copyFileWithCallback(const Abstr
         {
             ZEN_ON_SCOPE_FAIL( AFS::removeFile(targetPath); ); //delete target if verification fails
 
-            procCallback_.reportInfo(replaceCpy(txtVerifying, L"%x", fmtPath(AFS::getDisplayPath(targetPath))));
-            verifyFiles(sourcePathTmp, targetPath, [&](std::int64_t bytesDelta) { procCallback_.requestUiRefresh(); }); //throw FileError
+            callback.reportInfo(replaceCpy(txtVerifying, L"%x", fmtPath(AFS::getDisplayPath(targetPath))));
+            verifyFiles(sourcePathTmp, targetPath, [&](std::int64_t bytesDelta) { callback.requestUiRefresh(); }); //throw FileError
         }
         //#################### /Verification #############################
 
@@ -1719,10 +1820,11 @@ AFS::FileAttribAfterCopy SynchronizeFolderPair::copyFileWithCallback(const Abstr
                 Zstring nativeShadowPath; //contains prefix: E.g. "\\?\GLOBALROOT\Device\HarddiskVolumeShadowCopy1\Program Files\FFS\sample.dat"
                 try
                 {
+                    std::lock_guard<std::mutex> dummy(lockShadowCopy_);
                     nativeShadowPath = shadowCopyHandler_->makeShadowCopy(*nativeSourcePath, //throw FileError
                                                                           [&](const Zstring& volumeName)
                     {
-                        procCallback_.reportStatus(replaceCpy(_("Creating a Volume Shadow Copy for %x..."), L"%x", fmtPath(volumeName)));
+                        callback.reportStatus(replaceCpy(_("Creating a Volume Shadow Copy for %x..."), L"%x", fmtPath(volumeName)));
                     });
                 }
                 catch (const FileError& e2) //enhance error message
@@ -1741,6 +1843,41 @@ AFS::FileAttribAfterCopy SynchronizeFolderPair::copyFileWithCallback(const Abstr
 #endif
 }
 
+
+Opt<AFS::FileAttribAfterCopy> SynchronizeFolderPair::copyNewFile(const AbstractPath& sourcePath, //throw FileError
+                                                                 const AbstractPath& targetPath,
+                                                                 std::int64_t fileSize,
+                                                                 ProcessCallback& callback) const
+{
+    Opt<AFS::FileAttribAfterCopy> newAttr;
+
+    StatisticsReporter statReporter(1, fileSize, callback);
+    try
+    {
+        auto onNotifyCopyStatus = [&](std::int64_t bytesDelta) { statReporter.reportDelta(0, bytesDelta); };
+
+        newAttr = copyFileWithCallback(sourcePath,
+                                       targetPath,
+                                       false /*deltaCopy*/,
+                                       nullptr, //no target to delete
+                                       onNotifyCopyStatus,
+                                       callback); //throw FileError
+        statReporter.reportDelta(1, 0);
+    }
+    catch (FileError&)
+    {
+        warn_static("still an error if base dir is missing!")
+        //  const Zstring basedir = beforeLast(file.getBaseDirPf<side>(), FILE_NAME_SEPARATOR); //what about C:\ ???
+        //if (!dirExists(basedir) ||
+
+        if (AFS::somethingExists(sourcePath)) //do not check on type (symlink, file, folder) -> if there is a type change, FFS should error out!
+            throw;
+        //else: source deleted meanwhile...nothing was done (logical point of view!)
+    }
+    statReporter.reportFinished();
+    return newAttr;
+}
+
 //###########################################################################################
 
 template <SelectedSide side>
@@ -1824,6 +1961,181 @@ enum class FolderPairJobType
     ALREADY_IN_SYNC,
     SKIP,
 };
+
+
+//synchronize folder pairs without common folders at the same time, each on its own thread; the sync threads of all running folder pairs are limited by "threadsTotal"
+//statistics and status texts of all folder pairs are forwarded right away, but log messages and errors of only one folder pair at a time => the log stays grouped by folder pair
+//CAVEAT: the main thread must not access the FileSystemObject hierarchy while folder pairs are running!
+class ParallelFolderPairs
+{
+public:
+    using SyncJob = std::function<void(ProcessCallback& workerCallback)>; //throw ThreadInterruption
+
+    ParallelFolderPairs(size_t threadsTotal, ProcessCallback& callback) : threadsTotal_(threadsTotal), callback_(callback)
+    {
+        setParallelHierarchyAccess(true); //no worker threads yet
+    }
+
+    ~ParallelFolderPairs()
+    {
+        for (const std::unique_ptr<Job>& job : jobs)
+            if (job->worker.joinable())
+                job->worker.interrupt(); //interrupt all at once first, then join
+        for (const std::unique_ptr<Job>& job : jobs)
+            if (job->worker.joinable())
+                job->worker.join();
+
+        setParallelHierarchyAccess(false); //all worker threads joined
+    }
+
+    //"dependencies": indexes of previously added folder pairs which must be finished before this one is started
+    void addFolderPair(SyncJob&& syncJob, size_t threadCount, const std::vector<size_t>& dependencies)
+    {
+        auto job = std::make_unique<Job>();
+        job->syncJob      = std::move(syncJob);
+        job->threadCount  = std::max<size_t>(threadCount, 1);
+        job->dependencies = dependencies;
+        jobs.push_back(std::move(job));
+    }
+
+    //context of main thread
+    void run() //throw X
+    {
+        for (;;)
+        {
+            //start folder pairs in order: overtake folder pairs waiting for dependencies, but not those waiting for free threads
+            for (const std::unique_ptr<Job>& job : jobs)
+                if (job->status == JobStatus::WAITING &&
+                    std::all_of(job->dependencies.begin(), job->dependencies.end(), [&](size_t i) { return jobs[i]->status == JobStatus::FINISHED; }))
+                {
+                    if (threadsActive > 0 && threadsActive + job->threadCount > threadsTotal_)
+                        break;
+                    startJob(*job);
+                }
+
+            //forward log messages and errors of the log owner only, other folder pairs continue until they need to report an error
+            for (;;)
+            {
+                if (!logOwner)
+                    logOwner = getNextLogOwner();
+                if (!logOwner)
+                    return; //all folder pairs finished and logged
+
+                const bool finished = logOwner->status == JobStatus::FINISHED; //evaluate *before* processRequests(): no more messages after worker was joined
+                logOwner->acb.processRequests(callback_); //throw X
+                if (!finished)
+                    break;
+                logOwner->logged = true;
+                logOwner = nullptr;
+            }
+
+            for (const std::unique_ptr<Job>& job : jobs)
+                if (job.get() != logOwner)
+                    job->acb.forwardStatistics(callback_); //noexcept
+
+            std::vector<Job*> jobsDone;
+            {
+                std::unique_lock<std::mutex> dummy(lockJobsDone);
+                conditionJobDone.wait_for(dummy, std::chrono::milliseconds(UI_UPDATE_INTERVAL / 2), [this] { return !jobsDone_.empty(); });
+                jobsDone.swap(jobsDone_);
+            }
+            for (Job* job : jobsDone)
+            {
+                job->worker.join();
+                job->status = JobStatus::FINISHED;
+                threadsActive -= job->threadCount;
+            }
+
+            reportStatus(); //throw X
+        }
+    }
+
+private:
+    ParallelFolderPairs           (const ParallelFolderPairs&) = delete;
+    ParallelFolderPairs& operator=(const ParallelFolderPairs&) = delete;
+
+    enum class JobStatus
+    {
+        WAITING,
+        RUNNING,
+        FINISHED, //worker thread joined
+    };
+
+    struct Job
+    {
+        SyncJob syncJob;
+        size_t threadCount = 1;
+        std::vector<size_t> dependencies;
+
+        JobStatus status = JobStatus::WAITING;
+        bool logged = false; //all log messages forwarded
+        AsyncProcessCallback acb;
+        InterruptibleThread worker;
+    };
+
+    void startJob(Job& job)
+    {
+        job.worker = InterruptibleThread([this, &job]
+        {
+#ifdef ZEN_WIN
+            setCurrentThreadName("Sync Folder Pair");
+#endif
+            WorkerProcessCallback workerCallback(job.acb);
+            job.syncJob(workerCallback); //throw ThreadInterruption
+            {
+                std::lock_guard<std::mutex> dummy(lockJobsDone);
+                jobsDone_.push_back(&job);
+            }
+            conditionJobDone.notify_all();
+        });
+        job.status = JobStatus::RUNNING;
+        threadsActive += job.threadCount;
+    }
+
+    //prefer finished folder pairs: their messages can be logged in one go
+    //else the first running one, or the first waiting one which can always be started while no others are running => no deadlock on errors
+    Job* getNextLogOwner() const
+    {
+        for (JobStatus status : { JobStatus::FINISHED, JobStatus::RUNNING, JobStatus::WAITING })
+            for (const std::unique_ptr<Job>& job : jobs)
+                if (job->status == status && !job->logged)
+                    return job.get();
+        return nullptr;
+    }
+
+    void reportStatus() //throw X
+    {
+        std::wstring statusText = logOwner && logOwner->status == JobStatus::RUNNING ? logOwner->acb.getCurrentStatus() : std::wstring();
+
+        int jobsRunning = 0;
+        for (const std::unique_ptr<Job>& job : jobs)
+            if (job->status == JobStatus::RUNNING)
+            {
+                ++jobsRunning;
+                if (statusText.empty())
+                    statusText = job->acb.getCurrentStatus();
+            }
+
+        if (jobsRunning >= 2 && !statusText.empty())
+            statusText += L" [" + replaceCpy(_P("1 folder pair", "%x folder pairs", jobsRunning), L"%x", numberTo<std::wstring>(jobsRunning)) + L"]";
+
+        if (!statusText.empty())
+            callback_.reportStatus(statusText); //throw X
+        else
+            callback_.requestUiRefresh(); //throw X
+    }
+
+    const size_t threadsTotal_;
+    ProcessCallback& callback_;
+
+    std::vector<std::unique_ptr<Job>> jobs;
+    size_t threadsActive = 0;
+    Job* logOwner = nullptr;
+
+    std::mutex lockJobsDone;
+    std::condition_variable conditionJobDone;
+    std::vector<Job*> jobsDone_; //worker threads finished, but not yet joined
+};
 }
 
 
@@ -1833,6 +2145,13 @@ void zen::synchronize(const TimeComp& timeStamp,
                       bool copyLockedFiles,
                       bool copyFilePermissions,
                       bool failSafeFileCopy,
+                      bool cloneFiles,
+                      bool deltaCopy,
+                      bool scanSnapshot,
+                      size_t syncThreadsPerFolderPair,
+                      size_t syncThreadsTotal,
+                      int versionCountLimit,
+                      int versionMaxAgeDays,
                       bool runWithBackgroundPriority,
                       int folderAccessTimeout,
                       const std::vector<FolderPairSyncCfg>& syncConfig,
@@ -1889,6 +2208,11 @@ void zen::synchronize(const TimeComp& timeStamp,
         callback.reportInfo(e.toString()); //may throw!
     }
 
+    //resolve versioning folder phrases in the context of the main thread: getResolvedFilePath() is not thread-safe!
+    std::vector<AbstractPath> versioningFolderPaths;
+    for (const FolderPairSyncCfg& folderPairCfg : syncConfig)
+        versioningFolderPaths.push_back(createAbstractPath(folderPairCfg.versioningFolderPhrase));
+
     //-------------------execute basic checks all at once before starting sync--------------------------------------
 
     std::vector<FolderPairJobType> jobType(folderCmp.size(), FolderPairJobType::PROCESS); //folder pairs may be skipped after fatal errors were found
@@ -2057,7 +2381,7 @@ void zen::synchronize(const TimeComp& timeStamp,
                 }
                 catch (FileError&) {} //for warning only => no need for tryReportingError()
         };
-        const std::pair<std::int64_t, std::int64_t> spaceNeeded = MinimumDiskSpaceNeeded::calculate(*j);
+        const std::pair<std::int64_t, std::int64_t> spaceNeeded = getMinimumDiskSpaceNeeded(*j);
         checkSpace(j->getAbstractPath< LEFT_SIDE>(), spaceNeeded.first);
         checkSpace(j->getAbstractPath<RIGHT_SIDE>(), spaceNeeded.second);
 
@@ -2163,127 +2487,188 @@ void zen::synchronize(const TimeComp& timeStamp,
 #ifdef ZEN_WIN
     //shadow copy buffer: per sync-instance, not folder pair
     std::unique_ptr<shadow::ShadowCopy> shadowCopyHandler;
+    std::mutex lockShadowCopy;
     if (copyLockedFiles)
         shadowCopyHandler = std::make_unique<shadow::ShadowCopy>();
 #endif
 
-    try
+    //synchronize a single folder pair: runs on a worker thread if folder pairs are synchronized in parallel => use "callback" parameter only!
+    auto synchronizeFolderPair = [&](size_t folderIndex, ProcessCallback& callback)
     {
-        //loop through all directory pairs
-        for (auto j = begin(folderCmp); j != end(folderCmp); ++j)
+        BaseFolderPair& baseFolder = *folderCmp[folderIndex];
+        const FolderPairSyncCfg& folderPairCfg  = syncConfig     [folderIndex];
+        const SyncStatistics&    folderPairStat = folderPairStats[folderIndex];
+
+        //------------------------------------------------------------------------------------------
+        callback.reportInfo(_("Synchronizing folder pair:") + L" [" + getVariantName(folderPairCfg.syncVariant_) + L"]\n" +
+                            L"    " + AFS::getDisplayPath(baseFolder.getAbstractPath< LEFT_SIDE>()) + L"\n" +
+                            L"    " + AFS::getDisplayPath(baseFolder.getAbstractPath<RIGHT_SIDE>()));
+        //------------------------------------------------------------------------------------------
+
+        //checking a second time: (a long time may have passed since the intro checks!)
+        if (baseFolderDrop< LEFT_SIDE>(baseFolder, folderAccessTimeout, callback) ||
+            baseFolderDrop<RIGHT_SIDE>(baseFolder, folderAccessTimeout, callback))
+            return;
+
+        //create base folders if not yet existing
+        if (folderPairStat.createCount() > 0 || folderPairCfg.saveSyncDB_) //else: temporary network drop leading to deletions already caught by "sourceFolderMissing" check!
+            if (!createBaseFolder< LEFT_SIDE>(baseFolder, callback) || //+ detect temporary network drop!!
+                !createBaseFolder<RIGHT_SIDE>(baseFolder, callback))   //
+                return;
+
+        //------------------------------------------------------------------------------------------
+        //execute synchronization recursively
+
+        //update synchronization database in case of errors:
+        ZEN_ON_SCOPE_FAIL
+        (
+            try
         {
-            const size_t folderIndex = j - begin(folderCmp);
-            const FolderPairSyncCfg& folderPairCfg  = syncConfig     [folderIndex];
-            const SyncStatistics&    folderPairStat = folderPairStats[folderIndex];
+            if (folderPairCfg.saveSyncDB_)
+                zen::saveLastSynchronousState(baseFolder, nullptr);
+        } //throw FileError
+        catch (FileError&) {}
+        );
 
-            if (jobType[folderIndex] == FolderPairJobType::SKIP) //folder pairs may be skipped after fatal errors were found
-                continue;
+        if (jobType[folderIndex] == FolderPairJobType::PROCESS)
+        {
+            //guarantee removal of invalid entries (where element is empty on both sides)
+            ZEN_ON_SCOPE_EXIT(BaseFolderPair::removeEmpty(baseFolder));
 
-            //------------------------------------------------------------------------------------------
-            callback.reportInfo(_("Synchronizing folder pair:") + L" [" + getVariantName(folderPairCfg.syncVariant_) + L"]\n" +
-                                L"    " + AFS::getDisplayPath(j->getAbstractPath< LEFT_SIDE>()) + L"\n" +
-                                L"    " + AFS::getDisplayPath(j->getAbstractPath<RIGHT_SIDE>()));
-            //------------------------------------------------------------------------------------------
+            bool copyPermissionsFp = false;
+            tryReportingError([&]
+            {
+                copyPermissionsFp = copyFilePermissions && //copy permissions only if asked for and supported by *both* sides!
+                !AFS::isNullPath(baseFolder.getAbstractPath< LEFT_SIDE>()) && //scenario: directory selected on one side only
+                !AFS::isNullPath(baseFolder.getAbstractPath<RIGHT_SIDE>()) && //
+                AFS::supportPermissionCopy(baseFolder.getAbstractPath<LEFT_SIDE>(), baseFolder.getAbstractPath<RIGHT_SIDE>()); //throw FileError
+            }, callback); //throw X?
 
-            //checking a second time: (a long time may have passed since the intro checks!)
-            if (baseFolderDrop< LEFT_SIDE>(*j, folderAccessTimeout, callback) ||
-                baseFolderDrop<RIGHT_SIDE>(*j, folderAccessTimeout, callback))
-                continue;
 
-            //create base folders if not yet existing
-            if (folderPairStat.createCount() > 0 || folderPairCfg.saveSyncDB_) //else: temporary network drop leading to deletions already caught by "sourceFolderMissing" check!
-                if (!createBaseFolder< LEFT_SIDE>(*j, callback) || //+ detect temporary network drop!!
-                    !createBaseFolder<RIGHT_SIDE>(*j, callback))   //
-                    continue;
+            auto getEffectiveDeletionPolicy = [&](const AbstractPath& baseFolderPath) -> DeletionPolicy
+            {
+                if (folderPairCfg.handleDeletion == DeletionPolicy::RECYCLER)
+                {
+                    auto it = recyclerSupported.find(baseFolderPath);
+                    if (it != recyclerSupported.end()) //buffer filled during intro checks (but only if deletions are expected)
+                        if (!it->second)
+                            return DeletionPolicy::PERMANENT; //Windows' ::SHFileOperation() will do this anyway, but we have a better and faster deletion routine (e.g. on networks)
+                }
+                return folderPairCfg.handleDeletion;
+            };
 
-            //------------------------------------------------------------------------------------------
-            //execute synchronization recursively
 
-            //update synchronization database in case of errors:
-            ZEN_ON_SCOPE_FAIL
-            (
-                try
-            {
-                if (folderPairCfg.saveSyncDB_)
-                    zen::saveLastSynchronousState(*j, nullptr);
-            } //throw FileError
-            catch (FileError&) {}
-            );
+            DeletionHandling delHandlerL(baseFolder.getAbstractPath<LEFT_SIDE>(),
+                                         getEffectiveDeletionPolicy(baseFolder.getAbstractPath<LEFT_SIDE>()),
+                                         versioningFolderPaths[folderIndex],
+                                         folderPairCfg.versioningStyle_,
+                                         timeStamp,
+                                         versionCountLimit,
+                                         versionMaxAgeDays,
+                                         callback);
 
-            if (jobType[folderIndex] == FolderPairJobType::PROCESS)
-            {
-                //guarantee removal of invalid entries (where element is empty on both sides)
-                ZEN_ON_SCOPE_EXIT(BaseFolderPair::removeEmpty(*j));
+            DeletionHandling delHandlerR(baseFolder.getAbstractPath<RIGHT_SIDE>(),
+                                         getEffectiveDeletionPolicy(baseFolder.getAbstractPath<RIGHT_SIDE>()),
+                                         versioningFolderPaths[folderIndex],
+                                         folderPairCfg.versioningStyle_,
+                                         timeStamp,
+                                         versionCountLimit,
+                                         versionMaxAgeDays,
+                                         callback);
 
-                bool copyPermissionsFp = false;
-                tryReportingError([&]
-                {
-                    copyPermissionsFp = copyFilePermissions && //copy permissions only if asked for and supported by *both* sides!
-                    !AFS::isNullPath(j->getAbstractPath< LEFT_SIDE>()) && //scenario: directory selected on one side only
-                    !AFS::isNullPath(j->getAbstractPath<RIGHT_SIDE>()) && //
-                    AFS::supportPermissionCopy(j->getAbstractPath<LEFT_SIDE>(), j->getAbstractPath<RIGHT_SIDE>()); //throw FileError
-                }, callback); //throw X?
 
+            SynchronizeFolderPair syncFP(callback, verifyCopiedFiles, copyPermissionsFp, failSafeFileCopy, cloneFiles, deltaCopy, !scanSnapshot, syncThreadsPerFolderPair,
+#ifdef ZEN_WIN
+                                         shadowCopyHandler.get(), lockShadowCopy,
+#endif
+                                         delHandlerL, delHandlerR);
+            syncFP.startSync(baseFolder);
+
+            //(try to gracefully) cleanup temporary Recycle bin folders and versioning -> will be done in ~DeletionHandling anyway...
+            tryReportingError([&] { delHandlerL.tryCleanup(true /*allowUserCallback*/); /*throw FileError*/}, callback); //throw X?
+            tryReportingError([&] { delHandlerR.tryCleanup(true                      ); /*throw FileError*/}, callback); //throw X?
+        }
+
+        //(try to gracefully) write database file
+        if (folderPairCfg.saveSyncDB_)
+        {
+            const std::wstring dbUpdateMsg = _("Generating database...");
+
+            callback.reportStatus(dbUpdateMsg);
+            callback.forceUiRefresh();
 
-                auto getEffectiveDeletionPolicy = [&](const AbstractPath& baseFolderPath) -> DeletionPolicy
+            tryReportingError([&]
+            {
+                std::int64_t bytesWritten = 0;
+                zen::saveLastSynchronousState(baseFolder, [&](std::int64_t bytesDelta) //throw FileError
                 {
-                    if (folderPairCfg.handleDeletion == DeletionPolicy::RECYCLER)
-                    {
-                        auto it = recyclerSupported.find(baseFolderPath);
-                        if (it != recyclerSupported.end()) //buffer filled during intro checks (but only if deletions are expected)
-                            if (!it->second)
-                                return DeletionPolicy::PERMANENT; //Windows' ::SHFileOperation() will do this anyway, but we have a better and faster deletion routine (e.g. on networks)
-                    }
-                    return folderPairCfg.handleDeletion;
-                };
+                    bytesWritten += bytesDelta;
+                    callback.reportStatus(dbUpdateMsg + L" (" + filesizeToShortString(bytesWritten) + L")"); //throw X
+                });
+            }, callback); //throw X?
+        }
+    };
 
+    try
+    {
+        //run folder pairs in parallel only if at least two of them fit into the thread limit
+        if (2 * std::max<size_t>(syncThreadsPerFolderPair, 1) <= syncThreadsTotal)
+        {
+            ParallelFolderPairs parallelFolderPairs(syncThreadsTotal, callback);
 
-                DeletionHandling delHandlerL(j->getAbstractPath<LEFT_SIDE>(),
-                                             getEffectiveDeletionPolicy(j->getAbstractPath<LEFT_SIDE>()),
-                                             folderPairCfg.versioningFolderPhrase,
-                                             folderPairCfg.versioningStyle_,
-                                             timeStamp,
-                                             callback);
+            //folder pairs with common folders (including versioning folders) are synchronized one after another, in the configured order
+            auto haveCommonFolder = [](const std::vector<AbstractPath>& folderPaths1, const std::vector<AbstractPath>& folderPaths2)
+            {
+                for (const AbstractPath& folderPath1 : folderPaths1)
+                    for (const AbstractPath& folderPath2 : folderPaths2)
+                        if (AFS::havePathDependency(folderPath1, folderPath2))
+                            return true;
+                return false;
+            };
+            std::vector<std::vector<AbstractPath>> jobFolderPaths;
 
-                DeletionHandling delHandlerR(j->getAbstractPath<RIGHT_SIDE>(),
-                                             getEffectiveDeletionPolicy(j->getAbstractPath<RIGHT_SIDE>()),
-                                             folderPairCfg.versioningFolderPhrase,
-                                             folderPairCfg.versioningStyle_,
-                                             timeStamp,
-                                             callback);
+            for (auto j = begin(folderCmp); j != end(folderCmp); ++j)
+            {
+                const size_t folderIndex = j - begin(folderCmp);
 
+                if (jobType[folderIndex] == FolderPairJobType::SKIP) //folder pairs may be skipped after fatal errors were found
+                    continue;
 
-                SynchronizeFolderPair syncFP(callback, verifyCopiedFiles, copyPermissionsFp, failSafeFileCopy,
-#ifdef ZEN_WIN
-                                             shadowCopyHandler.get(),
-#endif
-                                             delHandlerL, delHandlerR);
-                syncFP.startSync(*j);
+                std::vector<AbstractPath> folderPaths;
+                for (const AbstractPath& folderPath : { j->getAbstractPath<LEFT_SIDE>(), j->getAbstractPath<RIGHT_SIDE>() })
+                    if (!AFS::isNullPath(folderPath))
+                        folderPaths.push_back(folderPath);
 
-                //(try to gracefully) cleanup temporary Recycle bin folders and versioning -> will be done in ~DeletionHandling anyway...
-                tryReportingError([&] { delHandlerL.tryCleanup(true /*allowUserCallback*/); /*throw FileError*/}, callback); //throw X?
-                tryReportingError([&] { delHandlerR.tryCleanup(true                      ); /*throw FileError*/}, callback); //throw X?
-            }
+                if (syncConfig[folderIndex].handleDeletion == DeletionPolicy::VERSIONING &&
+                    !AFS::isNullPath(versioningFolderPaths[folderIndex]))
+                    folderPaths.push_back(versioningFolderPaths[folderIndex]);
 
-            //(try to gracefully) write database file
-            if (folderPairCfg.saveSyncDB_)
-            {
-                const std::wstring dbUpdateMsg = _("Generating database...");
+                std::vector<size_t> dependencies;
+                for (size_t jobIndex = 0; jobIndex < jobFolderPaths.size(); ++jobIndex)
+                    if (haveCommonFolder(folderPaths, jobFolderPaths[jobIndex]))
+                        dependencies.push_back(jobIndex);
 
-                callback.reportStatus(dbUpdateMsg);
-                callback.forceUiRefresh();
+                jobFolderPaths.push_back(folderPaths);
 
-                tryReportingError([&]
+                parallelFolderPairs.addFolderPair([&synchronizeFolderPair, folderIndex](ProcessCallback& workerCallback)
                 {
-                    std::int64_t bytesWritten = 0;
-                    zen::saveLastSynchronousState(*j, [&](std::int64_t bytesDelta) //throw FileError
+                    try
                     {
-                        bytesWritten += bytesDelta;
-                        callback.reportStatus(dbUpdateMsg + L" (" + filesizeToShortString(bytesWritten) + L")"); //throw X
-                    });
-                }, callback); //throw X?
+                        synchronizeFolderPair(folderIndex, workerCallback); //throw ThreadInterruption
+                    }
+                    catch (const std::exception& e)
+                    {
+                        workerCallback.reportFatalError(utfCvrtTo<std::wstring>(e.what()));
+                    }
+                }, syncThreadsPerFolderPair, dependencies);
             }
+
+            parallelFolderPairs.run(); //throw X
         }
+        else
+            for (size_t folderIndex = 0; folderIndex < folderCmp.size(); ++folderIndex)
+                if (jobType[folderIndex] != FolderPairJobType::SKIP) //folder pairs may be skipped after fatal errors were found
+                    synchronizeFolderPair(folderIndex, callback);
     }
     catch (const std::exception& e)
     {
@@ -24,41 +24,31 @@ public:
     SyncStatistics(const FilePair& file);
 
     template <SelectedSide side>
-    int createCount() const { return SelectParam<side>::ref(createLeft, createRight); }
-    int createCount() const { return createLeft + createRight; }
+    int createCount() const { return SelectParam<side>::ref(stats.createLeft, stats.createRight); }
+    int createCount() const { return stats.createLeft + stats.createRight; }
 
     template <SelectedSide side>
-    int updateCount() const { return SelectParam<side>::ref(updateLeft, updateRight); }
-    int updateCount() const { return updateLeft + updateRight; }
+    int updateCount() const { return SelectParam<side>::ref(stats.updateLeft, stats.updateRight); }
+    int updateCount() const { return stats.updateLeft + stats.updateRight; }
 
     template <SelectedSide side>
-    int deleteCount() const { return SelectParam<side>::ref(deleteLeft, deleteRight); }
-    int deleteCount() const { return deleteLeft + deleteRight; }
+    int deleteCount() const { return SelectParam<side>::ref(stats.deleteLeft, stats.deleteRight); }
+    int deleteCount() const { return stats.deleteLeft + stats.deleteRight; }
 
-    int conflictCount() const { return static_cast<int>(conflictMsgs.size()); }
+    int conflictCount() const { return stats.conflictCount; }
 
-    std::int64_t getDataToProcess() const { return dataToProcess; }
-    size_t       rowCount        () const { return rowsTotal; }
+    std::int64_t getDataToProcess() const { return stats.dataToProcess; }
+    size_t       rowCount        () const { return stats.rowCount; }
 
     using ConflictInfo = std::pair<Zstring, std::wstring>; //pair(filePath/conflict message)
     const std::vector<ConflictInfo>& getConflicts() const { return conflictMsgs; }
 
 private:
-    void recurse(const HierarchyObject& hierObj);
-
-    void processFile(const FilePair& file);
-    void processLink(const SymlinkPair& link);
-    void processFolder(const FolderPair& folder);
-
-    int createLeft  = 0;
-    int createRight = 0;
-    int updateLeft  = 0;
-    int updateRight = 0;
-    int deleteLeft  = 0;
-    int deleteRight = 0;
+    void addSubTree(const HierarchyObject& hierObj);
+    void collectConflicts(const HierarchyObject& hierObj);
+
+    SubTreeStats stats; //totals are buffered by HierarchyObject: no need to traverse the full hierarchy for each instance
     std::vector<ConflictInfo> conflictMsgs; //conflict texts to display as a warning message
-    std::int64_t dataToProcess = 0;
-    size_t rowsTotal = 0;
 };
 
 
@@ -91,6 +81,13 @@ void synchronize(const TimeComp& timeStamp,
                  bool copyLockedFiles,
                  bool copyFilePermissions,
                  bool failSafeFileCopy,
+                 bool cloneFiles, //create reflinks instead of copying file content if supported by target file system
+                 bool deltaCopy,  //update large files by writing changed blocks only
+                 bool scanSnapshot, //no in-place delta copy: the scan snapshot would miss the change
+                 size_t syncThreadsPerFolderPair, //number of new files being copied in parallel
+                 size_t syncThreadsTotal, //folder pairs without common folders are synchronized in parallel within this limit
+                 int versionCountLimit, //< 0 means no limit; applies to VersioningStyle::ADD_TIMESTAMP
+                 int versionMaxAgeDays, //
                  bool runWithBackgroundPriority,
                  int folderAccessTimeout,
                  const std::vector<FolderPairSyncCfg>& syncConfig, //CONTRACT: syncConfig and folderCmp correspond row-wise!
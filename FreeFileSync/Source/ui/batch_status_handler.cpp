@@ -140,6 +140,7 @@ BatchStatusHandler::BatchStatusHandler(bool showProgress,
                                        const Zstring& logFolderPathPhrase, //may be empty
                                        int logfilesCountLimit,
                                        size_t lastSyncsLogFileSizeMax,
+                                       size_t logMemoryLimit,
                                        const xmlAccess::OnError handleError,
                                        size_t automaticRetryCount,
                                        size_t automaticRetryDelay,
@@ -152,6 +153,7 @@ BatchStatusHandler::BatchStatusHandler(bool showProgress,
     logfilesCountLimit_(logfilesCountLimit),
     lastSyncsLogFileSizeMax_(lastSyncsLogFileSizeMax),
     handleError_(handleError),
+    errorLog(logMemoryLimit),
     returnCode_(returnCode),
     automaticRetryCount_(automaticRetryCount),
     automaticRetryDelay_(automaticRetryDelay),
@@ -31,6 +31,7 @@ public:
                        const Zstring& logFolderPathPhrase,
                        int logfilesCountLimit, //0: logging inactive; < 0: no limit
                        size_t lastSyncsLogFileSizeMax,
+                       size_t logMemoryLimit,
                        const xmlAccess::OnError handleError,
                        size_t automaticRetryCount,
                        size_t automaticRetryDelay,
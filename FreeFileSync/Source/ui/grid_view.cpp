@@ -8,6 +8,8 @@
 #include "sorting.h"
 #include "../synchronization.h"
 #include <zen/stl_tools.h>
+#include <zen/thread.h>
+#include <zen/scope_guard.h>
 
 using namespace zen;
 
@@ -49,51 +51,111 @@ void addNumbers(const FileSystemObject& fsObj, StatusResult& result)
 }
 
 
-template <class Predicate>
-void GridView::updateView(Predicate pred)
+template <class GetStatus>
+void GridView::evaluateRowStatus(RowStatusType type, GetStatus getStatus)
 {
+    rowStatusNumbers.fill(RowStatusNumbers());
+
+    for (RefIndex& ref : sortedRef)
+        if (const FileSystemObject* fsObj = FileSystemObject::retrieve(ref.objId))
+        {
+            ref.rowStatus = static_cast<std::uint8_t>(getStatus(*fsObj) | (fsObj->isActive() ? 0 : ROW_STATUS_EXCLUDED));
+
+            RowStatusNumbers& numbers = rowStatusNumbers[ref.rowStatus];
+            ++numbers.rowCount;
+            addNumbers(*fsObj, numbers); //calculate total number of bytes for each side
+        }
+        else
+            ref.rowStatus = ROW_STATUS_INVALID;
+
+    rowStatusType = type;
+}
+
+
+template <class StatusResult, class ShowStatus>
+void GridView::updateView(StatusResult& result, ShowStatus showStatus)
+{
+    std::array<bool, 256> statusOnView = {};
+
+    for (size_t status = 0; status < rowStatusNumbers.size(); ++status)
+        if (status != ROW_STATUS_INVALID)
+        {
+            const RowStatusNumbers& numbers = rowStatusNumbers[status];
+            if (numbers.rowCount > 0 &&
+                showStatus(static_cast<std::uint8_t>(status & ~ROW_STATUS_EXCLUDED), (status & ROW_STATUS_EXCLUDED) == 0))
+            {
+                statusOnView[status] = true;
+
+                result.filesOnLeftView    += numbers.filesOnLeftView;
+                result.foldersOnLeftView  += numbers.foldersOnLeftView;
+                result.filesOnRightView   += numbers.filesOnRightView;
+                result.foldersOnRightView += numbers.foldersOnRightView;
+                result.filesizeLeftView   += numbers.filesizeLeftView;
+                result.filesizeRightView  += numbers.filesizeRightView;
+            }
+        }
+
     viewRef.clear();
+    clearRowPositions();
+
+    for (const RefIndex& ref : sortedRef)
+        if (statusOnView[ref.rowStatus])
+            viewRef.push_back(ref.objId);
+}
+
+
+void GridView::clearRowPositions()
+{
     rowPositions.clear();
     rowPositionsFirstChild.clear();
+    rowPositionsValid = false;
+}
 
-    for (const RefIndex& ref : sortedRef)
-    {
-        if (const FileSystemObject* fsObj = FileSystemObject::retrieve(ref.objId))
-            if (pred(*fsObj))
+
+void GridView::buildRowPositions() const
+{
+    rowPositions.clear();
+    rowPositionsFirstChild.clear();
+
+    for (size_t row = 0; row < viewRef.size(); ++row)
+        if (const FileSystemObject* fsObj = FileSystemObject::retrieve(viewRef[row]))
+        {
+            //save row position for direct random access to FilePair or FolderPair
+            rowPositions.emplace(viewRef[row], row); //costs: 0.28 s per call - MSVC based on std::set
+
+            //save row position to identify first child *on sorted subview* of FolderPair or BaseFolderPair in case latter are filtered out
+            const HierarchyObject* parent = &fsObj->parent();
+            for (;;) //map all yet unassociated parents to this row
             {
-                //save row position for direct random access to FilePair or FolderPair
-                this->rowPositions.emplace(ref.objId, viewRef.size()); //costs: 0.28 s per call - MSVC based on std::set
-                //"this->" required by two-pass lookup as enforced by GCC 4.7
-
-                //save row position to identify first child *on sorted subview* of FolderPair or BaseFolderPair in case latter are filtered out
-                const HierarchyObject* parent = &fsObj->parent();
-                for (;;) //map all yet unassociated parents to this row
-                {
-                    const auto rv = this->rowPositionsFirstChild.emplace(parent, viewRef.size());
-                    if (!rv.second)
-                        break;
-
-                    if (auto folder = dynamic_cast<const FolderPair*>(parent))
-                        parent = &(folder->parent());
-                    else
-                        break;
-                }
-
-                //build subview
-                this->viewRef.push_back(ref.objId);
+                const auto rv = rowPositionsFirstChild.emplace(parent, row);
+                if (!rv.second)
+                    break;
+
+                if (auto folder = dynamic_cast<const FolderPair*>(parent))
+                    parent = &(folder->parent());
+                else
+                    break;
             }
-    }
+        }
+
+    rowPositionsValid = true;
 }
 
 
 ptrdiff_t GridView::findRowDirect(FileSystemObject::ObjectIdConst objId) const
 {
+    if (!rowPositionsValid)
+        buildRowPositions();
+
     auto it = rowPositions.find(objId);
     return it != rowPositions.end() ? it->second : -1;
 }
 
 ptrdiff_t GridView::findRowFirstChild(const HierarchyObject* hierObj) const
 {
+    if (!rowPositionsValid)
+        buildRowPositions();
+
     auto it = rowPositionsFirstChild.find(hierObj);
     return it != rowPositionsFirstChild.end() ? it->second : -1;
 }
@@ -108,18 +170,22 @@ GridView::StatusCmpResult GridView::updateCmpResult(bool showExcluded, //maps so
                                                     bool equalFilesActive,
                                                     bool conflictFilesActive)
 {
+    if (!reuseRowStatus_ || rowStatusType != RowStatusType::CMP_RESULT)
+        evaluateRowStatus(RowStatusType::CMP_RESULT, [](const FileSystemObject& fsObj) { return fsObj.getCategory(); });
+    reuseRowStatus_ = false;
+
     StatusCmpResult output;
 
-    updateView([&](const FileSystemObject& fsObj) -> bool
+    updateView(output, [&](std::uint8_t status, bool active) -> bool
     {
-        if (!fsObj.isActive())
+        if (!active)
         {
             output.existsExcluded = true;
             if (!showExcluded)
                 return false;
         }
 
-        switch (fsObj.getCategory())
+        switch (static_cast<CompareFilesResult>(status))
         {
             case FILE_LEFT_SIDE_ONLY:
                 output.existsLeftOnly = true;
@@ -151,8 +217,6 @@ GridView::StatusCmpResult GridView::updateCmpResult(bool showExcluded, //maps so
                 if (!conflictFilesActive) return false;
                 break;
         }
-        //calculate total number of bytes for each side
-        addNumbers(fsObj, output);
         return true;
     });
 
@@ -171,18 +235,22 @@ GridView::StatusSyncPreview GridView::updateSyncPreview(bool showExcluded, //map
                                                         bool syncEqualActive,
                                                         bool conflictFilesActive)
 {
+    if (!reuseRowStatus_ || rowStatusType != RowStatusType::SYNC_OPERATION)
+        evaluateRowStatus(RowStatusType::SYNC_OPERATION, [](const FileSystemObject& fsObj) { return fsObj.getSyncOperation(); }); //evaluate comparison result and sync direction
+    reuseRowStatus_ = false;
+
     StatusSyncPreview output;
 
-    updateView([&](const FileSystemObject& fsObj) -> bool
+    updateView(output, [&](std::uint8_t status, bool active) -> bool
     {
-        if (!fsObj.isActive())
+        if (!active)
         {
             output.existsExcluded = true;
             if (!showExcluded)
                 return false;
         }
 
-        switch (fsObj.getSyncOperation()) //evaluate comparison result and sync direction
+        switch (static_cast<SyncOperation>(status))
         {
             case SO_CREATE_NEW_LEFT:
                 output.existsSyncCreateLeft = true;
@@ -227,9 +295,6 @@ GridView::StatusSyncPreview GridView::updateSyncPreview(bool showExcluded, //map
                 if (!conflictFilesActive) return false;
                 break;
         }
-
-        //calculate total number of bytes for each side
-        addNumbers(fsObj, output);
         return true;
     });
 
@@ -255,8 +320,8 @@ std::vector<FileSystemObject*> GridView::getAllFileRef(const std::vector<size_t>
 void GridView::removeInvalidRows()
 {
     viewRef.clear();
-    rowPositions.clear();
-    rowPositionsFirstChild.clear();
+    clearRowPositions();
+    rowStatusType = RowStatusType::NONE;
 
     //remove rows that have been deleted meanwhile
     erase_if(sortedRef, [&](const RefIndex& refIdx) { return FileSystemObject::retrieve(refIdx.objId) == nullptr; });
@@ -296,6 +361,8 @@ void GridView::setData(FolderComparison& folderCmp)
     //clear everything
     std::vector<FileSystemObject::ObjectId>().swap(viewRef); //free mem
     std::vector<RefIndex>().swap(sortedRef);                 //
+    clearRowPositions();
+    rowStatusType = RowStatusType::NONE;
     currentSort = NoValue();
 
     folderPairCount = std::count_if(begin(folderCmp), end(folderCmp),
@@ -310,147 +377,134 @@ void GridView::setData(FolderComparison& folderCmp)
 }
 
 
-//------------------------------------ SORTING TEMPLATES ------------------------------------------------
-template <bool ascending, SelectedSide side>
-struct GridView::LessFullPath
+//------------------------------------ SORTING ------------------------------------------------
+namespace
 {
-    bool operator()(const RefIndex a, const RefIndex b) const
-    {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
-
-        return lessFullPath<ascending, side>(*fsObjA, *fsObjB);
-    }
-};
+size_t getSortThreadCount(size_t rowCount)
+{
+    const size_t minRowsPerThread = 10000; //don't bother starting threads for small views
+    return std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), rowCount / minRowsPerThread));
+}
 
 
-template <bool ascending>
-struct GridView::LessRelativeFolder
+template <class T>
+void waitForAll(std::vector<std::future<T>>& jobs)
 {
-    bool operator()(const RefIndex a, const RefIndex b) const
-    {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
+    for (std::future<T>& job : jobs)
+        job.wait(); //don't leave threads running on data owned by the caller
+    for (std::future<T>& job : jobs)
+        job.get(); //throw first exception (e.g. std::bad_alloc)
+}
 
-        //presort by folder pair
-        if (a.folderIndex != b.folderIndex)
-            return ascending ?
-                   a.folderIndex < b.folderIndex :
-                   a.folderIndex > b.folderIndex;
 
-        return lessRelativeFolder<ascending>(*fsObjA, *fsObjB);
-    }
-};
+//run fun(rowFirst, rowLast) for adjacent row ranges in parallel
+template <class Function>
+void parallelForRows(size_t rowCount, Function fun)
+{
+    const size_t threadCount = getSortThreadCount(rowCount);
+    if (threadCount <= 1)
+        return fun(0, rowCount);
 
+    std::vector<std::future<void>> jobs;
+    ZEN_ON_SCOPE_FAIL(for (std::future<void>& job : jobs) job.wait(););
 
-template <bool ascending, SelectedSide side>
-struct GridView::LessShortFileName
-{
-    bool operator()(const RefIndex a, const RefIndex b) const
+    for (size_t i = 0; i < threadCount; ++i)
     {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
-
-        return lessShortFileName<ascending, side>(*fsObjA, *fsObjB);
+        const size_t rowFirst = rowCount *  i      / threadCount;
+        const size_t rowLast  = rowCount * (i + 1) / threadCount;
+        jobs.push_back(runAsync([fun, rowFirst, rowLast] { fun(rowFirst, rowLast); }));
     }
-};
+    waitForAll(jobs);
+}
 
 
-template <bool ascending, SelectedSide side>
-struct GridView::LessFilesize
+//stable sort on multiple threads: sort adjacent ranges in parallel, then merge neighbors pairwise until a single range is left
+template <class RandomAccessIterator, class Compare>
+void parallelStableSort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
 {
-    bool operator()(const RefIndex a, const RefIndex b) const
-    {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
+    const size_t rowCount = last - first;
+    const size_t threadCount = getSortThreadCount(rowCount);
+    if (threadCount <= 1)
+        return std::stable_sort(first, last, comp);
 
-        return lessFilesize<ascending, side>(*fsObjA, *fsObjB);
-    }
-};
+    std::vector<RandomAccessIterator> bounds; //range i: [bounds[i], bounds[i + 1])
+    for (size_t i = 0; i <= threadCount; ++i)
+        bounds.push_back(first + rowCount * i / threadCount);
 
+    std::vector<std::future<void>> jobs;
+    ZEN_ON_SCOPE_FAIL(for (std::future<void>& job : jobs) job.wait(););
 
-template <bool ascending, SelectedSide side>
-struct GridView::LessFiletime
-{
-    bool operator()(const RefIndex a, const RefIndex b) const
+    for (size_t i = 0; i + 1 < bounds.size(); ++i)
     {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
-
-        return lessFiletime<ascending, side>(*fsObjA, *fsObjB);
+        const RandomAccessIterator itFirst = bounds[i];
+        const RandomAccessIterator itLast  = bounds[i + 1];
+        jobs.push_back(runAsync([itFirst, itLast, comp] { std::stable_sort(itFirst, itLast, comp); }));
     }
-};
+    waitForAll(jobs);
 
-
-template <bool ascending, SelectedSide side>
-struct GridView::LessExtension
-{
-    bool operator()(const RefIndex a, const RefIndex b) const
+    while (bounds.size() > 2)
     {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
+        jobs.clear();
+        std::vector<RandomAccessIterator> boundsMerged;
+
+        for (size_t i = 0; i + 2 < bounds.size(); i += 2)
+        {
+            const RandomAccessIterator itFirst  = bounds[i];
+            const RandomAccessIterator itMiddle = bounds[i + 1];
+            const RandomAccessIterator itLast   = bounds[i + 2];
+            jobs.push_back(runAsync([itFirst, itMiddle, itLast, comp] { std::inplace_merge(itFirst, itMiddle, itLast, comp); }));
+            boundsMerged.push_back(itFirst);
+        }
+        if (bounds.size() % 2 == 0) //odd number of ranges: last one is merged during next round
+            boundsMerged.push_back(bounds[bounds.size() - 2]);
+        boundsMerged.push_back(bounds.back());
 
-        return lessExtension<ascending, side>(*fsObjA, *fsObjB);
+        waitForAll(jobs);
+        bounds.swap(boundsMerged);
     }
-};
+}
+}
 
 
-template <bool ascending>
-struct GridView::LessCmpResult
+template <class SortKey>
+void GridView::sortByKey()
 {
-    bool operator()(const RefIndex a, const RefIndex b) const
+    struct SortRow
     {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
+        int group = std::numeric_limits<int>::max(); //invalid rows shall appear at the end
+        typename SortKey::Key key;
+        size_t pos = 0; //position on sortedRef before sorting
+    };
 
-        return lessCmpResult<ascending>(*fsObjA, *fsObjB);
-    }
-};
+    std::vector<SortRow> rows(sortedRef.size());
 
+    //FileSystemObject::retrieve() only reads the object slot table: safe from multiple threads while no objects are created or deleted
 
-template <bool ascending>
-struct GridView::LessSyncDirection
-{
-    bool operator()(const RefIndex a, const RefIndex b) const
+    parallelForRows(rows.size(), [&](size_t rowFirst, size_t rowLast)
     {
-        const FileSystemObject* fsObjA = FileSystemObject::retrieve(a.objId);
-        const FileSystemObject* fsObjB = FileSystemObject::retrieve(b.objId);
-        if (!fsObjA) //invalid rows shall appear at the end
-            return false;
-        else if (!fsObjB)
-            return true;
+        for (size_t i = rowFirst; i < rowLast; ++i)
+        {
+            SortRow& row = rows[i];
+            row.pos = i;
+            if (const FileSystemObject* fsObj = FileSystemObject::retrieve(sortedRef[i].objId))
+                row.group = SortKey::getKey(*fsObj, sortedRef[i].folderIndex, row.key);
+        }
+    });
 
-        return lessSyncDirection<ascending>(*fsObjA, *fsObjB);
-    }
-};
+    parallelStableSort(rows.begin(), rows.end(), [](const SortRow& lhs, const SortRow& rhs)
+    {
+        if (lhs.group != rhs.group)
+            return lhs.group < rhs.group;
+        return SortKey::less(lhs.key, rhs.key);
+    });
+
+    std::vector<RefIndex> sortedRefNew;
+    sortedRefNew.reserve(rows.size());
+    for (const SortRow& row : rows)
+        sortedRefNew.push_back(sortedRef[row.pos]);
+
+    sortedRef.swap(sortedRefNew);
+}
 
 //-------------------------------------------------------------------------------------------------------
 bool GridView::getDefaultSortDirection(ColumnTypeRim type) //true: ascending; false: descending
@@ -473,9 +527,8 @@ bool GridView::getDefaultSortDirection(ColumnTypeRim type) //true: ascending; fa
 void GridView::sortView(ColumnTypeRim type, ItemPathFormat pathFmt, bool onLeft, bool ascending)
 {
     viewRef.clear();
-    rowPositions.clear();
-    rowPositionsFirstChild.clear();
-    currentSort = SortInfo(type, onLeft, ascending);
+    clearRowPositions();
+    currentSort = SortInfo(type, onLeft, ascending); //RefIndex::rowStatus is sorted along
 
     switch (type)
     {
@@ -483,43 +536,43 @@ void GridView::sortView(ColumnTypeRim type, ItemPathFormat pathFmt, bool onLeft,
             switch (pathFmt)
             {
                 case ItemPathFormat::FULL_PATH:
-                    if      ( ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFullPath<true,  LEFT_SIDE >());
-                    else if ( ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFullPath<true,  RIGHT_SIDE>());
-                    else if (!ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFullPath<false, LEFT_SIDE >());
-                    else if (!ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFullPath<false, RIGHT_SIDE>());
+                    if      ( ascending &&  onLeft) sortByKey<SortKeyFullPath<true,  LEFT_SIDE >>();
+                    else if ( ascending && !onLeft) sortByKey<SortKeyFullPath<true,  RIGHT_SIDE>>();
+                    else if (!ascending &&  onLeft) sortByKey<SortKeyFullPath<false, LEFT_SIDE >>();
+                    else if (!ascending && !onLeft) sortByKey<SortKeyFullPath<false, RIGHT_SIDE>>();
                     break;
 
                 case ItemPathFormat::RELATIVE_PATH:
-                    if      ( ascending) std::sort(sortedRef.begin(), sortedRef.end(), LessRelativeFolder<true>());
-                    else if (!ascending) std::sort(sortedRef.begin(), sortedRef.end(), LessRelativeFolder<false>());
+                    if      ( ascending) sortByKey<SortKeyRelativeFolder<true >>();
+                    else if (!ascending) sortByKey<SortKeyRelativeFolder<false>>();
                     break;
 
                 case ItemPathFormat::ITEM_NAME:
-                    if      ( ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessShortFileName<true,  LEFT_SIDE >());
-                    else if ( ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessShortFileName<true,  RIGHT_SIDE>());
-                    else if (!ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessShortFileName<false, LEFT_SIDE >());
-                    else if (!ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessShortFileName<false, RIGHT_SIDE>());
+                    if      ( ascending &&  onLeft) sortByKey<SortKeyShortFileName<true,  LEFT_SIDE >>();
+                    else if ( ascending && !onLeft) sortByKey<SortKeyShortFileName<true,  RIGHT_SIDE>>();
+                    else if (!ascending &&  onLeft) sortByKey<SortKeyShortFileName<false, LEFT_SIDE >>();
+                    else if (!ascending && !onLeft) sortByKey<SortKeyShortFileName<false, RIGHT_SIDE>>();
                     break;
             }
             break;
 
         case ColumnTypeRim::SIZE:
-            if      ( ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFilesize<true,  LEFT_SIDE >());
-            else if ( ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFilesize<true,  RIGHT_SIDE>());
-            else if (!ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFilesize<false, LEFT_SIDE >());
-            else if (!ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFilesize<false, RIGHT_SIDE>());
+            if      ( ascending &&  onLeft) sortByKey<SortKeyFilesize<true,  LEFT_SIDE >>();
+            else if ( ascending && !onLeft) sortByKey<SortKeyFilesize<true,  RIGHT_SIDE>>();
+            else if (!ascending &&  onLeft) sortByKey<SortKeyFilesize<false, LEFT_SIDE >>();
+            else if (!ascending && !onLeft) sortByKey<SortKeyFilesize<false, RIGHT_SIDE>>();
             break;
         case ColumnTypeRim::DATE:
-            if      ( ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFiletime<true,  LEFT_SIDE >());
-            else if ( ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFiletime<true,  RIGHT_SIDE>());
-            else if (!ascending &&  onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFiletime<false, LEFT_SIDE >());
-            else if (!ascending && !onLeft) std::sort(sortedRef.begin(), sortedRef.end(), LessFiletime<false, RIGHT_SIDE>());
+            if      ( ascending &&  onLeft) sortByKey<SortKeyFiletime<true,  LEFT_SIDE >>();
+            else if ( ascending && !onLeft) sortByKey<SortKeyFiletime<true,  RIGHT_SIDE>>();
+            else if (!ascending &&  onLeft) sortByKey<SortKeyFiletime<false, LEFT_SIDE >>();
+            else if (!ascending && !onLeft) sortByKey<SortKeyFiletime<false, RIGHT_SIDE>>();
             break;
         case ColumnTypeRim::EXTENSION:
-            if      ( ascending &&  onLeft) std::stable_sort(sortedRef.begin(), sortedRef.end(), LessExtension<true,  LEFT_SIDE >());
-            else if ( ascending && !onLeft) std::stable_sort(sortedRef.begin(), sortedRef.end(), LessExtension<true,  RIGHT_SIDE>());
-            else if (!ascending &&  onLeft) std::stable_sort(sortedRef.begin(), sortedRef.end(), LessExtension<false, LEFT_SIDE >());
-            else if (!ascending && !onLeft) std::stable_sort(sortedRef.begin(), sortedRef.end(), LessExtension<false, RIGHT_SIDE>());
+            if      ( ascending &&  onLeft) sortByKey<SortKeyExtension<true,  LEFT_SIDE >>();
+            else if ( ascending && !onLeft) sortByKey<SortKeyExtension<true,  RIGHT_SIDE>>();
+            else if (!ascending &&  onLeft) sortByKey<SortKeyExtension<false, LEFT_SIDE >>();
+            else if (!ascending && !onLeft) sortByKey<SortKeyExtension<false, RIGHT_SIDE>>();
             break;
     }
 }
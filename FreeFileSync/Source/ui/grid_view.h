@@ -8,6 +8,7 @@
 #define GRID_VIEW_H_9285028345703475842569
 
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include "column_attr.h"
 #include "../file_hierarchy.h"
@@ -52,6 +53,10 @@ public:
         std::uint64_t filesizeRightView = 0;
     };
 
+    //call before updateCmpResult()/updateSyncPreview() if only the view filter settings changed since the last update:
+    //=> the category/sync operation of each row is taken from the last update instead of evaluating all rows again
+    void reuseRowStatus() { reuseRowStatus_ = true; }
+
     //comparison results view
     StatusCmpResult updateCmpResult(bool showExcluded,
                                     bool leftOnlyFilesActive,
@@ -127,17 +132,50 @@ private:
     struct RefIndex
     {
         RefIndex(size_t folderInd, FileSystemObject::ObjectId id) :
-            folderIndex(folderInd),
+            folderIndex(static_cast<std::uint32_t>(folderInd)),
             objId(id) {}
-        size_t folderIndex; //because of alignment there's no benefit in using "unsigned int" in 64-bit code here!
+        std::uint32_t folderIndex;
+        std::uint8_t rowStatus = 0; //category or sync operation + ROW_STATUS_EXCLUDED, see RowStatusType; fits into the padding: sizeof(RefIndex) == 16
         FileSystemObject::ObjectId objId;
     };
 
-    template <class Predicate> void updateView(Predicate pred);
+    //rows are classified by a single pass over all rows: toggling the view filter only needs to pick the matching classes
+    enum class RowStatusType
+    {
+        NONE,
+        CMP_RESULT,     //CompareFilesResult
+        SYNC_OPERATION, //SyncOperation
+    };
+    static const std::uint8_t ROW_STATUS_EXCLUDED = 0x80;
+    static const std::uint8_t ROW_STATUS_INVALID  = 0xff; //object was deleted
+
+    struct RowStatusNumbers
+    {
+        size_t rowCount = 0;
 
+        unsigned int filesOnLeftView    = 0;
+        unsigned int foldersOnLeftView  = 0;
+        unsigned int filesOnRightView   = 0;
+        unsigned int foldersOnRightView = 0;
 
-    std::unordered_map<FileSystemObject::ObjectIdConst, size_t> rowPositions; //find row positions on sortedRef directly
-    std::unordered_map<const void*, size_t> rowPositionsFirstChild; //find first child on sortedRef of a hierarchy object
+        std::uint64_t filesizeLeftView  = 0;
+        std::uint64_t filesizeRightView = 0;
+    };
+
+    template <class GetStatus> void evaluateRowStatus(RowStatusType type, GetStatus getStatus);
+    template <class StatusResult, class ShowStatus> void updateView(StatusResult& result, ShowStatus showStatus);
+
+    void clearRowPositions();
+    void buildRowPositions() const;
+
+    RowStatusType rowStatusType = RowStatusType::NONE; //type of RefIndex::rowStatus in sortedRef
+    std::array<RowStatusNumbers, 256> rowStatusNumbers; //totals per RefIndex::rowStatus
+    bool reuseRowStatus_ = false;
+
+    //built on demand: not needed for most view updates
+    mutable bool rowPositionsValid = false;
+    mutable std::unordered_map<FileSystemObject::ObjectIdConst, size_t> rowPositions; //find row positions on sortedRef directly
+    mutable std::unordered_map<const void*, size_t> rowPositionsFirstChild; //find first child on sortedRef of a hierarchy object
     //void* instead of HierarchyObject*: these are weak pointers and should *never be dereferenced*!
 
     std::vector<FileSystemObject::ObjectId> viewRef; //partial view on sortedRef
@@ -154,30 +192,8 @@ private:
 
     class SerializeHierarchy;
 
-    //sorting classes
-    template <bool ascending, SelectedSide side>
-    struct LessFullPath;
-
-    template <bool ascending>
-    struct LessRelativeFolder;
-
-    template <bool ascending, SelectedSide side>
-    struct LessShortFileName;
-
-    template <bool ascending, SelectedSide side>
-    struct LessFilesize;
-
-    template <bool ascending, SelectedSide side>
-    struct LessFiletime;
-
-    template <bool ascending, SelectedSide side>
-    struct LessExtension;
-
-    template <bool ascending>
-    struct LessCmpResult;
-
-    template <bool ascending>
-    struct LessSyncDirection;
+    template <class SortKey>
+    void sortByKey(); //sort sortedRef using SortKey (see sorting.h)
 
     Opt<SortInfo> currentSort;
 };
@@ -248,6 +248,7 @@ void StatusHandlerTemporaryPanel::OnAbortCompare(wxCommandEvent& event)
 
 StatusHandlerFloatingDialog::StatusHandlerFloatingDialog(wxFrame* parentDlg,
                                                          size_t lastSyncsLogFileSizeMax,
+                                                         size_t logMemoryLimit,
                                                          OnGuiError handleError,
                                                          size_t automaticRetryCount,
                                                          size_t automaticRetryDelay,
@@ -258,6 +259,7 @@ StatusHandlerFloatingDialog::StatusHandlerFloatingDialog(wxFrame* parentDlg,
     progressDlg(createProgressDialog(*this, [this] { this->onProgressDialogTerminate(); }, *this, parentDlg, true, jobName, soundFileSyncComplete, onCompletion, onCompletionHistory)),
             lastSyncsLogFileSizeMax_(lastSyncsLogFileSizeMax),
             handleError_(handleError),
+            errorLog_(logMemoryLimit),
             automaticRetryCount_(automaticRetryCount),
             automaticRetryDelay_(automaticRetryDelay),
             jobName_(jobName),
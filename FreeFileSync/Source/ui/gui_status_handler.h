@@ -55,6 +55,7 @@ class StatusHandlerFloatingDialog : public zen::StatusHandler
 public:
     StatusHandlerFloatingDialog(wxFrame* parentDlg,
                                 size_t lastSyncsLogFileSizeMax,
+                                size_t logMemoryLimit,
                                 xmlAccess::OnGuiError handleError,
                                 size_t automaticRetryCount,
                                 size_t automaticRetryDelay,
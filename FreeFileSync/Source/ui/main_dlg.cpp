@@ -3577,6 +3577,7 @@ void MainDialog::OnToggleViewButton(wxCommandEvent& event)
     if (auto button = dynamic_cast<ToggleButton*>(event.GetEventObject()))
     {
         button->toggle();
+        gridDataView->reuseRowStatus(); //only the view filter changed
         updateGui();
     }
     else
@@ -3750,6 +3751,11 @@ void MainDialog::OnCompare(wxCommandEvent& event)
                             true, //allowUserInteraction
                             globalCfg.runWithBackgroundPriority,
                             globalCfg.folderAccessTimeout,
+                            globalCfg.scanThreadsPerDevice,
+                            globalCfg.scanSnapshot,
+                            nullptr, //changeList
+                            globalCfg.compareThreadsPerDevice,
+                            globalCfg.reuseContentComparison,
                             globalCfg.createLockFile,
                             dirLocks,
                             cmpConfig,
@@ -3926,9 +3932,16 @@ void MainDialog::OnStartSync(wxCommandEvent& event)
         disableAllElements(false); //StatusHandlerFloatingDialog will internally process Window messages, so avoid unexpected callbacks!
         ZEN_ON_SCOPE_EXIT(enableAllElements());
 
+        //folder pairs may be synchronized on worker threads: grids must not read the FileSystemObject hierarchy when repainting in the meantime
+        const std::vector<wxWindow*> gridsFrozen = globalCfg.syncThreadsTotal > 1 ? std::vector<wxWindow*> { m_gridMainL, m_gridMainC, m_gridMainR, m_gridNavi } : std::vector<wxWindow*>();
+        for (wxWindow* grid : gridsFrozen)
+            grid->Freeze();
+        ZEN_ON_SCOPE_EXIT(for (wxWindow* grid : gridsFrozen) grid->Thaw());
+
         //class handling status updates and error messages
         StatusHandlerFloatingDialog statusHandler(this, //throw GuiAbortProcess
                                                   globalCfg.lastSyncsLogFileSizeMax,
+                                                  globalCfg.logMemoryLimit,
                                                   currentCfg.handleError,
                                                   globalCfg.automaticRetryCount,
                                                   globalCfg.automaticRetryDelay,
@@ -3972,6 +3985,13 @@ void MainDialog::OnStartSync(wxCommandEvent& event)
                     globalCfg.copyLockedFiles,
                     globalCfg.copyFilePermissions,
                     globalCfg.failSafeFileCopy,
+                    globalCfg.cloneFiles,
+                    globalCfg.deltaCopy,
+                    globalCfg.scanSnapshot,
+                    globalCfg.syncThreadsPerFolderPair,
+                    globalCfg.syncThreadsTotal,
+                    globalCfg.versionCountLimit,
+                    globalCfg.versionMaxAgeDays,
                     globalCfg.runWithBackgroundPriority,
                     globalCfg.folderAccessTimeout,
                     syncProcessCfg,
@@ -504,12 +504,13 @@ wxBitmap getImageButtonReleased(const wchar_t* name)
 
 
 //a vector-view on ErrorLog considering multi-line messages: prepare consumption by Grid
+//=> keeps one reference per log entry only: message lines are extracted lazily for the rows currently displayed
 class MessageView
 {
 public:
     MessageView(const ErrorLog& log) : log_(log) {}
 
-    size_t rowsOnView() const { return viewRef.size(); }
+    size_t rowsOnView() const { return rowCount; }
 
     struct LogEntryView
     {
@@ -521,15 +522,20 @@ public:
 
     Opt<LogEntryView> getEntry(size_t row) const
     {
-        if (row < viewRef.size())
+        if (row < rowCount)
         {
-            const Line& line = viewRef[row];
+            //find log entry spanning "row":
+            auto it = std::upper_bound(viewRef.begin(), viewRef.end(), row, [](size_t r, const EntryRef& ref) { return r < ref.rowFirst_; });
+            assert(it != viewRef.begin());
+            --it;
+            const size_t textRow = row - it->rowFirst_;
+            const LogEntry entry = log_.getEntry(it->logIndex_); //may read from ErrorLog's temporary file
 
             LogEntryView output;
-            output.time = line.logIt_->time;
-            output.type = line.logIt_->type;
-            output.messageLine = extractLine(line.logIt_->message, line.rowNumber_);
-            output.firstLine = line.rowNumber_ == 0; //this is virtually always correct, unless first line of the original message is empty!
+            output.time = entry.time;
+            output.type = entry.type;
+            output.messageLine = extractLine(entry.message, textRow);
+            output.firstLine = textRow == 0;
             return output;
         }
         return NoValue();
@@ -538,37 +544,51 @@ public:
     void updateView(int includedTypes) //TYPE_INFO | TYPE_WARNING, ect. see error_log.h
     {
         viewRef.clear();
+        rowCount = 0;
 
-        for (auto it = log_.begin(); it != log_.end(); ++it)
-            if (it->type & includedTypes)
+        size_t logIndex = 0;
+        for (const LogEntry& entry : log_) //iterate sequentially: reads ErrorLog's temporary file just once
+        {
+            if (entry.type & includedTypes)
             {
                 static_assert(IsSameType<GetCharType<MsgString>::Type, wchar_t>::value, "");
-                assert(!startsWith(it->message, L'\n'));
-
-                size_t rowNumber = 0;
-                bool lastCharNewline = true;
-                for (const wchar_t c : it->message)
-                    if (c == L'\n')
-                    {
-                        if (!lastCharNewline) //do not reference empty lines!
-                            viewRef.emplace_back(it, rowNumber);
-                        ++rowNumber;
-                        lastCharNewline = true;
-                    }
-                    else
-                        lastCharNewline = false;
+                assert(!startsWith(entry.message, L'\n'));
 
-                if (!lastCharNewline)
-                    viewRef.emplace_back(it, rowNumber);
+                const size_t lineCount = getLineCount(entry.message);
+                if (lineCount > 0)
+                {
+                    viewRef.emplace_back(logIndex, rowCount);
+                    rowCount += lineCount;
+                }
             }
+            ++logIndex;
+        }
     }
 
 private:
-    static MsgString extractLine(const MsgString& message, size_t textRow)
+    //do not reference empty lines!
+    static size_t getLineCount(const MsgString& message)
+    {
+        size_t lineCount = 0;
+        bool lastCharNewline = true;
+        for (const wchar_t c : message)
+            if (c == L'\n')
+                lastCharNewline = true;
+            else
+            {
+                if (lastCharNewline)
+                    ++lineCount;
+                lastCharNewline = false;
+            }
+        return lineCount;
+    }
+
+    static MsgString extractLine(const MsgString& message, size_t textRow) //textRow: skip empty lines
     {
         auto it1 = message.begin();
         for (;;)
         {
+            it1 = std::find_if(it1, message.end(), [](wchar_t c) { return c != L'\n'; });
             auto it2 = std::find_if(it1, message.end(), [](wchar_t c) { return c == L'\n'; });
             if (textRow == 0)
                 return it1 == message.end() ? MsgString() : MsgString(&*it1, it2 - it1); //must not dereference iterator pointing to "end"!
@@ -579,24 +599,25 @@ private:
                 return MsgString();
             }
 
-            it1 = it2 + 1; //skip newline
+            it1 = it2;
             --textRow;
         }
     }
 
-    struct Line
+    struct EntryRef
     {
-        Line(ErrorLog::const_iterator logIt, size_t rowNumber) : logIt_(logIt), rowNumber_(rowNumber) {}
+        EntryRef(size_t logIndex, size_t rowFirst) : logIndex_(logIndex), rowFirst_(rowFirst) {}
 
-        ErrorLog::const_iterator logIt_; //always bound!
-        size_t rowNumber_; //LogEntry::message may span multiple rows
+        size_t logIndex_; //always bound!
+        size_t rowFirst_; //LogEntry::message may span multiple rows
     };
 
-    std::vector<Line> viewRef; //partial view on log_
+    std::vector<EntryRef> viewRef; //partial view on log_, sorted by row
+    size_t rowCount = 0;
     /*          /|\
                  | updateView()
                  |                      */
-    const ErrorLog log_;
+    const ErrorLog log_; //copy is cheap: shares ErrorLog's temporary file
 };
 
 //-----------------------------------------------------------------------------
@@ -30,171 +30,170 @@ bool isDirectoryPair(const FileSystemObject& fsObj)
     return dynamic_cast<const FolderPair*>(&fsObj) != nullptr;
 }
 
+/*
+Sort keys are extracted once per row => sorting doesn't need to access FileSystemObject or rebuild paths for each comparison:
 
-template <bool ascending, SelectedSide side> inline
-bool lessShortFileName(const FileSystemObject& a, const FileSystemObject& b)
-{
-    //sort order: first files/symlinks, then directories then empty rows
+    struct SortKey...
+    {
+        using Key = ...;
+        static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key); //return sort group: lower groups first, independent from sort direction
+        static bool less(const Key& lhs, const Key& rhs); //sort order within the same group
+
+    getKey() only reads from FileSystemObject => may be called from worker threads while the main thread is waiting
+*/
 
-    //empty rows always last
-    if (a.isEmpty<side>())
-        return false;
-    else if (b.isEmpty<side>())
-        return true;
+template <bool ascending, SelectedSide side>
+struct SortKeyShortFileName
+{
+    using Key = Zstring;
 
-    //directories after files/symlinks:
-    if (isDirectoryPair(a))
+    static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key)
     {
-        if (!isDirectoryPair(b))
-            return false;
+        //sort order: first files/symlinks, then directories then empty rows
+        if (fsObj.isEmpty<side>())
+            return 2;
+
+        key = fsObj.getItemName<side>();
+        return isDirectoryPair(fsObj) ? 1 : 0;
     }
-    else if (isDirectoryPair(b))
-        return true;
 
-    //sort directories and files/symlinks by short name
-    return makeSortDirection(LessFilePath(), Int2Type<ascending>())(a.getItemName<side>(), b.getItemName<side>());
-}
+    static bool less(const Key& lhs, const Key& rhs) { return makeSortDirection(LessFilePath(), Int2Type<ascending>())(lhs, rhs); }
+};
 
 
-template <bool ascending, SelectedSide side> inline
-bool lessFullPath(const FileSystemObject& a, const FileSystemObject& b)
+template <bool ascending, SelectedSide side>
+struct SortKeyFullPath
 {
-    //empty rows always last
-    if (a.isEmpty<side>())
-        return false;
-    else if (b.isEmpty<side>())
-        return true;
-
-    return makeSortDirection(LessFilePath(), Int2Type<ascending>())(AFS::getDisplayPath(a.getAbstractPath<side>()),
-                                                                    AFS::getDisplayPath(b.getAbstractPath<side>()));
-}
+    using Key = std::wstring;
 
+    static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key)
+    {
+        if (fsObj.isEmpty<side>())
+            return 1; //empty rows always last
 
-template <bool ascending>  inline //side currently unused!
-bool lessRelativeFolder(const FileSystemObject& a, const FileSystemObject& b)
-{
-    const bool isDirectoryA = isDirectoryPair(a);
-    const Zstring& relFolderA = isDirectoryA ?
-                                a.getPairRelativePath() : //directory
-                                beforeLast(a.getPairRelativePath(), FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE);
-
-    const bool isDirectoryB = isDirectoryPair(b);
-    const Zstring& relFolderB = isDirectoryB ?
-                                b.getPairRelativePath() : //directory
-                                beforeLast(b.getPairRelativePath(), FILE_NAME_SEPARATOR ,IF_MISSING_RETURN_NONE);
-
-    //compare relative names without filepaths first
-    const int rv = cmpFilePath(relFolderA.c_str(), relFolderA.size(),
-                               relFolderB.c_str(), relFolderB.size());
-    if (rv != 0)
-        return makeSortDirection(std::less<int>(), Int2Type<ascending>())(rv, 0);
-
-    //compare the filepaths
-    if (isDirectoryB) //directories shall appear before files
-        return false;
-    else if (isDirectoryA)
-        return true;
-
-    return LessFilePath()(a.getPairItemName(), b.getPairItemName());
-}
+        key = AFS::getDisplayPath(fsObj.getAbstractPath<side>());
+        return 0;
+    }
+
+    static bool less(const Key& lhs, const Key& rhs) { return makeSortDirection(LessFilePath(), Int2Type<ascending>())(lhs, rhs); }
+};
 
 
-template <bool ascending, SelectedSide side> inline
-bool lessFilesize(const FileSystemObject& a, const FileSystemObject& b)
+template <bool ascending> //side currently unused!
+struct SortKeyRelativeFolder
 {
-    //empty rows always last
-    if (a.isEmpty<side>())
-        return false;
-    else if (b.isEmpty<side>())
-        return true;
-
-    //directories second last
-    if (isDirectoryPair(a))
-        return false;
-    else if (isDirectoryPair(b))
-        return true;
-
-    const FilePair* fileA = dynamic_cast<const FilePair*>(&a);
-    const FilePair* fileB = dynamic_cast<const FilePair*>(&b);
-
-    //then symlinks
-    if (!fileA)
-        return false;
-    else if (!fileB)
-        return true;
+    struct Key
+    {
+        size_t folderIndex = 0; //presort by folder pair
+        Zstring relFolder;
+        bool isDirectory = false;
+        Zstring itemName;
+    };
 
-    //return list beginning with largest files first
-    return makeSortDirection(std::less<>(), Int2Type<ascending>())(fileA->getFileSize<side>(), fileB->getFileSize<side>());
-}
+    static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key)
+    {
+        key.folderIndex = folderIndex;
+        key.isDirectory = isDirectoryPair(fsObj);
+        key.relFolder   = key.isDirectory ?
+                          fsObj.getPairRelativePath() : //directory
+                          beforeLast(fsObj.getPairRelativePath(), FILE_NAME_SEPARATOR, IF_MISSING_RETURN_NONE);
+        if (!key.isDirectory)
+            key.itemName = fsObj.getPairItemName();
+        return 0;
+    }
 
+    static bool less(const Key& lhs, const Key& rhs)
+    {
+        if (lhs.folderIndex != rhs.folderIndex)
+            return makeSortDirection(std::less<>(), Int2Type<ascending>())(lhs.folderIndex, rhs.folderIndex);
 
-template <bool ascending, SelectedSide side> inline
-bool lessFiletime(const FileSystemObject& a, const FileSystemObject& b)
-{
-    if (a.isEmpty<side>())
-        return false; //empty rows always last
-    else if (b.isEmpty<side>())
-        return true; //empty rows always last
+        //compare relative names without filepaths first
+        const int rv = cmpFilePath(lhs.relFolder.c_str(), lhs.relFolder.size(),
+                                   rhs.relFolder.c_str(), rhs.relFolder.size());
+        if (rv != 0)
+            return makeSortDirection(std::less<int>(), Int2Type<ascending>())(rv, 0);
 
-    const FilePair* fileA = dynamic_cast<const FilePair*>(&a);
-    const FilePair* fileB = dynamic_cast<const FilePair*>(&b);
+        //compare the filepaths
+        if (rhs.isDirectory) //directories shall appear before files
+            return false;
+        else if (lhs.isDirectory)
+            return true;
 
-    const SymlinkPair* symlinkA = dynamic_cast<const SymlinkPair*>(&a);
-    const SymlinkPair* symlinkB = dynamic_cast<const SymlinkPair*>(&b);
+        return LessFilePath()(lhs.itemName, rhs.itemName);
+    }
+};
 
-    if (!fileA && !symlinkA)
-        return false; //directories last
-    else if (!fileB && !symlinkB)
-        return true; //directories last
 
-    const std::int64_t dateA = fileA ? fileA->getLastWriteTime<side>() : symlinkA->getLastWriteTime<side>();
-    const std::int64_t dateB = fileB ? fileB->getLastWriteTime<side>() : symlinkB->getLastWriteTime<side>();
+template <bool ascending, SelectedSide side>
+struct SortKeyFilesize
+{
+    using Key = std::uint64_t;
 
-    //return list beginning with newest files first
-    return makeSortDirection(std::less<>(), Int2Type<ascending>())(dateA, dateB);
-}
+    static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key)
+    {
+        //sort order: files, symlinks, directories, empty rows
+        if (fsObj.isEmpty<side>())
+            return 3;
+
+        if (isDirectoryPair(fsObj))
+            return 2;
+
+        if (const FilePair* file = dynamic_cast<const FilePair*>(&fsObj))
+        {
+            key = file->getFileSize<side>();
+            return 0;
+        }
+        return 1;
+    }
 
+    //return list beginning with largest files first
+    static bool less(Key lhs, Key rhs) { return makeSortDirection(std::less<>(), Int2Type<ascending>())(lhs, rhs); }
+};
 
-template <bool ascending, SelectedSide side> inline
-bool lessExtension(const FileSystemObject& a, const FileSystemObject& b)
-{
-    if (a.isEmpty<side>())
-        return false; //empty rows always last
-    else if (b.isEmpty<side>())
-        return true; //empty rows always last
 
-    if (dynamic_cast<const FolderPair*>(&a))
-        return false; //directories last
-    else if (dynamic_cast<const FolderPair*>(&b))
-        return true; //directories last
+template <bool ascending, SelectedSide side>
+struct SortKeyFiletime
+{
+    using Key = std::int64_t;
 
-    auto getExtension = [](const FileSystemObject& fsObj)
+    static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key)
     {
-        return afterLast(fsObj.getItemName<side>(), Zchar('.'), zen::IF_MISSING_RETURN_NONE);
-    };
+        if (fsObj.isEmpty<side>())
+            return 2; //empty rows always last
+
+        if (const FilePair* file = dynamic_cast<const FilePair*>(&fsObj))
+            key = file->getLastWriteTime<side>();
+        else if (const SymlinkPair* symlink = dynamic_cast<const SymlinkPair*>(&fsObj))
+            key = symlink->getLastWriteTime<side>();
+        else
+            return 1; //directories last
+        return 0;
+    }
 
-    return makeSortDirection(LessFilePath(), Int2Type<ascending>())(getExtension(a), getExtension(b));
-}
+    //return list beginning with newest files first
+    static bool less(Key lhs, Key rhs) { return makeSortDirection(std::less<>(), Int2Type<ascending>())(lhs, rhs); }
+};
 
 
-template <bool ascending> inline
-bool lessCmpResult(const FileSystemObject& a, const FileSystemObject& b)
+template <bool ascending, SelectedSide side>
+struct SortKeyExtension
 {
-    //presort result: equal shall appear at end of list
-    if (a.getCategory() == FILE_EQUAL)
-        return false;
-    if (b.getCategory() == FILE_EQUAL)
-        return true;
+    using Key = Zstring;
 
-    return makeSortDirection(std::less<CompareFilesResult>(), Int2Type<ascending>())(a.getCategory(), b.getCategory());
-}
+    static int getKey(const FileSystemObject& fsObj, size_t folderIndex, Key& key)
+    {
+        if (fsObj.isEmpty<side>())
+            return 2; //empty rows always last
 
+        if (isDirectoryPair(fsObj))
+            return 1; //directories last
 
-template <bool ascending> inline
-bool lessSyncDirection(const FileSystemObject& a, const FileSystemObject& b)
-{
-    return makeSortDirection(std::less<>(), Int2Type<ascending>())(a.getSyncOperation(), b.getSyncOperation());
-}
+        key = afterLast(fsObj.getItemName<side>(), Zchar('.'), zen::IF_MISSING_RETURN_NONE);
+        return 0;
+    }
+
+    static bool less(const Key& lhs, const Key& rhs) { return makeSortDirection(LessFilePath(), Int2Type<ascending>())(lhs, rhs); }
+};
 }
 
 #endif //SORTING_H_82574232452345
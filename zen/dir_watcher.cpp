@@ -19,10 +19,13 @@
 #elif defined ZEN_LINUX
     #include <map>
     #include <sys/inotify.h>
+    #include <sys/fanotify.h>
     #include <fcntl.h> //fcntl
     #include <unistd.h> //close
     #include <limits.h> //NAME_MAX
+    #include <stdlib.h> //realpath
     #include "file_traverser.h"
+    #include "optional.h"
 
 #elif defined ZEN_MAC
     #include <CoreServices/CoreServices.h>
@@ -375,40 +378,195 @@ std::vector<DirWatcher::Entry> DirWatcher::getChanges(const std::function<void()
 
 
 #elif defined ZEN_LINUX
+namespace
+{
+const uint32_t INOTIFY_WATCH_MASK = IN_ONLYDIR     | //"Only watch pathname if it is a directory."
+                                    IN_DONT_FOLLOW | //don't follow symbolic links
+                                    IN_CREATE      |
+                                    IN_MODIFY      |
+                                    IN_CLOSE_WRITE |
+                                    IN_DELETE      |
+                                    IN_DELETE_SELF |
+                                    IN_MOVED_FROM  |
+                                    IN_MOVED_TO    |
+                                    IN_MOVE_SELF;
+
+#ifdef FAN_REPORT_DFID_NAME //Linux 5.9+
+const uint64_t FANOTIFY_WATCH_MASK = FAN_CREATE      |
+                                     FAN_MODIFY      |
+                                     FAN_CLOSE_WRITE |
+                                     FAN_DELETE      |
+                                     FAN_MOVED_FROM  |
+                                     FAN_MOVED_TO    |
+                                     FAN_ONDIR; //report events for directory items, too
+
+const size_t FANOTIFY_DIR_CACHE_MAX = 100000; //file handle -> path resolution is cached for whole file system => limit memory consumption
+#endif
+}
+
+
 struct DirWatcher::Pimpl
 {
-    int notifDescr = 0;
+    ~Pimpl()
+    {
+        if (notifDescr != -1) ::close(notifDescr); //associated watches/marks are removed automatically!
+#ifdef FAN_REPORT_DFID_NAME
+        if (mountDescr != -1) ::close(mountDescr);
+#endif
+    }
+
+    int notifDescr = -1; //inotify or fanotify group
+    bool useFanotify = false;
+
+    //---------- inotify ----------
     std::map<int, Zstring> watchDescrs; //watch descriptor and (sub-)directory name (postfixed with separator) -> owned by "notifDescr"
-};
 
+    //add watch for directory + all subdirectories: inotify has no recursive watches
+    void addWatchRecursive(const Zstring& dirPath, std::vector<Entry>* newItems) //throw FileError
+    {
+        const bool initialScan = newItems == nullptr; //initial scan: fail on errors; dynamically added folders: might be gone already
+        if (!addWatch(dirPath, initialScan)) //throw FileError
+            return;
+        //first add watch, then traverse: don't miss items created in between
+
+        std::vector<Zstring> subDirPaths;
+        traverseFolder(dirPath,
+        [&](const FileInfo& fi) { if (newItems) newItems->emplace_back(ACTION_CREATE, fi.fullPath); },
+        [&](const DirInfo&  di) { if (newItems) newItems->emplace_back(ACTION_CREATE, di.fullPath); subDirPaths.push_back(di.fullPath); },
+        [&](const SymlinkInfo& si) { if (newItems) newItems->emplace_back(ACTION_CREATE, si.fullPath); }, //don't traverse into symlinks (analog to windows build)
+        [&](const std::wstring& errorMsg) { if (initialScan) throw FileError(errorMsg); });
+
+        for (const Zstring& subDirPath : subDirPaths)
+            addWatchRecursive(subDirPath, newItems); //throw FileError
+    }
 
-DirWatcher::DirWatcher(const Zstring& dirPath) : //throw FileError
-    baseDirPath(dirPath),
-    pimpl_(std::make_unique<Pimpl>())
-{
-    //get all subdirectories
-    std::vector<Zstring> fullFolderList { baseDirPath };
+    bool addWatch(const Zstring& dirPath, bool failIfMissing) //throw FileError
     {
-        std::function<void (const Zstring& path)> traverse;
+        const int wd = ::inotify_add_watch(notifDescr, dirPath.c_str(), INOTIFY_WATCH_MASK);
+        if (wd == -1)
+        {
+            const ErrorCode ec = getLastError(); //copy before directly/indirectly making other system calls!
+            if (ec == ENOSPC) //fix misleading system message "No space left on device"
+                throw FileError(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(dirPath)),
+                                formatSystemError(L"inotify_add_watch", numberTo<std::wstring>(ec), L"The user limit on the total number of inotify watches was reached or the kernel failed to allocate a needed resource."));
+
+            if (!failIfMissing && (ec == ENOENT || ec == ENOTDIR || ec == EACCES))
+                return false;
+
+            throw FileError(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(dirPath)), formatSystemError(L"inotify_add_watch", ec));
+        }
+
+        watchDescrs[wd] = appendSeparator(dirPath); //same directory => same watch descriptor: update path after move
+        return true;
+    }
+
+    //---------- fanotify ----------
+#ifdef FAN_REPORT_DFID_NAME
+    int mountDescr = -1;      //any file on the monitored file system: required by open_by_handle_at()
+    Zstring baseDirPathRealPf; //canonical base directory path as resolved from file handles, postfixed with separator
+    Zstring baseDirPathPf;     //path to report changes with
+    std::map<std::string, Opt<Zstring>> dirHandleCache; //file handle -> directory path postfixed with separator; NoValue if outside base directory
+
+    //requires CAP_SYS_ADMIN (FAN_MARK_FILESYSTEM) and CAP_DAC_READ_SEARCH (open_by_handle_at())
+    bool initFanotify(const Zstring& dirPath) //throw FileError; return false if not supported => fall back to inotify
+    {
+        char* realPath = ::realpath(dirPath.c_str(), nullptr);
+        if (!realPath)
+            THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(dirPath)), L"realpath");
+        ZEN_ON_SCOPE_EXIT(::free(realPath));
+
+        const int fd = ::fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_NONBLOCK | FAN_CLOEXEC, O_RDONLY);
+        if (fd == -1)
+            return false; //ENOSYS, EINVAL (kernel too old), EPERM (missing privileges)
+        ZEN_ON_SCOPE_FAIL(::close(fd));
+
+        //file system mark: no per-directory watches, no initial traversal; subdirectories created later are covered automatically
+        if (::fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, FANOTIFY_WATCH_MASK, AT_FDCWD, dirPath.c_str()) != 0)
+        {
+            ::close(fd);
+            return false; //EPERM, EXDEV (e.g. btrfs subvolume), ENODEV/EOPNOTSUPP (no file handle support, e.g. network file systems)
+        }
+
+        const int fdMount = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fdMount == -1)
+            THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(dirPath)), L"open");
+        ZEN_ON_SCOPE_FAIL(::close(fdMount));
+
+        notifDescr = fd;
+        mountDescr = fdMount;
+        baseDirPathRealPf = appendSeparator(realPath);
+        baseDirPathPf     = appendSeparator(dirPath);
 
-        traverse = [&traverse, &fullFolderList](const Zstring& path)
+        //probe: can file handles be resolved back to paths as seen by us? (privileges, bind mounts, namespaces)
+        const Opt<Zstring> probePath = [&]() -> Opt<Zstring>
         {
-            traverseFolder(path, nullptr,
-            [&](const DirInfo& di ) { fullFolderList.push_back(di.fullPath); traverse(di.fullPath); },
-            nullptr, //don't traverse into symlinks (analog to windows build)
-            [&](const std::wstring& errorMsg) { throw FileError(errorMsg); });
-        };
+            std::vector<char> buf(sizeof(struct ::file_handle) + MAX_HANDLE_SZ);
+            auto& handle = reinterpret_cast<struct ::file_handle&>(buf[0]);
+            handle.handle_bytes = MAX_HANDLE_SZ;
+            int mountId = 0;
+            if (::name_to_handle_at(AT_FDCWD, dirPath.c_str(), &handle, &mountId, 0) != 0)
+                return NoValue();
+            return resolveDirHandle(handle);
+        }();
+        if (!probePath || *probePath != baseDirPathPf)
+        {
+            ::close(fdMount);
+            ::close(fd);
+            notifDescr = mountDescr = -1;
+            return false;
+        }
+        dirHandleCache.clear();
 
-        traverse(baseDirPath);
+        useFanotify = true;
+        return true;
     }
 
-    //init
-    pimpl_->notifDescr  = ::inotify_init();
+    Opt<Zstring> resolveDirHandle(const struct ::file_handle& handle)
+    {
+        std::string handleKey(reinterpret_cast<const char*>(&handle), sizeof(handle) + handle.handle_bytes);
+
+        auto it = dirHandleCache.find(handleKey);
+        if (it != dirHandleCache.end())
+            return it->second;
+
+        Opt<Zstring> dirPathPf;
+        const int fd = ::open_by_handle_at(mountDescr, reinterpret_cast<struct ::file_handle*>(&handleKey[0]), O_PATH | O_CLOEXEC);
+        if (fd == -1)
+            return NoValue(); //ESTALE: directory deleted meanwhile => don't cache
+        ZEN_ON_SCOPE_EXIT(::close(fd));
+
+        std::vector<char> buf(PATH_MAX + 1);
+        const ssize_t bytesWritten = ::readlink(("/proc/self/fd/" + numberTo<std::string>(fd)).c_str(), &buf[0], buf.size());
+        if (bytesWritten <= 0 || static_cast<size_t>(bytesWritten) >= buf.size())
+            return NoValue();
+
+        const Zstring realPathPf = appendSeparator(Zstring(&buf[0], bytesWritten));
+        if (startsWith(realPathPf, baseDirPathRealPf))
+            dirPathPf = baseDirPathPf + afterFirst(realPathPf, baseDirPathRealPf, IF_MISSING_RETURN_NONE);
+
+        if (dirHandleCache.size() >= FANOTIFY_DIR_CACHE_MAX)
+            dirHandleCache.clear();
+        dirHandleCache.emplace(handleKey, dirPathPf);
+        return dirPathPf;
+    }
+#endif
+};
+
+
+DirWatcher::DirWatcher(const Zstring& dirPath) : //throw FileError
+    baseDirPath(dirPath),
+    pimpl_(std::make_unique<Pimpl>())
+{
+#ifdef FAN_REPORT_DFID_NAME
+    if (pimpl_->initFanotify(baseDirPath)) //throw FileError
+        return;
+#endif
+
+    //fallback: inotify => watch each (sub-)directory separately
+    pimpl_->notifDescr = ::inotify_init();
     if (pimpl_->notifDescr == -1)
         THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(baseDirPath)), L"inotify_init");
 
-    ZEN_ON_SCOPE_FAIL( ::close(pimpl_->notifDescr); );
-
     //set non-blocking mode
     bool initSuccess = false;
     {
@@ -420,38 +578,11 @@ DirWatcher::DirWatcher(const Zstring& dirPath) : //throw FileError
         THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(baseDirPath)), L"fcntl");
 
     //add watches
-    for (const Zstring& subDirPath : fullFolderList)
-    {
-        int wd = ::inotify_add_watch(pimpl_->notifDescr, subDirPath.c_str(),
-                                     IN_ONLYDIR     | //"Only watch pathname if it is a directory."
-                                     IN_DONT_FOLLOW | //don't follow symbolic links
-                                     IN_CREATE      |
-                                     IN_MODIFY      |
-                                     IN_CLOSE_WRITE |
-                                     IN_DELETE      |
-                                     IN_DELETE_SELF |
-                                     IN_MOVED_FROM  |
-                                     IN_MOVED_TO    |
-                                     IN_MOVE_SELF);
-        if (wd == -1)
-        {
-            const ErrorCode ec = getLastError(); //copy before directly/indirectly making other system calls!
-            if (ec == ENOSPC) //fix misleading system message "No space left on device"
-                throw FileError(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(subDirPath)),
-                                formatSystemError(L"inotify_add_watch", numberTo<std::wstring>(ec), L"The user limit on the total number of inotify watches was reached or the kernel failed to allocate a needed resource."));
-
-            throw FileError(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(subDirPath)), formatSystemError(L"inotify_add_watch", ec));
-        }
-
-        pimpl_->watchDescrs.emplace(wd, appendSeparator(subDirPath));
-    }
+    pimpl_->addWatchRecursive(baseDirPath, nullptr); //throw FileError
 }
 
 
-DirWatcher::~DirWatcher()
-{
-    ::close(pimpl_->notifDescr); //associated watches are removed automatically!
-}
+DirWatcher::~DirWatcher() {}
 
 
 std::vector<DirWatcher::Entry> DirWatcher::getChanges(const std::function<void()>&) //throw FileError
@@ -476,12 +607,69 @@ std::vector<DirWatcher::Entry> DirWatcher::getChanges(const std::function<void()
 
     std::vector<Entry> output;
 
+#ifdef FAN_REPORT_DFID_NAME
+    if (pimpl_->useFanotify)
+    {
+        const struct ::fanotify_event_metadata* evt = reinterpret_cast<const struct ::fanotify_event_metadata*>(&buffer[0]);
+        for (ssize_t bytesLeft = bytesRead; FAN_EVENT_OK(evt, bytesLeft); evt = FAN_EVENT_NEXT(evt, bytesLeft))
+        {
+            if (evt->vers != FANOTIFY_METADATA_VERSION)
+                throw FileError(replaceCpy(_("Cannot monitor directory %x."), L"%x", fmtPath(baseDirPath)), L"fanotify: Unexpected metadata version.");
+
+            if (evt->mask & FAN_Q_OVERFLOW) //events were lost: report unspecific change
+            {
+                output.emplace_back(ACTION_UPDATE, baseDirPath);
+                continue;
+            }
+
+            //directory structure changed => cached handle paths might be outdated
+            if ((evt->mask & FAN_ONDIR) && (evt->mask & (FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO)))
+                pimpl_->dirHandleCache.clear(); //drop *before* resolving this event's parent: parent itself was not moved
+
+            for (auto infoPos = reinterpret_cast<const char*>(evt) + evt->metadata_len,
+                 infoEnd = reinterpret_cast<const char*>(evt) + evt->event_len; infoPos < infoEnd;)
+            {
+                const auto& info = reinterpret_cast<const struct ::fanotify_event_info_fid&>(*infoPos);
+                if (info.hdr.len == 0)
+                    break;
+                infoPos += info.hdr.len;
+
+                if (info.hdr.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME) //exclude case: events on "self": FAN_EVENT_INFO_TYPE_DFID
+                {
+                    const auto& handle = reinterpret_cast<const struct ::file_handle&>(info.handle);
+                    const char* itemName = reinterpret_cast<const char*>(handle.f_handle + handle.handle_bytes);
+
+                    if (itemName[0] == '.' && itemName[1] == 0) //event on parent directory itself
+                        continue;
+
+                    if (Opt<Zstring> parentPathPf = pimpl_->resolveDirHandle(handle)) //NoValue: outside base directory or deleted meanwhile
+                    {
+                        const Zstring fullname = *parentPathPf + itemName;
+
+                        if (evt->mask & (FAN_CREATE | FAN_MOVED_TO))
+                            output.emplace_back(ACTION_CREATE, fullname);
+                        else if (evt->mask & (FAN_MODIFY | FAN_CLOSE_WRITE))
+                            output.emplace_back(ACTION_UPDATE, fullname);
+                        else if (evt->mask & (FAN_DELETE | FAN_MOVED_FROM))
+                            output.emplace_back(ACTION_DELETE, fullname);
+                    }
+                }
+            }
+        }
+        return output;
+    }
+#endif
+
     ssize_t bytePos = 0;
     while (bytePos < bytesRead)
     {
         struct ::inotify_event& evt = reinterpret_cast<struct ::inotify_event&>(buffer[bytePos]);
 
-        if (evt.len != 0) //exclude case: deletion of "self", already reported by parent directory watch
+        if (evt.mask & IN_Q_OVERFLOW) //events were lost: report unspecific change
+            output.emplace_back(ACTION_UPDATE, baseDirPath);
+        else if (evt.mask & IN_IGNORED) //watch was removed: directory deleted or file system unmounted
+            pimpl_->watchDescrs.erase(evt.wd);
+        else if (evt.len != 0) //exclude case: deletion of "self", already reported by parent directory watch
         {
             auto it = pimpl_->watchDescrs.find(evt.wd);
             if (it != pimpl_->watchDescrs.end())
@@ -492,7 +680,12 @@ std::vector<DirWatcher::Entry> DirWatcher::getChanges(const std::function<void()
 
                 if ((evt.mask & IN_CREATE) ||
                     (evt.mask & IN_MOVED_TO))
+                {
                     output.emplace_back(ACTION_CREATE, fullname);
+
+                    if (evt.mask & IN_ISDIR) //new directories are not watched automatically; report items created before watch was added
+                        pimpl_->addWatchRecursive(fullname, &output); //throw FileError
+                }
                 else if ((evt.mask & IN_MODIFY) ||
                          (evt.mask & IN_CLOSE_WRITE))
                     output.emplace_back(ACTION_UPDATE, fullname);
@@ -16,7 +16,8 @@
 namespace zen
 {
 //Windows: ReadDirectoryChangesW https://msdn.microsoft.com/en-us/library/aa365465
-//Linux:   inotify               http://linux.die.net/man/7/inotify
+//Linux:   fanotify              http://man7.org/linux/man-pages/man7/fanotify.7.html (Linux 5.9+, requires CAP_SYS_ADMIN + CAP_DAC_READ_SEARCH)
+//         inotify               http://linux.die.net/man/7/inotify (fallback)
 //OS X:    kqueue                http://developer.apple.com/library/mac/documentation/Darwin/Reference/ManPages/man2/kqueue.2.html
 
 //watch directory including subdirectories
@@ -28,7 +29,8 @@ namespace zen
              Renaming of top watched directory handled incorrectly: Not notified(!) + additional changes in subfolders
              now do report FILE_ACTION_MODIFIED for directory (check that should prevent this fails!)
 
-    Linux: newly added subdirectories are reported but not automatically added for watching! -> reset Dirwatcher!
+    Linux: fanotify: marks the complete file system: no per-directory watches and no initial traversal; changes outside the directory are filtered
+           inotify: newly added subdirectories are added for watching by getChanges(); their content found at this time is reported as created
            removal of top watched directory is NOT notified!
 
     OS X: everything works as expected; renaming of top level folder is also detected
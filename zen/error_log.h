@@ -8,11 +8,16 @@
 #define ERROR_LOG_H_8917590832147915
 
 #include <cassert>
+#include <cstdio>
 #include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "time.h"
 #include "i18n.h"
+#include "serialize.h"
 #include "string_base.h"
 
 
@@ -39,22 +44,79 @@ template <class String>
 String formatMessage(const LogEntry& entry);
 
 
+/*
+log entries are stored in segments of fixed size: if the memory limit is exceeded, the oldest segments are moved to a temporary file and read back on demand
+=> think 1 million errors: memory consumption remains bounded
+
+- copies share the temporary file: segments are never modified after they were moved
+- not thread-safe: even read access may update the segment cache
+*/
 class ErrorLog
 {
 public:
+    explicit ErrorLog(size_t memoryLimit = 100000000) : memoryLimit_(memoryLimit) {} //unit: [byte]; use a human-readable number
+
     template <class String> //a wchar_t-based string!
     void logMsg(const String& text, MessageType type);
 
     int getItemCount(int typeFilter = TYPE_INFO | TYPE_WARNING | TYPE_ERROR | TYPE_FATAL_ERROR) const;
 
+    size_t size() const { return itemCount_; }
+    LogEntry getEntry(size_t index) const; //may read from temporary file => iterate sequentially when possible!
+
     //subset of std::vector<> interface:
-    using const_iterator = std::vector<LogEntry>::const_iterator;
-    const_iterator begin() const { return entries.begin(); }
-    const_iterator end  () const { return entries.end  (); }
-    bool empty() const { return entries.empty(); }
+    class const_iterator : public std::iterator<std::input_iterator_tag, LogEntry, std::ptrdiff_t, const LogEntry*, LogEntry>
+    {
+    public:
+        const_iterator(const ErrorLog& log, size_t index) : log_(&log), index_(index) {}
+
+        const_iterator& operator++() { ++index_; return *this; }
+        LogEntry operator*() const { return log_->getEntry(index_); } //returns a copy: cheap because MsgString is ref-counted
+
+        inline friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) { return lhs.index_ == rhs.index_; }
+        inline friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) { return lhs.index_ != rhs.index_; }
+
+    private:
+        const ErrorLog* log_;
+        size_t index_;
+    };
+    const_iterator begin() const { return const_iterator(*this, 0); }
+    const_iterator end  () const { return const_iterator(*this, itemCount_); }
+    bool empty() const { return itemCount_ == 0; }
 
 private:
-    std::vector<LogEntry> entries; //list of non-resolved errors and warnings
+    static const size_t SEGMENT_SIZE = 1000; //number of log entries
+
+    struct Segment
+    {
+        std::vector<LogEntry> entries; //empty if moved to temporary file
+        size_t entryCount  = 0;
+        size_t memoryUsage = 0;        //estimated bytes of "entries"
+        std::int64_t fileOffset = -1;  //-1 if not moved to temporary file
+        size_t fileBytes = 0;
+    };
+
+    class SpillFile;
+
+    void spillSegments();
+    std::vector<LogEntry> loadSegment(const Segment& seg) const;
+
+    size_t memoryLimit_;
+    std::vector<Segment> segments_; //all except the last segment contain SEGMENT_SIZE entries
+    size_t itemCount_   = 0;
+    size_t memoryUsage_ = 0;
+    size_t firstInMemory_ = 0; //segments before have been moved to temporary file
+    bool spillFailed_ = false; //don't retry after error: better use more memory than losing log entries
+
+    int countInfo_       = 0;
+    int countWarning_    = 0;
+    int countError_      = 0;
+    int countFatalError_ = 0;
+
+    std::shared_ptr<SpillFile> spillFile_; //created on demand; shared by copies of this log
+
+    mutable size_t cachedSegment_ = static_cast<size_t>(-1); //index of segment loaded from temporary file
+    mutable std::vector<LogEntry> cachedEntries_;            //
 };
 
 
@@ -66,18 +128,186 @@ private:
 
 
 //######################## implementation ##########################
+class ErrorLog::SpillFile
+{
+public:
+    SpillFile() : handle_(std::tmpfile()) {} //deleted automatically when closed
+
+    ~SpillFile() { if (handle_) std::fclose(handle_); }
+
+    bool append(const ByteArray& data, std::int64_t& fileOffset) //return false on error
+    {
+        std::lock_guard<std::mutex> dummy(lockFile_);
+
+        if (!handle_ || data.empty() || !seek(fileSize_))
+            return false;
+        if (std::fwrite(&*data.begin(), 1, data.size(), handle_) != data.size())
+            return false; //partially written data will be overwritten next time
+
+        fileOffset = fileSize_;
+        fileSize_ += data.size();
+        return true;
+    }
+
+    bool read(std::int64_t fileOffset, ByteArray& data) //return false on error
+    {
+        std::lock_guard<std::mutex> dummy(lockFile_);
+
+        if (!handle_ || data.empty() || !seek(fileOffset)) //caller sets expected size
+            return false;
+        return std::fread(&*data.begin(), 1, data.size(), handle_) == data.size();
+    }
+
+private:
+    SpillFile           (const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    bool seek(std::int64_t offset) //also required when switching between reading and writing!
+    {
+#ifdef ZEN_WIN
+        return ::_fseeki64(handle_, offset, SEEK_SET) == 0;
+#elif defined ZEN_LINUX || defined ZEN_MAC
+        return ::fseeko(handle_, offset, SEEK_SET) == 0;
+#endif
+    }
+
+    std::mutex lockFile_;
+    std::FILE* const handle_;
+    std::int64_t fileSize_ = 0;
+};
+
+
 template <class String> inline
 void ErrorLog::logMsg(const String& text, zen::MessageType type)
 {
+    if (segments_.empty() || segments_.back().entryCount == SEGMENT_SIZE)
+        segments_.emplace_back();
+    Segment& seg = segments_.back();
+
     const LogEntry newEntry = { std::time(nullptr), type, copyStringTo<MsgString>(text) };
-    entries.push_back(newEntry);
+    seg.entries.push_back(newEntry);
+
+    const size_t entryMemory = sizeof(LogEntry) + 2 * sizeof(size_t) + (newEntry.message.size() + 1) * sizeof(wchar_t); //consider Zbase<> header
+    seg.memoryUsage += entryMemory;
+    memoryUsage_    += entryMemory;
+    ++seg.entryCount;
+    ++itemCount_;
+
+    switch (type)
+    {
+        case TYPE_INFO:
+            ++countInfo_;
+            break;
+        case TYPE_WARNING:
+            ++countWarning_;
+            break;
+        case TYPE_ERROR:
+            ++countError_;
+            break;
+        case TYPE_FATAL_ERROR:
+            ++countFatalError_;
+            break;
+    }
+
+    if (memoryUsage_ > memoryLimit_)
+        spillSegments();
+}
+
+
+inline
+void ErrorLog::spillSegments()
+{
+    //move oldest segments first, but never the one currently filled
+    while (memoryUsage_ > memoryLimit_ && !spillFailed_ && firstInMemory_ + 1 < segments_.size())
+    {
+        Segment& seg = segments_[firstInMemory_];
+
+        MemoryStreamOut<ByteArray> streamOut;
+        for (const LogEntry& entry : seg.entries)
+        {
+            writeNumber<std::int64_t>(streamOut, entry.time);
+            writeNumber<std::int32_t>(streamOut, entry.type);
+            writeContainer(streamOut, entry.message); //temporary file is read by this process only => no need for UTF conversion
+        }
+
+        if (!spillFile_)
+            spillFile_ = std::make_shared<SpillFile>();
+
+        if (!spillFile_->append(streamOut.ref(), seg.fileOffset))
+        {
+            spillFailed_ = true;
+            return;
+        }
+        seg.fileBytes = streamOut.ref().size();
+        std::vector<LogEntry>().swap(seg.entries); //release memory
+        memoryUsage_ -= seg.memoryUsage;
+        seg.memoryUsage = 0;
+        ++firstInMemory_;
+    }
+}
+
+
+inline
+std::vector<LogEntry> ErrorLog::loadSegment(const Segment& seg) const
+{
+    std::vector<LogEntry> entries;
+    try
+    {
+        ByteArray buffer;
+        buffer.resize(seg.fileBytes);
+        if (spillFile_->read(seg.fileOffset, buffer))
+        {
+            MemoryStreamIn<ByteArray> streamIn(buffer);
+            for (size_t i = 0; i < seg.entryCount; ++i)
+            {
+                LogEntry entry = {};
+                entry.time    = static_cast<time_t>(readNumber<std::int64_t>(streamIn)); //throw UnexpectedEndOfStreamError
+                entry.type    = static_cast<MessageType>(readNumber<std::int32_t>(streamIn)); //
+                entry.message = readContainer<MsgString>(streamIn); //
+                entries.push_back(entry);
+            }
+        }
+    }
+    catch (UnexpectedEndOfStreamError&) { assert(false); }
+
+    if (entries.size() != seg.entryCount)
+    {
+        assert(false);
+        const LogEntry placeholder = { 0, TYPE_ERROR, L"[...] Cannot read log entry from temporary file." };
+        entries.resize(seg.entryCount, placeholder);
+    }
+    return entries;
+}
+
+
+inline
+LogEntry ErrorLog::getEntry(size_t index) const
+{
+    assert(index < itemCount_);
+    const size_t segIdx = index / SEGMENT_SIZE;
+    const Segment& seg = segments_[segIdx];
+
+    if (seg.fileOffset < 0)
+        return seg.entries[index % SEGMENT_SIZE];
+
+    if (cachedSegment_ != segIdx)
+    {
+        cachedEntries_ = loadSegment(seg);
+        cachedSegment_ = segIdx;
+    }
+    return cachedEntries_[index % SEGMENT_SIZE];
 }
 
 
 inline
 int ErrorLog::getItemCount(int typeFilter) const
 {
-    return static_cast<int>(std::count_if(entries.begin(), entries.end(), [&](const LogEntry& e) { return e.type & typeFilter; }));
+    int itemCount = 0;
+    if (typeFilter & TYPE_INFO       ) itemCount += countInfo_;
+    if (typeFilter & TYPE_WARNING    ) itemCount += countWarning_;
+    if (typeFilter & TYPE_ERROR      ) itemCount += countError_;
+    if (typeFilter & TYPE_FATAL_ERROR) itemCount += countFatalError_;
+    return itemCount;
 }
 
 
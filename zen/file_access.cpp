@@ -8,6 +8,7 @@
 #include <map>
 #include <algorithm>
 #include <stdexcept>
+#include <cstring> //memcmp
 #include "file_traverser.h"
 #include "scope_guard.h"
 #include "symlink_target.h"
@@ -27,6 +28,10 @@
 #elif defined ZEN_LINUX
     #include <sys/vfs.h> //statfs
     #include <sys/time.h> //lutimes
+    #include <sys/ioctl.h>
+    #include <sys/sendfile.h>
+    #include <sys/syscall.h> //copy_file_range: no glibc wrapper before 2.27
+    #include <linux/fs.h> //FICLONE
     #ifdef HAVE_SELINUX
         #include <selinux/selinux.h>
     #endif
@@ -2301,6 +2306,7 @@ InSyncAttributes copyFileWindowsSelectRoutine(const Zstring& sourceFile, const Z
 inline
 InSyncAttributes copyFileOsSpecific(const Zstring& sourceFile,
                                     const Zstring& targetFile,
+                                    bool cloneIfPossible, //not supported: ReFS block cloning requires Windows Server 2016
                                     const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
 {
     try
@@ -2321,8 +2327,71 @@ InSyncAttributes copyFileOsSpecific(const Zstring& sourceFile,
 
 
 #elif defined ZEN_LINUX || defined ZEN_MAC
+#ifdef ZEN_LINUX
+/*
+copy file content without going through user-space buffers: saves two memory copies per byte
+    1. FICLONE:         (opt-in) reflink on btrfs, XFS: data blocks are shared copy-on-write => finishes instantly
+    2. copy_file_range: Linux 4.5; same file system only before Linux 5.3; may use server-side copy for NFS 4.2, CIFS
+    3. sendfile:        any regular file source since Linux 2.6.33
+
+returns false if no data was copied and caller should fall back to unbufferedStreamCopy()
+*/
+bool tryCopyFileContentKernel(FileInput& fileIn, FileOutput& fileOut, //throw FileError, X
+                              const Zstring& sourceFile, const Zstring& targetFile, std::uint64_t fileSize, bool cloneIfPossible,
+                              const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
+{
+    const int fdSource = fileIn .getHandle();
+    const int fdTarget = fileOut.getHandle();
+
+#ifdef FICLONE
+    if (cloneIfPossible)
+        if (::ioctl(fdTarget, FICLONE, fdSource) == 0)
+        {
+            if (notifyProgress) notifyProgress(fileSize); //throw X!
+            return true;
+        }
+    //else: EOPNOTSUPP, EXDEV, EINVAL (e.g. ext4, different file systems) => fall back to copying
+#endif
+
+    auto isNotSupportedError = [](int ec) { return ec == ENOSYS || ec == EXDEV || ec == EINVAL || ec == EOPNOTSUPP; };
+
+    const size_t chunkSize = 4 * 1024 * 1024; //limit progress reporting interval
+    std::uint64_t bytesCopied = 0;
+
+    auto copyLoop = [&](const wchar_t* functionName, const std::function<ssize_t(size_t bytesToCopy)>& copyChunk) -> bool
+    {
+        for (;;)
+        {
+            const ssize_t bytesWritten = copyChunk(chunkSize);
+            if (bytesWritten < 0)
+            {
+                const int ec = errno; //copy before making other system calls!
+                if (bytesCopied == 0 && isNotSupportedError(ec))
+                    return false;
+                throw FileError(replaceCpy(replaceCpy(_("Cannot copy file %x to %y."), L"%x", L"\n" + fmtPath(sourceFile)), L"%y", L"\n" + fmtPath(targetFile)),
+                                formatSystemError(functionName, ec));
+            }
+            if (bytesWritten == 0) //EOF
+                //caveat: some pseudo file systems (procfs, sysfs) report 0 bytes for non-empty files
+                return bytesCopied != 0 || fileSize == 0;
+
+            bytesCopied += bytesWritten;
+            if (notifyProgress) notifyProgress(bytesWritten); //throw X!
+        }
+    };
+
+#ifdef __NR_copy_file_range
+    if (copyLoop(L"copy_file_range", [&](size_t bytesToCopy) { return ::syscall(__NR_copy_file_range, fdSource, nullptr, fdTarget, nullptr, bytesToCopy, 0); })) //throw FileError, X
+        return true;
+#endif
+    return copyLoop(L"sendfile", [&](size_t bytesToCopy) { return ::sendfile(fdTarget, fdSource, nullptr, bytesToCopy); }); //throw FileError, X
+}
+#endif
+
+
 InSyncAttributes copyFileOsSpecific(const Zstring& sourceFile, //throw FileError, ErrorTargetExisting
                                     const Zstring& targetFile,
+                                    bool cloneIfPossible,
                                     const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
 {
     FileInput fileIn(sourceFile); //throw FileError
@@ -2355,7 +2424,10 @@ InSyncAttributes copyFileOsSpecific(const Zstring& sourceFile, //throw FileError
     FileOutput fileOut(fdTarget, targetFile); //pass ownership
     if (notifyProgress) notifyProgress(0); //throw X!
 
-    unbufferedStreamCopy(fileIn, fileOut, notifyProgress); //throw FileError, X
+#ifdef ZEN_LINUX
+    if (!tryCopyFileContentKernel(fileIn, fileOut, sourceFile, targetFile, sourceInfo.st_size, cloneIfPossible, notifyProgress)) //throw FileError, X
+#endif
+        unbufferedStreamCopy(fileIn, fileOut, notifyProgress); //throw FileError, X
 
 #ifdef ZEN_MAC
     //using ::copyfile with COPYFILE_DATA seems to trigger bugs unlike our stream-based copying!
@@ -2406,6 +2478,72 @@ InSyncAttributes copyFileOsSpecific(const Zstring& sourceFile, //throw FileError
     newAttrib.targetFileId     = extractFileId(targetInfo);
     return newAttrib;
 }
+
+
+#ifdef ZEN_LINUX
+/*
+delta copy: read source and existing target block by block, but write only blocks that differ
+    => large files with few changes (VM images, database dumps) cost a read of both files, but only a few writes
+both files are accessible locally: comparing blocks directly is exact and cheaper than rsync-style rolling checksums,
+which only help to find *shifted* data that cannot be reused in-place anyway
+*/
+void copyFileContentDelta(int fdSource, int fdTarget, //throw FileError, X
+                          const Zstring& sourceFile, const Zstring& targetFile,
+                          const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
+{
+    const size_t blockSize = 256 * 1024;
+    std::vector<char> bufSource(blockSize);
+    std::vector<char> bufTarget(blockSize);
+
+    auto readBlock = [](int fd, char* buffer, std::uint64_t offset, const Zstring& filePath) -> size_t //throw FileError
+    {
+        size_t bytesRead = 0;
+        while (bytesRead < blockSize)
+        {
+            const ssize_t rv = ::pread(fd, buffer + bytesRead, blockSize - bytesRead, offset + bytesRead);
+            if (rv < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot read file %x."), L"%x", fmtPath(filePath)), L"pread");
+            }
+            if (rv == 0) //EOF
+                break;
+            bytesRead += rv;
+        }
+        return bytesRead;
+    };
+
+    std::uint64_t offset = 0;
+    for (;;)
+    {
+        const size_t bytesSource = readBlock(fdSource, &bufSource[0], offset, sourceFile); //throw FileError
+        if (bytesSource == 0) //EOF
+            break;
+        const size_t bytesTarget = readBlock(fdTarget, &bufTarget[0], offset, targetFile); //throw FileError
+
+        if (bytesTarget < bytesSource || std::memcmp(&bufSource[0], &bufTarget[0], bytesSource) != 0)
+            for (size_t bytesWritten = 0; bytesWritten < bytesSource;)
+            {
+                const ssize_t rv = ::pwrite(fdTarget, &bufSource[0] + bytesWritten, bytesSource - bytesWritten, offset + bytesWritten);
+                if (rv < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(targetFile)), L"pwrite");
+                }
+                bytesWritten += rv;
+            }
+
+        offset += bytesSource;
+        if (notifyProgress) notifyProgress(bytesSource); //throw X!
+    }
+
+    //remove trailing data if the file has shrunk
+    if (::ftruncate(fdTarget, offset) != 0)
+        THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(targetFile)), L"ftruncate");
+}
+#endif
 #endif
 
 /*
@@ -2423,10 +2561,10 @@ copyFileWindowsDefault(::CopyFileEx)  copyFileWindowsBackupStream(::BackupRead/:
 }
 
 
-InSyncAttributes zen::copyNewFile(const Zstring& sourceFile, const Zstring& targetFile, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+InSyncAttributes zen::copyNewFile(const Zstring& sourceFile, const Zstring& targetFile, bool copyFilePermissions, bool cloneIfPossible, //throw FileError, ErrorTargetExisting, ErrorFileLocked
                                   const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
 {
-    const InSyncAttributes attr = copyFileOsSpecific(sourceFile, targetFile, notifyProgress); //throw FileError, ErrorTargetExisting, ErrorFileLocked
+    const InSyncAttributes attr = copyFileOsSpecific(sourceFile, targetFile, cloneIfPossible, notifyProgress); //throw FileError, ErrorTargetExisting, ErrorFileLocked
 
     //at this point we know we created a new file, so it's fine to delete it for cleanup!
     ZEN_ON_SCOPE_FAIL(try { removeFile(targetFile); }
@@ -2437,3 +2575,97 @@ InSyncAttributes zen::copyNewFile(const Zstring& sourceFile, const Zstring& targ
 
     return attr;
 }
+
+
+Opt<InSyncAttributes> zen::copyFileDelta(const Zstring& sourceFile, const Zstring& baseFile, const Zstring& targetFile, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                                         const std::function<void(std::int64_t bytesDelta)>& notifyProgress)
+{
+#ifdef ZEN_LINUX
+    const bool updateInPlace = baseFile == targetFile;
+
+    FileInput fileIn(sourceFile); //throw FileError, ErrorFileLocked
+    if (notifyProgress) notifyProgress(0); //throw X!
+
+    struct ::stat sourceInfo = {};
+    if (::fstat(fileIn.getHandle(), &sourceInfo) != 0)
+        THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot read file attributes of %x."), L"%x", fmtPath(sourceFile)), L"fstat");
+
+    const int fdBase = ::open(baseFile.c_str(), updateInPlace ? O_RDWR : O_RDONLY);
+    if (fdBase == -1)
+        return NoValue(); //e.g. read-only target: let a regular file copy report the error
+    ZEN_ON_SCOPE_EXIT(::close(fdBase));
+
+    struct ::stat baseInfo = {};
+    if (::fstat(fdBase, &baseInfo) != 0 || !S_ISREG(baseInfo.st_mode))
+        return NoValue();
+
+    if (updateInPlace && baseInfo.st_nlink > 1) //writing to a hard link would modify all other links, too
+        return NoValue();
+
+    int fdTarget = fdBase;
+    std::unique_ptr<FileOutput> fileOut; //only set if !updateInPlace
+
+    if (!updateInPlace) //create new file sharing all data blocks with baseFile: only changed blocks need new space
+    {
+        const mode_t mode = sourceInfo.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+        fdTarget = ::open(targetFile.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+        if (fdTarget == -1)
+        {
+            const int ec = errno; //copy before making other system calls!
+            const std::wstring errorMsg = replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(targetFile));
+            const std::wstring errorDescr = formatSystemError(L"open", ec);
+
+            if (ec == EEXIST)
+                throw ErrorTargetExisting(errorMsg, errorDescr);
+
+            throw FileError(errorMsg, errorDescr);
+        }
+        fileOut = std::make_unique<FileOutput>(fdTarget, targetFile); //pass ownership
+    }
+    //transactional behavior: delete newly created file only! never the base file
+    ZEN_ON_SCOPE_FAIL( if (!updateInPlace) try { removeFile(targetFile); }
+    catch (FileError&) {} );
+
+    if (!updateInPlace)
+    {
+#ifdef FICLONE
+        const bool cloned = ::ioctl(fdTarget, FICLONE, fdBase) == 0;
+#else
+        const bool cloned = false;
+#endif
+        if (!cloned) //EOPNOTSUPP, EXDEV, EINVAL => copying the base file first would be slower than a regular copy
+        {
+            fileOut.reset();
+            removeFile(targetFile); //throw FileError
+            return NoValue();
+        }
+    }
+
+    copyFileContentDelta(fileIn.getHandle(), fdTarget, sourceFile, targetFile, notifyProgress); //throw FileError, X
+
+    struct ::stat targetInfo = {};
+    if (::fstat(fdTarget, &targetInfo) != 0)
+        THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot read file attributes of %x."), L"%x", fmtPath(targetFile)), L"fstat");
+
+    //close output file handle before setting file time: see copyFileOsSpecific()
+    if (fileOut)
+        fileOut->close(); //throw FileError
+    else if (::fsync(fdTarget) != 0) //in-place: fdBase is closed on scope exit => catch write errors here
+        THROW_LAST_FILE_ERROR(replaceCpy(_("Cannot write file %x."), L"%x", fmtPath(targetFile)), L"fsync");
+    if (notifyProgress) notifyProgress(0); //throw X!
+
+    setWriteTimeNative(targetFile, sourceInfo.st_mtim, ProcSymlink::FOLLOW); //throw FileError
+
+    if (copyFilePermissions)
+        copyItemPermissions(sourceFile, targetFile, ProcSymlink::FOLLOW); //throw FileError
+
+    InSyncAttributes newAttrib;
+    newAttrib.fileSize         = sourceInfo.st_size;
+    newAttrib.modificationTime = sourceInfo.st_mtim.tv_sec;
+    newAttrib.sourceFileId     = extractFileId(sourceInfo);
+    newAttrib.targetFileId     = extractFileId(targetInfo);
+    return newAttrib;
+#else
+    return NoValue();
+#endif
+}
@@ -11,6 +11,7 @@
 #include "zstring.h"
 #include "file_error.h"
 #include "file_id_def.h"
+#include "optional.h"
 
 
 namespace zen
@@ -67,8 +68,16 @@ struct InSyncAttributes
 };
 
 InSyncAttributes copyNewFile(const Zstring& sourceFile, const Zstring& targetFile, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                             bool cloneIfPossible, //Linux: create reflink on btrfs, XFS instead of copying file content
                              //accummulated delta != file size! consider ADS, sparse, compressed files
                              const std::function<void(std::int64_t bytesDelta)>& notifyProgress); //may be nullptr; throw X!
+
+//delta copy: write only blocks of the existing file "baseFile" that differ from "sourceFile"
+//- baseFile == targetFile: update in place (not transactional!); not supported if baseFile has further hard links
+//- baseFile != targetFile: create targetFile as reflink of baseFile (Linux: btrfs, XFS), fail if already existing
+//returns NoValue() if not supported: caller should fall back to copyNewFile()
+Opt<InSyncAttributes> copyFileDelta(const Zstring& sourceFile, const Zstring& baseFile, const Zstring& targetFile, bool copyFilePermissions, //throw FileError, ErrorTargetExisting, ErrorFileLocked
+                                    const std::function<void(std::int64_t bytesDelta)>& notifyProgress); //may be nullptr; throw X!
 }
 
 #endif //FILE_ACCESS_H_8017341345614857
@@ -71,6 +71,13 @@ FileId extractFileId(const struct ::stat& fileInfo)
     return fileInfo.st_dev != 0 && fileInfo.st_ino != 0 ?
            FileId(fileInfo.st_dev, fileInfo.st_ino) : FileId();
 }
+
+inline
+FileId extractFileId(dev_t deviceId, ino_t fileIndex)
+{
+    return deviceId != 0 && fileIndex != 0 ?
+           FileId(deviceId, fileIndex) : FileId();
+}
 #endif
 }
 
@@ -9,13 +9,14 @@
 
 #include <cassert>
 #include <iterator>
+#include <memory>
 
 
 namespace zen
 {
 //std::list(C++11)-like class for inplace element construction supporting non-copyable/movable types
 //may be replaced by C++11 std::list when available...or never...
-template <class T>
+template <class T, class Alloc = std::allocator<T>>
 class FixedList
 {
     struct Node
@@ -26,6 +27,8 @@ class FixedList
         Node* next = nullptr; //singly linked list is sufficient
         T val;
     };
+    using NodeAlloc       = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeAllocTraits = std::allocator_traits<NodeAlloc>;
 
 public:
     FixedList() {}
@@ -68,7 +71,20 @@ public:
     const_reference& back() const { return lastInsert->val; }
 
     template <class... Args>
-    void emplace_back(Args&& ... args) { pushNode(new Node(std::forward<Args>(args)...)); }
+    void emplace_back(Args&& ... args)
+    {
+        Node* newNode = NodeAllocTraits::allocate(alloc, 1); //throw std::bad_alloc
+        try
+        {
+            NodeAllocTraits::construct(alloc, newNode, std::forward<Args>(args)...); //throw X
+        }
+        catch (...)
+        {
+            NodeAllocTraits::deallocate(alloc, newNode, 1);
+            throw;
+        }
+        pushNode(newNode);
+    }
 
     template <class Predicate>
     void remove_if(Predicate pred)
@@ -120,6 +136,7 @@ public:
         std::swap(firstInsert, other.firstInsert);
         std::swap(lastInsert , other.lastInsert);
         std::swap(sz         , other.sz);
+        //swapping nodes requires a stateless allocator!
     }
 
 private:
@@ -146,9 +163,11 @@ private:
     {
         assert(sz > 0);
         --sz;
-        delete oldNode;
+        NodeAllocTraits::destroy(alloc, oldNode);
+        NodeAllocTraits::deallocate(alloc, oldNode, 1);
     }
 
+    NodeAlloc alloc;
     Node* firstInsert = nullptr;
     Node* lastInsert  = nullptr; //point to last insertion; required by efficient emplace_back()
     size_t sz = 0;